@@ -67,7 +67,7 @@
  *----------------------------------------------------------*/
 
 #define configUSE_PREEMPTION			1
-#define configUSE_IDLE_HOOK				0
+#define configUSE_IDLE_HOOK				1
 #define configUSE_TICK_HOOK				1
 #if (PART_LM3S2110)
 #define configCPU_CLOCK_HZ				( ( unsigned long ) 25000000 )
@@ -76,10 +76,12 @@
 #endif
 #define configTICK_RATE_HZ				( ( portTickType ) 1000 )
 #define configMINIMAL_STACK_SIZE		( ( unsigned short ) 80 )
+/* The static task stacks (STATIC_STACK_BYTES, config.h) come out of the
+same RAM budget. */
 #if (PART_LM3S2110) /* LM3S2110 only has 16KB of ram */
-#define configTOTAL_HEAP_SIZE			( ( size_t ) ( 8192 ) )
+#define configTOTAL_HEAP_SIZE			( ( size_t ) ( 8192 - STATIC_STACK_BYTES ) )
 #else
-#define configTOTAL_HEAP_SIZE			( ( size_t ) ( 32000 ) )
+#define configTOTAL_HEAP_SIZE			( ( size_t ) ( 32000 - STATIC_STACK_BYTES ) )
 #endif
 #define configMAX_TASK_NAME_LEN			( 12 )
 #define configUSE_TRACE_FACILITY		1
@@ -107,6 +109,7 @@ to exclude the API function. */
 #define INCLUDE_vTaskDelayUntil				1
 #define INCLUDE_vTaskDelay					1
 #define INCLUDE_uxTaskGetStackHighWaterMark	1
+#define INCLUDE_xTaskGetCurrentTaskHandle	1
 
 
 
@@ -122,10 +125,31 @@ to exclude the API function. */
 */
 #define SET_SYSCALL_INTERRUPT_PRIORITY(X) (((X) << 5)&0xE0)
 
-extern volatile unsigned long ulHighFrequencyTimerTicks;
-/* There is already a high frequency timer running - just reset its count back
-to zero. */
-#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() ( ulHighFrequencyTimerTicks = 0UL )
-#define portGET_RUN_TIME_COUNTER_VALUE()	ulHighFrequencyTimerTicks
+/* The run time stats are timed by free running timer 1 (timertest.c), no
+interrupt is used. */
+extern void vConfigureRunTimeCounter( void );
+extern unsigned long ulGetRunTimeCounterValue( void );
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() vConfigureRunTimeCounter()
+#define portGET_RUN_TIME_COUNTER_VALUE()	ulGetRunTimeCounterValue()
+
+/*
+ * Task statistics (taskstats.c): tell it where the kernel keeps the
+ * per-task numbers, since this version has no uxTaskGetSystemState().
+ * These expand inside tasks.c.
+ */
+extern void task_stats_create(void *tcb, const signed char *name,
+	unsigned long *priority, unsigned long *runtime,
+	void **generic, void **event, unsigned long *wake,
+	void *ready_lists, void *suspended_list, void *pending_list);
+extern void task_stats_delete(void *tcb);
+
+#define traceTASK_CREATE(pxNewTCB)					\
+	task_stats_create((pxNewTCB), (pxNewTCB)->pcTaskName,		\
+		&(pxNewTCB)->uxPriority, &(pxNewTCB)->ulRunTimeCounter,	\
+		&(pxNewTCB)->xGenericListItem.pvContainer,		\
+		&(pxNewTCB)->xEventListItem.pvContainer,		\
+		&(pxNewTCB)->xGenericListItem.xItemValue,		\
+		pxReadyTasksLists, &xSuspendedTaskList, &xPendingReadyList)
+#define traceTASK_DELETE(pxTCB)		task_stats_delete(pxTCB)
 
 #endif /* FREERTOS_CONFIG_H */
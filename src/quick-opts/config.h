@@ -37,16 +37,129 @@
 #define WEB_TASK_PRIORITY		2	/* Web server */
 #define UIP_TASK_PRIORITY		1	/* ethernet / MAC */
 #define UTIL_TASK_PRIORITY		1	/* Utility, including WDT */
+#define BANNER_TASK_PRIORITY		1	/* Deferred boot output */
 #define IDLE_TASK_PRIORITY		0	/* for completeness */
 
 #define DEFAULT_STACK_SIZE		512	/* unless otherwise */
 #define IDLE_STACK_SIZE			120
 #define WEB_STACK_SIZE			512
 
+/*
+ * Task stacks, words.  With STATIC_TASK_STACKS they are static arrays, so
+ * their RAM is known at link time, and the heap is smaller by as much
+ * (configTOTAL_HEAP_SIZE).  Trim them from the stack_min of /supervisor
+ * under load, keeping the free minimum of task_budget (utilwdtcfg.c).
+ * The tasks that delete themselves (eth-init, banner) and the lwIP
+ * tcp-ip thread always have their stacks on the heap.
+ */
+#define STATIC_TASK_STACKS		1
+#define IO_STACK_SIZE			512	/* io_task */
+#define UTIL_STACK_SIZE			512	/* util_task */
+#define ETH_IN_STACK_SIZE		350	/* ethernetif_input, per port */
+#define ETH_LINK_STACK_SIZE		512	/* ethLinkTask, per port */
+
+/*
+ * Ethernet ports, the same default as ETHIsr.h: the eth-in and eth-link
+ * stacks are per port.
+ */
+#ifndef MAX_ETH_PORTS
+#define MAX_ETH_PORTS			(1)
+#endif
+
+/*
+ * Bytes of the static stacks.
+ */
+#if !STATIC_TASK_STACKS
+#define STATIC_STACK_BYTES		0
+#elif (PART == LM3S2110)
+#define STATIC_STACK_BYTES		((IO_STACK_SIZE + UTIL_STACK_SIZE) * 4)
+#else
+#define STATIC_STACK_BYTES		((IO_STACK_SIZE + UTIL_STACK_SIZE + \
+					  (ETH_IN_STACK_SIZE + \
+					   ETH_LINK_STACK_SIZE) * \
+					  MAX_ETH_PORTS) * 4)
+#endif
+
+/*
+ * FreeRTOS heap (heap_quick.c): blocks up to this size, header included,
+ * are kept on quick lists of their exact size when freed.
+ */
+#define HEAP_QUICK_MAX			128
+
+/*
+ * Task statistics (taskstats.c).
+ */
+#if (PART == LM3S2110)
+#define TASK_STATS_MAX			8	/* tasks reported */
+#else
+#define TASK_STATS_MAX			12	/* tasks reported */
+#endif
+#define TASK_STATS_WINDOW_MS		1000	/* CPU usage window */
+
+/*
+ * Sleep (WFI) in the idle task until the next interrupt.
+ */
+#define IDLE_SLEEP			1
+
+/*
+ * Stop the RTOS tick while the idle task sleeps, until the first delayed
+ * task is due (tickless.c).  Needs IDLE_SLEEP.
+ */
+#define TICKLESS_IDLE			1
+
 /*
  * Stellaris built-in reference.
  */
 #define VREF 		3000	/* millivolts */
 
+/*
+ * Latency histograms (latency.c): the ISR entry probe rate and its
+ * hardware priority (below the maximum syscall priority so the kernel's
+ * critical sections show up).  The probe is off unless started by
+ * /latency?probe=secs, for LATENCY_PROBE_SECS if none are given, or
+ * LATENCY_PROBE_BOOT is 1 to run it from boot and never stop.
+ */
+#define LATENCY_PROBE_HZ	1000
+#define LATENCY_PROBE_PRIORITY	2
+#define LATENCY_PROBE_SECS	60
+#define LATENCY_PROBE_BOOT	0
+
+/*
+ * I/O scan rate (io_task()).
+ */
+#define IO_POLL_HZ		10
+
+/*
+ * A/D waveform capture.  The sample buffer is shared by all captured
+ * channels (sets = ADC_CAP_SAMPLES / channels), 2 bytes per sample.
+ */
+#define ADC_CAP_SAMPLES		2048	/* samples in the capture ring */
+#define ADC_CAP_MAX_RATE	50000	/* sets/sec, ISR limited */
+#define ADC_CAP_PREFIX_SIZE	160	/* room for the HTTP header */
+#define ADC_CAP_UDP_CHUNK	1024	/* payload bytes per datagram */
+
+/*
+ * Discrete input change events.
+ */
+#define DIO_DEBOUNCE_MS		20	/* button lockout after an edge */
+#define DIO_EVENT_QUEUE_LEN	16	/* events buffered for consumers */
+
+/*
+ * I/O history (history.c), 16 byte blocks of 1 to 12 samples per point.
+ * Tier 0 is every scan, tier 1 averages HIST_T1_DECIMATE tier 0
+ * samples, tier 2 averages HIST_T2_DECIMATE tier 1 samples.
+ */
+#define HIST_T1_DECIMATE	10	/* 1 Hz at IO_POLL_HZ 10 */
+#define HIST_T2_DECIMATE	60	/* 1/min */
+#if (PART == LM3S9B96)
+#define HIST_T0_BLOCKS		50	/* >= 60 s if it compresses */
+#define HIST_T1_BLOCKS		300	/* >= 1 h if it compresses */
+#define HIST_T2_BLOCKS		120	/* >= 24 h if it compresses */
+#else
+#define HIST_T0_BLOCKS		25	/* 2.5 to 30 s */
+#define HIST_T1_BLOCKS		50	/* 50 s to 10 min */
+#define HIST_T2_BLOCKS		60	/* 1 to 12 h */
+#endif
+
 #endif /* CONFIG_H_ */
 /** \} */
@@ -0,0 +1,73 @@
+/**
+ * \file kvcfg-schema.h
+ *
+ * The user configuration schema: every key/value setting with its type,
+ * default and valid range (see kvcfg.h).
+ *
+ * \addtogroup util Utilities
+ * \{
+ *
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#ifndef KVCFG_SCHEMA_H_
+#define KVCFG_SCHEMA_H_
+
+#include "config.h"
+#include "LWIPStack.h"
+
+/*
+ * Default value helpers.
+ */
+#define KV_IP4(a, b, c, d)	{ (a), (b), (c), (d) }
+#define KV_CAL_LINEAR(c0, c1)	{ .type = adcCalLinear, .coef = {(c0), (c1), 0} }
+
+/*
+ * Processor A/D inputs: engineering units are millivolts,
+ * c1 = VREF / 1024 in Q16.
+ *
+ * Temperature sensor: SENSOR = 2.7 - ((T + 55) / 75)
+ * T = ((2.7 - SENSOR) * 75) - 55
+ *   = 147.5 - counts * (3.0 / 1024) * 75
+ * in millidegrees: 147500 - 219.7265625 * counts
+ * c1 = -219.7265625 * 65536 = -14400000 (exact)
+ */
+#define KV_ADC_CAL_DEFAULT {			\
+	KV_CAL_LINEAR(0, VREF * 64),		\
+	KV_CAL_LINEAR(0, VREF * 64),		\
+	KV_CAL_LINEAR(0, VREF * 64),		\
+	KV_CAL_LINEAR(0, VREF * 64),		\
+	KV_CAL_LINEAR(147500, -14400000) }
+
+/**
+ * The settings: X(id, type, name, size, default, min, max)
+ * - id: the key in flash, 1 .. KVCFG_KEYS_MAX - 1.  Never change or
+ *   reuse the id of a released setting: a new layout needs a new id.
+ * - type: str (size is the buffer size), u32 (min .. max), ip4 or cal
+ *   (struct adc_cal_s[ADC_CAL_CHANNELS]).
+ * - default: an initializer of the type.
+ *
+ * New settings are simply added: until one is saved, it has its default.
+ *
+ * \req \req_config The \program \shall use default configuration values
+ *   if they have not been set previously.
+ */
+#define KVCFG_SCHEMA(X)							\
+	X(1,  str, assy_pn,     64,  "8A7W5 100xxx-001 Rev x1", 0, 0)	\
+	X(2,  str, assy_sn,     64,  "2011mmdd001", 0, 0)		\
+	X(3,  u32, ip_mode,     0,   IPADDR_USE_STATIC,			\
+		IPADDR_USE_STATIC, IPADDR_USE_AUTOIP)			\
+	X(4,  ip4, ip,          0,   KV_IP4(192, 168, 1, 100), 0, 0)	\
+	X(5,  ip4, netmask,     0,   KV_IP4(255, 255, 255, 0), 0, 0)	\
+	X(6,  ip4, gateway,     0,   KV_IP4(192, 168, 1, 1), 0, 0)	\
+	X(7,  str, notes,       256, "", 0, 0)				\
+	X(8,  cal, adc_cal,     0,   KV_ADC_CAL_DEFAULT, 0, 0)		\
+	X(9,  ip4, syslog_ip,   0,   KV_IP4(192, 168, 8, 173), 0, 0)	\
+	X(10, u32, syslog_port, 0,   6719, 1, 65535)
+
+#endif /* KVCFG_SCHEMA_H_ */
+/** \} */
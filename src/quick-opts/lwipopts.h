@@ -140,6 +140,26 @@
  */
 #define MEM_SIZE                        (9*1024)
 
+/**
+ * LWIP_RAM_HEAP_POINTER: the heap is defined in memstats.c, which walks it
+ * for the largest free block.  The pools and the heap are sized from the
+ * high water marks of /mem_stats (mem.shtml).
+ */
+#define LWIP_RAM_HEAP_POINTER           lwip_ram_heap
+extern unsigned char lwip_ram_heap[];
+
+/**
+ * MEMCPY: the pbuf copies (pbuf_copy(), pbuf_take(), pbuf_copy_partial())
+ * use the word / burst copy of fastmem.c.  SMEMCPY, the copies of a
+ * constant size, is left to the compiler, which expands them inline.
+ * liblwip.a must be rebuilt for this to take.  The prototype is declared
+ * here rather than taken from fastmem.h, which liblwip.a's include path
+ * needn't have.
+ */
+#include <stddef.h>
+void *fast_memcpy(void *dst, const void *src, size_t len);
+#define MEMCPY(dst,src,len)             fast_memcpy(dst,src,len)
+
 /*
    ------------------------------------------------
    ---------- Internal Memory Pool Sizes ----------
@@ -258,9 +278,22 @@
    ----------------------------------------
 */
 /**
- * LWIP_STATS==1: Enable statistics collection in lwip_stats.
+ * LWIP_STATS==1: Enable statistics collection in lwip_stats.  Only the
+ * ones reported by /net_stats and /mem_stats (httpd-cgi.c) are kept.
  */
-#define LWIP_STATS                      0
+#define LWIP_STATS                      1
+#define LWIP_STATS_DISPLAY              0
+#define LINK_STATS                      1
+#define ETHARP_STATS                    1
+#define IP_STATS                        1
+#define UDP_STATS                       1
+#define TCP_STATS                       1
+#define MEM_STATS                       1
+#define MEMP_STATS                      1
+#define IPFRAG_STATS                    0
+#define ICMP_STATS                      0
+#define IGMP_STATS                      0
+#define SYS_STATS                       0
 
 /*
    ----------------------------------
@@ -272,6 +305,12 @@
  */
 #define LWIP_DHCP                       1
 
+/**
+ * LWIP_NETIF_STATUS_CALLBACK==1: Tell us when the address is bound
+ * rather than polling for it.
+ */
+#define LWIP_NETIF_STATUS_CALLBACK      1
+
 
 #define LWIP_PROVIDE_ERRNO				0
 
@@ -1,15 +0,0 @@
-/*
- * partnum-initial.h
- *
- *  Created on: Nov 14, 2011
- *      Author: cri_user
- */
-
-#ifndef PARTNUMINITIAL_H_
-#define PARTNUMINITIAL_H_
-
-#include "partnum.h"
-
-extern struct usercfg_s default_usercfg;
-
-#endif /* PARTNUMINITIAL_H_ */
@@ -24,4 +24,28 @@
 #define ERASE_PERMCFG 0
 #endif
 
+/*
+ * make TIMER_JITTER_TEST="-D TIMER_JITTER_TEST=1" runs the 20KHz timer 0
+ * interrupt jitter test (timertest.c).
+ */
+#ifndef TIMER_JITTER_TEST
+#define TIMER_JITTER_TEST 0
+#endif
+
+/*
+ * make PROFILE=release builds with RELEASE=1: link time optimization,
+ * unused sections dropped and real inline.  The image is optimized for
+ * size, except for the hot path functions (the Ethernet driver FIFO
+ * copies and the web server's send loop), marked HOT_PATH.
+ */
+#ifndef RELEASE
+#define RELEASE 0
+#endif
+
+#if RELEASE
+#define HOT_PATH __attribute__((hot, optimize("O2")))
+#else
+#define HOT_PATH
+#endif
+
 #endif /* QUICKSTARTOPTS_H_ */
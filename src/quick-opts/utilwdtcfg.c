@@ -14,3 +14,27 @@ int wdt_limit[wdt_last] = {
 	1000,		/**< io_task: 10 Hz */
 	1000,		/**< util_task: 100 Hz */
 };
+
+/**
+ * Names of the things we are monitoring, for reports.
+ */
+const char *wdt_name[wdt_last] = {
+	"io",
+	"util",
+};
+
+/**
+ * CPU and stack budgets.  A task that uses more CPU in a window
+ * (TASK_STATS_WINDOW_MS), or whose free stack drops below the minimum,
+ * is reported long before it would starve the watchdog.  The last entry
+ * applies to any task not listed.
+ */
+const struct task_budget_s task_budget[] = {
+	{ "io",		2000,	64 },	/**< 20%, io_task */
+	{ "util",	500,	64 },	/**< 5%, util_task */
+	{ "tcp-ip",	5000,	128 },	/**< 50%, lwIP and the web server */
+	{ "eth-in",	3000,	64 },	/**< 30%, Ethernet receive */
+	{ "eth-link",	500,	64 },	/**< 5%, PHY events */
+	{ "IDLE",	10000,	16 },	/**< no limit */
+	{ NULL,		5000,	32 },	/**< anything else */
+};
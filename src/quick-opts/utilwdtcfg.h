@@ -9,6 +9,18 @@
 #define __UTILWDTCFG_H__
 
 extern int wdt_limit[];
+extern const char *wdt_name[];
+
+/**
+ * CPU and stack budget of a task, checked by the utility task.
+ */
+struct task_budget_s {
+	const char *name;	/**< Task name, NULL: any other task */
+	unsigned short cpu_max;	/**< Max CPU in a window, 0.01% */
+	unsigned short stack_min; /**< Min free stack, words */
+};
+
+extern const struct task_budget_s task_budget[];
 
 /**
  * Things we are monitoring.
@@ -4,6 +4,8 @@
 //
 //*****************************************************************************
 
+#include <string.h>
+
 #include "FreeRTOS.h"
 #include "task.h"
 #include "queue.h"
@@ -22,6 +24,7 @@
 
 #include "ETHIsr.h"
 #include "LWIPStack.h"
+#include "latency.h"
 
 #include "logger.h"
 #include "partnum.h"
@@ -35,61 +38,90 @@
 //*****************************************************************************
 volatile unsigned long ETHDevice[MAX_ETH_PORTS];
 
+//*****************************************************************************
+//
+// The resources of the second controller.  None of the parts here has
+// one: a board that does (or the host test) defines SYSCTL_PERIPH_ETH1,
+// ETH1_GPIO_PERIPH, ETH1_BASE, ETH1_GPIO_BASE, ETH1_GPIO_PINS and INT_ETH1,
+// and puts ETH1IntHandler() into its vector.
+//
+//*****************************************************************************
+#if MAX_ETH_PORTS > 2
+#error "ETHIsr.c: only two ethernet ports are supported"
+#elif MAX_ETH_PORTS > 1
+#define ETH1(x)		, x
+#else
+#define ETH1(x)
+#endif
+
 //*****************************************************************************
 //
 //! Ethernet peripheral identification.
 //
 //*****************************************************************************
-static const unsigned long ETHPeripheral[MAX_ETH_PORTS] ={ SYSCTL_PERIPH_ETH, };
+static const unsigned long ETHPeripheral[MAX_ETH_PORTS] ={ SYSCTL_PERIPH_ETH ETH1(SYSCTL_PERIPH_ETH1) };
 
 //*****************************************************************************
 //
 //! Ethernet peripheral pin gate.
 //
 //*****************************************************************************
-static const unsigned long ETHPeripheralGate[MAX_ETH_PORTS] ={ SYSCTL_PERIPH_GPIOF, };
+static const unsigned long ETHPeripheralGate[MAX_ETH_PORTS] ={ SYSCTL_PERIPH_GPIOF ETH1(ETH1_GPIO_PERIPH) };
 
 //*****************************************************************************
 //
 //! The base address for the Ethernet associated with a port.
 //
 //*****************************************************************************
-static const unsigned long ETHBase[MAX_ETH_PORTS] ={ ETH_BASE, };
+static const unsigned long ETHBase[MAX_ETH_PORTS] ={ ETH_BASE ETH1(ETH1_BASE) };
 
 //*****************************************************************************
 //
 //! The port address for the ETH associated pins.
 //
 //*****************************************************************************
-static const unsigned long ETHPortBase[MAX_ETH_PORTS] ={ GPIO_PORTF_BASE, };
+static const unsigned long ETHPortBase[MAX_ETH_PORTS] ={ GPIO_PORTF_BASE ETH1(ETH1_GPIO_BASE) };
 
 //*****************************************************************************
 //
 //! The pins associated with ETH peripheral.
 //
 //*****************************************************************************
-static const unsigned long ETHPins[MAX_ETH_PORTS] ={GPIO_PIN_2 | GPIO_PIN_3, };
+static const unsigned long ETHPins[MAX_ETH_PORTS] ={ GPIO_PIN_2 | GPIO_PIN_3 ETH1(ETH1_GPIO_PINS) };
 
 //*****************************************************************************
 //
 //! The interrupt for the ETH associated with a port.
 //
 //*****************************************************************************
-static const unsigned long ETHInterrupt[MAX_ETH_PORTS] ={ INT_ETH, };
+static const unsigned long ETHInterrupt[MAX_ETH_PORTS] ={ INT_ETH ETH1(INT_ETH1) };
 
 //*****************************************************************************
 //
-// Informs service task about RX event from interrupt routine
+// Events from the interrupt routine, one word per port.  The ISR sets
+// them, the tasks take them in ETHServiceTaskWaitEvent().
 //
 //*****************************************************************************
-xSemaphoreHandle ETHRxBinSemaphore [MAX_ETH_PORTS] ={ [0 ... (MAX_ETH_PORTS - 1)] = NULL };
+volatile unsigned long ETHEvents[MAX_ETH_PORTS];
 
 //*****************************************************************************
 //
-// Informs service task about TX event from interrupt routine
+// The events each waiter takes.
 //
 //*****************************************************************************
-xSemaphoreHandle ETHTxBinSemaphore [MAX_ETH_PORTS] ={ [0 ... (MAX_ETH_PORTS - 1)] = NULL };
+static const unsigned long ETHWaitEvents[ethWaitInvalid] = {
+	[ethWaitRx] = ETH_EV_RX | ETH_EV_RXOF,
+	[ethWaitTx] = ETH_EV_TX | ETH_EV_TXER,
+	[ethWaitPhy] = ETH_EV_PHY,
+};
+
+//*****************************************************************************
+//
+// Wakes each waiter, given by the interrupt routine only when it has set
+// one of the waiter's events.
+//
+//*****************************************************************************
+static xSemaphoreHandle ETHWaitSemaphore[MAX_ETH_PORTS][ethWaitInvalid];
 
 //*****************************************************************************
 //
@@ -107,82 +139,129 @@ xSemaphoreHandle ETHRxAccessMutex[MAX_ETH_PORTS] ={ [0 ... (MAX_ETH_PORTS - 1)]
 
 //*****************************************************************************
 //
-//! Handles the ETH interrupt. 
-//! Put it into the interrupt vector of Stellaris
+//! Handles the ETH interrupt of a port.
 //!
 //! This function is called when either of the ETH generate an interrupt.
 //! An interrupt will be generated when data is received, transmitted, rx overflow
 //! becomes or on link status change.
 //!
+//! \param ulPort is the Ethernet port number that interrupted.
+//!
 //! \return None.
 //
 //*****************************************************************************
-void ETH0IntHandler(void)
+static void ETHIntHandler(const unsigned long ulPort)
 {
-	static portBASE_TYPE xHigherPriorityTaskWoken;
-
+	const unsigned long ulBase = ETHBase[ulPort];
+	portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
 	unsigned long ulStatus;
+	unsigned long ulEvents = 0;
+	int waiter;
 
 	// Read and Clear the interrupt.
-	ulStatus = EthernetIntStatus(ETHBase[0], false);
-	EthernetIntClear(ETHBase[0], ulStatus);
+	ulStatus = EthernetIntStatus(ulBase, false);
+	EthernetIntClear(ulBase, ulStatus);
 
 	// See if RX event occured.
 	if (ulStatus & ETH_INT_RX)
 	{
-		// Disable Ethernet RX Interrupt.
-		EthernetIntDisable(ETH_BASE, ETH_INT_RX);
-
-		HWREGBITW(&ETHDevice[0], ETH_ERROR) = 0;
-		xSemaphoreGiveFromISR(ETHRxBinSemaphore[0], &xHigherPriorityTaskWoken);
+		// Disable Ethernet RX Interrupt, ethernetif_input enables it
+		// again when it has emptied the FIFO.
+		EthernetIntDisable(ulBase, ETH_INT_RX);
+		latency_eth_isr();
+		ulEvents |= ETH_EV_RX;
 	}
 
 	// See if TXERR event occured.
 	if (ulStatus & ETH_INT_TXER)
-	{
-		HWREGBITW(&ETHDevice[0], ETH_ERROR) = 1;
-		HWREGBITW(&ETHDevice[0], ETH_TXERROR) = 1;
-		xHigherPriorityTaskWoken = 0;
-	}
+		ulEvents |= ETH_EV_TXER;
 
 	// See if TX event occured.
 	if (ulStatus & ETH_INT_TX)
-	{
-		HWREGBITW(&ETHDevice[0], ETH_ERROR) = 0;
-		xSemaphoreGiveFromISR(ETHTxBinSemaphore[0], &xHigherPriorityTaskWoken);
-	}
+		ulEvents |= ETH_EV_TX;
 
 	// See if RX overflow event occured.
 	if (ulStatus & ETH_INT_RXOF)
-	{
-		// Set error and flag
-		HWREGBITW(&ETHDevice[0], ETH_ERROR) = 1;
-		HWREGBITW(&ETHDevice[0], ETH_OVERFLOW) = 1;
-
-		xSemaphoreGiveFromISR(ETHRxBinSemaphore[0], &xHigherPriorityTaskWoken);
-	}
+		ulEvents |= ETH_EV_RXOF;
 
 	// See if PHY event occured.
 	if (ulStatus & ETH_INT_PHY)
 	{
-		EthernetIntDisable(ETH_BASE, ETH_INT_PHY);
-
 		/*
-		 * Since we are only monitoring the phy interrupts for link
-		 * down and autonegotiation complete, the link is not up when
-		 * they trigger.
+		 * The PHY is read over MII, too slow for here: the link task
+		 * reads it and enables the interrupt again.
 		 */
-		HWREGBITW(&ETHDevice[0], ETH_ERROR) = 0;
-		HWREGBITW(&ETHDevice[0], ETH_LINK_OK) = 0;
-
-		xTaskResumeFromISR(ethLink_task_handle);
+		EthernetIntDisable(ulBase, ETH_INT_PHY);
+		ulEvents |= ETH_EV_PHY;
+	}
 
-		// no need immediately to switch context
-		xHigherPriorityTaskWoken = 0;
+	/*
+	 * Post the events and wake each waiter with an event once.  The
+	 * semaphores stay given until taken, so no wakeup is lost.
+	 */
+	ETHEvents[ulPort] |= ulEvents;
+	for (waiter = 0; waiter < ethWaitInvalid; waiter++)
+	{
+		if (ulEvents & ETHWaitEvents[waiter])
+			xSemaphoreGiveFromISR(ETHWaitSemaphore[ulPort][waiter],
+					      &xHigherPriorityTaskWoken);
 	}
 	portEND_SWITCHING_ISR(xHigherPriorityTaskWoken);
 }
 
+//*****************************************************************************
+//
+//! Handles the ETH0 interrupt.
+//! Put it into the interrupt vector of Stellaris
+//!
+//! \return None.
+//
+//*****************************************************************************
+void ETH0IntHandler(void)
+{
+	ETHIntHandler(0);
+}
+
+#if MAX_ETH_PORTS > 1
+//*****************************************************************************
+//
+//! Handles the ETH1 interrupt.
+//! Put it into the interrupt vector at INT_ETH1.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void ETH1IntHandler(void)
+{
+	ETHIntHandler(1);
+}
+#endif
+
+//*****************************************************************************
+//
+//! Adds to the device part of a MAC address.
+//!
+//! \param mac is the address.
+//! \param n is the number to add.
+//!
+//! The sum carries into the higher bytes of the device part (the low
+//! three), the OUI is left as it is.
+//!
+//! \return None.
+//
+//*****************************************************************************
+static void ETHMACAddressAdd(unsigned char *mac, unsigned long n)
+{
+	int j;
+
+	for (j = ETH_HWADDR_LEN - 1; (j >= ETH_HWADDR_LEN - 3) && n; j--)
+	{
+		n += mac[j];
+		mac[j] = n & 0xff;
+		n >>= 8;
+	}
+}
+
 //*****************************************************************************
 //
 //! Initializes the ethernet controller and driver.
@@ -195,6 +274,9 @@ void ETH0IntHandler(void)
 //*****************************************************************************
 int ETHServiceTaskInit(const unsigned long ulPort)
 {
+	unsigned char mac[ETH_HWADDR_LEN];
+	int waiter;
+
 	if (ulPort < MAX_ETH_PORTS)
 	{
 		// Check if peripheral is present
@@ -202,8 +284,8 @@ int ETHServiceTaskInit(const unsigned long ulPort)
 			return -1;
 
 		// Initialize semaphores and mutexes.
-		ETHRxBinSemaphore[ulPort] = xSemaphoreCreateCounting( 1, 0 );
-		ETHTxBinSemaphore[ulPort] = xSemaphoreCreateCounting( 1, 0 );
+		for (waiter = 0; waiter < ethWaitInvalid; waiter++)
+			ETHWaitSemaphore[ulPort][waiter] = xSemaphoreCreateCounting( 1, 0 );
 		ETHTxAccessMutex[ulPort] = xSemaphoreCreateMutex();
 		ETHRxAccessMutex[ulPort] = xSemaphoreCreateMutex();
 
@@ -222,9 +304,12 @@ int ETHServiceTaskInit(const unsigned long ulPort)
 		GPIOPinTypeEthernetLED(ETHPortBase[ulPort], ETHPins[ulPort]);
 
 		// Configure the hardware MAC address for Ethernet Controller filtering of
-		// incoming packets.
+		// incoming packets.  The ports have consecutive addresses from
+		// the one in the permanent configuration.
 		//
-		EthernetMACAddrSet(ETHBase[ulPort], &permcfg.mac[0]);
+		memcpy(mac, &permcfg.mac[0], sizeof(mac));
+		ETHMACAddressAdd(mac, ulPort);
+		EthernetMACAddrSet(ETHBase[ulPort], mac);
 
 		// Ethernet controller is a little complicated, all is done in user defined
 		// task(thread), thus no open is needed.
@@ -289,7 +374,7 @@ int ETHServiceTaskFlush(const unsigned long ulPort, const unsigned long flCmd)
 			xSemaphoreTake( ETHTxAccessMutex[ulPort], ( portTickType ) portMAX_DELAY);
 
 			// See if Ethernet is currently transmitting  a frame,
-			while (MAC_TR_NEWTX == HWREG(ETH_BASE + MAC_O_TR))
+			while (MAC_TR_NEWTX == HWREG(ETHBase[ulPort] + MAC_O_TR))
 			{
 				/*
 				 * vTaskDelay() does not provide a good method of controlling the frequency
@@ -384,35 +469,6 @@ int ETHServiceTaskEnable(unsigned long ulPort)
 	}
 	return (-1);
 }
-//!*****************************************************************************
-//!
-//! 
-//! This function is called from low_level_init function in LWIPStack.c
-//!
-//!
-int ETHServiceTaskWaitReady(const unsigned long ulPort)
-{
-
-	if ((ulPort < MAX_ETH_PORTS) && (HWREGBITW(&ETHDevice[ulPort], ETH_ENABLED)))
-	{
-		/*
-		 * Wait for the link to come up.
-		 */
-		while (!(EthernetPHYRead(ETH_BASE, ETH_STATUS_REG) &
-							ETH_PHY_LINK_UP)) {
-			vTaskDelay(50);
-		}
-
-		// set link up flag
-		HWREGBITW(&ETHDevice[ulPort], ETH_LINK_OK) = 1;
-
-		return (0);
-	}
-	HWREGBITW(&ETHDevice[ulPort], ETH_ERROR) = 1;
-	HWREGBITW(&ETHDevice[ulPort], ETH_EBADF) = 1;
-	return (-1);
-}
-
 //*****************************************************************************
 //
 //! Disables transmitting and receiving.
@@ -439,8 +495,9 @@ int ETHServiceTaskDisable(const unsigned long ulPort)
 		// Disable the ETH.
 		EthernetDisable(ETHBase[ulPort]);
 
-		// Clear all flags
+		// Clear all flags and events
 		ETHDevice[ulPort] = 0;
+		ETHEvents[ulPort] = 0;
 
 		return (0);
 	}
@@ -569,3 +626,60 @@ int ETHServiceTaskEnableReceive(const unsigned long ulPort)
 	HWREGBITW(&ETHDevice[ulPort], ETH_EBADF) = 1;
 	return (-1);
 }
+
+//!*****************************************************************************
+//!
+//! Wait for events from the interrupt routine.
+//! This function is called from ethernetif_input, low_level_output and
+//! ethLinkTask in LWIPStack.c
+//!
+//! \param ulPort is the Ethernet port number to be accessed.
+//! \param waiter is the calling task's waiter, which selects the events.
+//! \param xTicks is the longest time to wait.
+//!
+//! The waiter's events that are already set are taken without blocking.
+//!
+//! \return The waiter's events (ETH_EV_*), 0 on a timeout or if an event
+//! was taken before the wakeup.
+//
+//*****************************************************************************
+unsigned long ETHServiceTaskWaitEvent(const unsigned long ulPort,
+		enum eth_waiter waiter, portTickType xTicks)
+{
+	unsigned long ulMask;
+	unsigned long ulEvents;
+
+	if ((ulPort >= MAX_ETH_PORTS) || (waiter >= ethWaitInvalid))
+		return 0;
+
+	ulMask = ETHWaitEvents[waiter];
+	if ((ETHEvents[ulPort] & ulMask) == 0)
+		xSemaphoreTake(ETHWaitSemaphore[ulPort][waiter], xTicks);
+
+	// Take the events, the ISR may be setting others.
+	taskENTER_CRITICAL();
+	ulEvents = ETHEvents[ulPort] & ulMask;
+	ETHEvents[ulPort] &= ~ulMask;
+	taskEXIT_CRITICAL();
+
+	return ulEvents;
+}
+
+//*****************************************************************************
+//
+//! Return the base address of the Ethernet controller of a port.
+//! This function is called from LWIPStack.c
+//!
+//! \param ulPort is the Ethernet port number to be accessed.
+//!
+//! \return The base address or 0 if error.
+//
+//*****************************************************************************
+unsigned long ETHServiceTaskBase(const unsigned long ulPort)
+{
+	if (ulPort < MAX_ETH_PORTS)
+	{
+		return ETHBase[ulPort];
+	}
+	return 0;
+}
@@ -23,10 +23,15 @@ extern "C"
 
 //*****************************************************************************
 //
-//! The number of ethernet ports supported by this module.
+//! The number of ethernet ports supported by this module.  The parts here
+//! have one controller; a board with a second one (or the host test,
+//! test/ethports.c) builds with MAX_ETH_PORTS 2 and defines its resources,
+//! see ETHIsr.c.
 //
 //*****************************************************************************
+#ifndef MAX_ETH_PORTS
 #define MAX_ETH_PORTS			(1)
+#endif
 
 //*****************************************************************************
 //
@@ -66,6 +71,9 @@ extern "C"
 #define ETH_INTAUTONEGCONFIG_BIT	PHY_MR30_ANCOMPIM
 #define ETH_INTLINKDNCONFIG_BIT		PHY_MR30_LDIM
 #define ETH_INTSTATUS_REG		PHY_MR29
+#define ETH_SPEED_REG			31		/* special control/status */
+#define ETH_SPEED_100_BIT		0x0008		/* speed indication 100 */
+#define ETH_SPEED_FULL_BIT		0x0010		/* speed indication full */
 
 #elif (PART == LM3S8962)
 
@@ -75,6 +83,9 @@ extern "C"
 #define ETH_INTAUTONEGCONFIG_BIT	PHY_MR17_ANEGCOMP_IE
 #define ETH_INTLINKDNCONFIG_BIT		PHY_MR17_LSCHG_IE
 #define ETH_INTSTATUS_REG		PHY_MR17
+#define ETH_SPEED_REG			PHY_MR18	/* diagnostic */
+#define ETH_SPEED_100_BIT		PHY_MR18_RATE
+#define ETH_SPEED_FULL_BIT		PHY_MR18_DPLX
 
 #endif
 
@@ -95,6 +106,29 @@ extern "C"
 #define ETH_EBADOPT			0x05
 #define ETH_TXERROR			0x06	
 
+//*****************************************************************************
+//
+//! Event bits for ETHEvents, set by the ISR.
+//
+//*****************************************************************************
+#define ETH_EV_RX			0x01	/* packet received */
+#define ETH_EV_TX			0x02	/* transmitter idle */
+#define ETH_EV_RXOF			0x04	/* receive FIFO overflow */
+#define ETH_EV_TXER			0x08	/* transmit error */
+#define ETH_EV_PHY			0x10	/* PHY interrupt */
+
+//*****************************************************************************
+//
+//! The tasks that wait for events, each waits for its own events.
+//
+//*****************************************************************************
+enum eth_waiter {
+	ethWaitRx,		/* ETH_EV_RX | ETH_EV_RXOF: ethernetif_input */
+	ethWaitTx,		/* ETH_EV_TX | ETH_EV_TXER: low_level_output */
+	ethWaitPhy,		/* ETH_EV_PHY: ethLinkTask */
+	ethWaitInvalid		/* Invalid flag, MUST BE LAST */
+};
+
 //*****************************************************************************
 //
 //! Ethernet FIFO's identifier for flushing.
@@ -110,9 +144,8 @@ extern "C"
 //
 //*****************************************************************************
 extern volatile unsigned long ETHDevice[MAX_ETH_PORTS];
+extern volatile unsigned long ETHEvents[MAX_ETH_PORTS];
 
-extern xSemaphoreHandle ETHRxBinSemaphore[MAX_ETH_PORTS];
-extern xSemaphoreHandle ETHTxBinSemaphore[MAX_ETH_PORTS];
 extern xSemaphoreHandle ETHTxAccessMutex[MAX_ETH_PORTS];
 extern xSemaphoreHandle ETHRxAccessMutex[MAX_ETH_PORTS];
 		
@@ -125,7 +158,9 @@ extern int ETHServiceTaskFlush(const unsigned long ulPort, const unsigned long f
 extern int ETHServiceTaskMACAddress(const unsigned long ulPort, unsigned char *pucMACAddr);
 extern int ETHServiceTaskEnableReceive(const unsigned long ulPort);
 extern int ETHServiceTaskPacketAvail(const unsigned long ulPort);
-extern int ETHServiceTaskWaitReady(const unsigned long ulPort);
+extern unsigned long ETHServiceTaskBase(const unsigned long ulPort);
+extern unsigned long ETHServiceTaskWaitEvent(const unsigned long ulPort,
+		enum eth_waiter waiter, portTickType xTicks);
 
 //*****************************************************************************
 //
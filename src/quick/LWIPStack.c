@@ -58,10 +58,15 @@
 
 #include "ETHIsr.h"
 #include "LWIPStack.h"
+#include "latency.h"
+#include "logger.h"
+#include "timerconfig.h"
+#include "boottime.h"
 #include "fs.h"
 #include "fsdata.h"
 
 #include <httpd-cgi.h>
+#include <quickstart-opts.h>
 
 // Sanity Check:  This interface driver will NOT work if the following defines are incorrect.
 #if (PBUF_LINK_HLEN != 16)
@@ -73,19 +78,120 @@
 
 // Forward declarations.
 static void ethernetif_input(void *pParams);
-static struct pbuf * low_level_input(struct netif *netif);
+static HOT_PATH struct pbuf * low_level_input(struct netif *netif);
 static err_t low_level_output(struct netif *netif, struct pbuf *p);
-static err_t low_level_transmit(struct netif *netif, struct pbuf *p);
+static HOT_PATH err_t low_level_transmit(struct netif *netif, struct pbuf *p);
 static void ethLinkTask(void *pParams);
 
-xTaskHandle ethLink_task_handle;
+xTaskHandle ethLink_task_handle[MAX_ETH_PORTS];
 
 //*****************************************************************************
 //
-// The lwIP network interface structure for the Stellaris Ethernet MAC.
+// The lwIP network interface structures for the Stellaris Ethernet MACs,
+// one per port.  Port 0 is the default interface.
 //
 //*****************************************************************************
-struct netif lwip_netif;
+struct netif lwip_netif[MAX_ETH_PORTS];
+
+//*****************************************************************************
+//
+// The port of each netif, its netif->state.
+//
+//*****************************************************************************
+struct ethport
+{
+	unsigned long port;	// Port number for the ETHServiceTask calls
+	unsigned long base;	// MAC base address
+};
+
+static struct ethport ethports[MAX_ETH_PORTS];
+
+//*****************************************************************************
+//
+// Driver counters, per port.  The receive counters are only written by the
+// port's receive task, the transmit counters with the transmit mutex held.
+//
+//*****************************************************************************
+struct eth_stats_s eth_stats[MAX_ETH_PORTS];
+
+// Reset requests, carried out by the writer of each half so that nothing
+// else stores into a counter while it is being incremented.
+static volatile unsigned char rx_reset_req[MAX_ETH_PORTS];
+static volatile unsigned char tx_reset_req[MAX_ETH_PORTS];
+
+static void rx_stats_clear(struct eth_stats_s *es)
+{
+	es->rx_frames = 0;
+	es->rx_bytes = 0;
+	es->rx_overflow = 0;
+	es->rx_nopbuf = 0;
+}
+
+static void tx_stats_clear(struct eth_stats_s *es)
+{
+	es->tx_frames = 0;
+	es->tx_bytes = 0;
+	es->tx_nolink = 0;
+	es->tx_waits = 0;
+	es->tx_wait_cycles = 0;
+}
+
+//*****************************************************************************
+//
+// The task names, the same on every port: the task budgets (utilwdtcfg.c)
+// are by name, and the tasks find their port from the netif they are given.
+//
+//*****************************************************************************
+#define ETH_IN_TASK_NAME	"eth-in"
+#define ETH_LINK_TASK_NAME	"eth-link"
+
+//*****************************************************************************
+//
+// Per port task stacks, when they are static (STATIC_TASK_STACKS).
+//
+//*****************************************************************************
+#if STATIC_TASK_STACKS
+static portSTACK_TYPE ethInStack[MAX_ETH_PORTS][ETH_IN_STACK_SIZE];
+static portSTACK_TYPE ethLinkStack[MAX_ETH_PORTS][ETH_LINK_STACK_SIZE];
+#define ETH_IN_STACK(port)	(ethInStack[port])
+#define ETH_LINK_STACK(port)	(ethLinkStack[port])
+#else
+#define ETH_IN_STACK(port)	NULL
+#define ETH_LINK_STACK(port)	NULL
+#endif
+
+//*****************************************************************************
+//
+// DHCP restart backoff while waiting for an address.
+//
+//*****************************************************************************
+#define DHCP_RESTART_MIN_MS	16000
+#define DHCP_RESTART_MAX_MS	128000
+
+// Given by the TCP/IP thread when it has initialized.
+static xSemaphoreHandle tcpip_ready;
+
+static void tcpip_init_done(void *arg)
+{
+	xSemaphoreGive(tcpip_ready);
+}
+
+// Given by the status callback when the interface is up with an address.
+static xSemaphoreHandle ip_bound[MAX_ETH_PORTS];
+
+//*****************************************************************************
+//
+// Interface status callback, called by lwIP (with the core locked) when
+// the interface goes up or down or its address changes.
+//
+//*****************************************************************************
+static void lwip_status_callback(struct netif *netif)
+{
+	struct ethport *ep = (struct ethport *)netif->state;
+
+	if (netif_is_up(netif) && !ip_addr_isany(&netif->ip_addr))
+		xSemaphoreGive(ip_bound[ep->port]);
+}
 
 //*****************************************************************************
 //
@@ -100,7 +206,9 @@ struct netif lwip_netif;
 //*****************************************************************************
 static err_t low_level_init(struct netif *netif)
 {
-	ETHServiceTaskDisable(0);
+	struct ethport *ep = (struct ethport *)netif->state;
+
+	ETHServiceTaskDisable(ep->port);
 
 	// set MAC hardware address length
 	netif->hwaddr_len = ETHARP_HWADDR_LEN;
@@ -108,7 +216,7 @@ static err_t low_level_init(struct netif *netif)
 	LWIP_DEBUGF(NETIF_DEBUG, ("low_level_transmit: frame sent\n"));
 
 	// set MAC hardware address
-	ETHServiceTaskMACAddress(0, &(netif->hwaddr[0]));
+	ETHServiceTaskMACAddress(ep->port, &(netif->hwaddr[0]));
 
 	LWIP_DEBUGF(NETIF_DEBUG, ("low_level_init: MAC address is %"X8_F"%"X8_F"%"X8_F"%"X8_F"%"X8_F"%"X8_F"\n",
 					netif->hwaddr[0],netif->hwaddr[1],netif->hwaddr[2],
@@ -124,29 +232,31 @@ static err_t low_level_init(struct netif *netif)
 	netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP;
 
 	/* Create task to handle link status changes */
-	xTaskCreate(ethLinkTask,
-		    (signed char *)"eth-link",
-		    DEFAULT_STACK_SIZE,
-		    NULL,
+	xTaskGenericCreate(ethLinkTask,
+		    (signed char *)ETH_LINK_TASK_NAME,
+		    ETH_LINK_STACK_SIZE,
+		    (void *)netif,
 		    ETH_LINK_TASK_PRIORITY,
-		    &ethLink_task_handle);
+		    &ethLink_task_handle[ep->port],
+		    ETH_LINK_STACK(ep->port),
+		    NULL);
 
 	// Create the task that handles the incoming packets.
-	if (pdPASS == xTaskCreate(ethernetif_input,
-			( signed portCHAR * ) "eth-in",
-			netifINTERFACE_TASK_STACK_SIZE,
+	if (pdPASS == xTaskGenericCreate(ethernetif_input,
+			( signed portCHAR * ) ETH_IN_TASK_NAME,
+			ETH_IN_STACK_SIZE,
 			(void *)netif,
 			netifINTERFACE_TASK_PRIORITY,
+			NULL,
+			ETH_IN_STACK(ep->port),
 			NULL))
 	{
-		ETHServiceTaskEnable(0);
-		LWIP_DEBUGF(NETIF_DEBUG, ("low_level_input: Waiting for Ethernet to become ready\n"));
-		ETHServiceTaskWaitReady(0);
-		EthernetPHYRead(ETH_BASE,ETH_INTSTATUS_REG);
-		EthernetIntClear(ETH_BASE, ETH_INT_PHY);
-		netif->flags |= NETIF_FLAG_LINK_UP;
-		LWIP_DEBUGF(NETIF_DEBUG, ("low_level_init: Ethernet link is up\n"));
-		EthernetIntEnable(ETH_BASE, ETH_INT_PHY);
+		ETHServiceTaskEnable(ep->port);
+
+		/*
+		 * Don't wait for the link: the link task reads the PHY when
+		 * it starts and on every PHY interrupt, and tells lwIP.
+		 */
 
 		return ERR_OK;
 
@@ -171,6 +281,8 @@ static err_t low_level_init(struct netif *netif)
  */
 static struct pbuf * low_level_input(struct netif *netif)
 {
+	struct ethport *ep = (struct ethport *)netif->state;
+	unsigned long base = ep->base;
 	struct pbuf *p, *q;
 	u16_t len;
 	u32_t temp;
@@ -184,14 +296,8 @@ static struct pbuf * low_level_input(struct netif *netif)
 #endif
 
 	/* Check if a packet is available, if not, return NULL packet. */
-	if ((HWREG(ETH_BASE + MAC_O_NP) & MAC_NP_NPR_M) == 0)
+	if ((HWREG(base + MAC_O_NP) & MAC_NP_NPR_M) == 0)
 	{
-		int err = ETHServiceTaskLastError(0);
-		if ((ETH_ERROR & err) && (ETH_OVERFLOW & err))
-		{
-			LWIP_DEBUGF(NETIF_DEBUG, ("low_level_input: Ethernet overflow\n"));
-			LINK_STATS_INC(link.drop);
-		}
 		return (NULL);
 	}
 
@@ -201,7 +307,7 @@ static struct pbuf * low_level_input(struct netif *netif)
 	 * two bytes for the length + the 4 bytes for the FCS.
 	 *
 	 */
-	temp = HWREG(ETH_BASE + MAC_O_DATA);
+	temp = HWREG(base + MAC_O_DATA);
 	len = temp & 0xFFFF;
 
 	/* We allocate a pbuf chain of pbufs from the pool. */
@@ -229,7 +335,7 @@ static struct pbuf * low_level_input(struct netif *netif)
 			 */
 			for (i = 0; i < q->len; i += 4)
 			{
-				*ptr++ = HWREG(ETH_BASE + MAC_O_DATA);
+				*ptr++ = HWREG(base + MAC_O_DATA);
 			}
 
 			/* Link in the next pbuf in the chain. */
@@ -242,6 +348,8 @@ static struct pbuf * low_level_input(struct netif *netif)
 
 		/* Adjust the link statistics */
 		LINK_STATS_INC(link.recv);
+		eth_stats[ep->port].rx_frames++;
+		eth_stats[ep->port].rx_bytes += len - 6;
 
 #if LWIP_PTPD
 		// Place the timestamp in the PBUF
@@ -255,12 +363,13 @@ static struct pbuf * low_level_input(struct netif *netif)
 	{
 		for (i = 4; i < len; i+=4)
 		{
-			temp = HWREG(ETH_BASE + MAC_O_DATA);
+			temp = HWREG(base + MAC_O_DATA);
 		}
 
 		// Adjust the link statistics
 		LINK_STATS_INC(link.memerr);
 		LINK_STATS_INC(link.drop);
+		eth_stats[ep->port].rx_nopbuf++;
 	}
 
 	return (p);
@@ -281,27 +390,43 @@ static struct pbuf * low_level_input(struct netif *netif)
 static void ethernetif_input(void *pParams)
 {
 	struct netif *netif;
-	struct ethernetif *ethernetif;
+	struct ethport *ep;
 	struct pbuf *p;
+	unsigned long events;
 
 	netif = (struct netif*) pParams;
-	ethernetif = netif->state;
+	ep = (struct ethport *)netif->state;
 
 	for (;;)
 	{
 		do
 		{
+			if (rx_reset_req[ep->port])
+			{
+				rx_stats_clear(&eth_stats[ep->port]);
+				rx_reset_req[ep->port] = 0;
+			}
+
 			// move received packet into a new pbuf
 			p = low_level_input(netif);
 
-			if ((p == NULL) && (0 == ETHServiceTaskPacketAvail(0)))
+			if ((p == NULL) && (0 == ETHServiceTaskPacketAvail(ep->port)))
 			{
 				// Actually enables only RX interrupt
-				ETHServiceTaskEnableReceive(0);
+				ETHServiceTaskEnableReceive(ep->port);
 
 				// No packet could be read.  Wait a for an interrupt to tell us
 				// there is more data available.
-				xSemaphoreTake(ETHRxBinSemaphore[0], ( portTickType ) (ETH_BLOCK_TIME_WAITING_FOR_INPUT_MS / portTICK_RATE_MS));
+				events = ETHServiceTaskWaitEvent(ep->port, ethWaitRx,
+					( portTickType ) (ETH_BLOCK_TIME_WAITING_FOR_INPUT_MS / portTICK_RATE_MS));
+				if (events & ETH_EV_RX)
+					latency_eth_wake();
+				if (events & ETH_EV_RXOF)
+				{
+					LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_input: Ethernet overflow\n"));
+					LINK_STATS_INC(link.drop);
+					eth_stats[ep->port].rx_overflow++;
+				}
 			}
 
 		} while (p == NULL);
@@ -318,42 +443,78 @@ static void ethernetif_input(void *pParams)
 }
 
 /*
- * This task will handle interrupts generated by the ethernet phy.  All
- * requests to the phy must be routed through the mac over the internal
- * MII bus, making dealing with the phy a slow process that is not
- * well suited for a real ISR.  Generally, this task runs briefly after
- * a phy interrupt, then suspends itself until the next interrupt.
+ * Tell lwIP about a link change (takes the TCP/IP core lock).
  */
-void ethLinkTask(void *pParams)
+static void link_change(struct netif *netif, int up)
 {
+	static int booted;	/* first link up seen */
+	struct ethport *ep = (struct ethport *)netif->state;
+	unsigned long speed;
 
-	/* Wait for a phy interrupt to un-suspend */
-	vTaskSuspend(NULL);
-	LWIP_DEBUGF(NETIF_DEBUG, ("eth0 ISR: Ethernet link down\n"));
+	HWREGBITW(&ETHDevice[ep->port], ETH_LINK_OK) = up ? 1 : 0;
 
-	while (1) {
+	LOCK_TCPIP_CORE();
+	if (up)
+		netif_set_link_up(netif);
+	else
+		netif_set_link_down(netif);
+	UNLOCK_TCPIP_CORE();
 
-		if (EthernetPHYRead(ETH_BASE, ETH_STATUS_REG) &
-				    ETH_PHY_LINK_UP) {
+	if (!up) {
+		lprintf("eth%d: link down\r\n", (int)ep->port);
+		return;
+	}
 
-			/*
-			 * Read the phy's interrupt register to clear the
-			 * interrupts.
-			 */
-			EthernetPHYRead(ETH_BASE,ETH_INTSTATUS_REG);
+	speed = EthernetPHYRead(ep->base, ETH_SPEED_REG);
+	lprintf("eth%d: link up %s %s duplex\r\n", (int)ep->port,
+		(speed & ETH_SPEED_100_BIT) ? "100" : "10",
+		(speed & ETH_SPEED_FULL_BIT) ? "full" : "half");
+	if (!booted) {
+		boot_mark("link");
+		booted = 1;
+	}
+}
 
-			HWREGBITW(&ETHDevice[0], ETH_LINK_OK) = 1;
-			LWIP_DEBUGF(NETIF_DEBUG, ("eth0 link status: Ethernet link up\n"));
-			EthernetIntClear(ETH_BASE, ETH_INT_PHY);
-			EthernetIntEnable(ETH_BASE, ETH_INT_PHY);
+/*
+ * This task handles the interrupts generated by the ethernet phy.  All
+ * requests to the phy must be routed through the mac over the internal
+ * MII bus, making dealing with the phy a slow process that is not
+ * well suited for a real ISR.  This task reads the phy once when it
+ * starts and after each phy event from the ISR, and reports any change
+ * to lwIP.
+ *
+ * The link bit latches low: if it reads down while we think the link is
+ * up, the link went down since the last read, even if it's up again now.
+ * Reporting the down and then reading it again for the current state
+ * means a flap is never missed.
+ */
+static void ethLinkTask(void *pParams)
+{
+	struct netif *netif = (struct netif *)pParams;
+	struct ethport *ep = (struct ethport *)netif->state;
+	int up;
 
-			/* Wait for a phy interrupt to un-suspend */
-			vTaskSuspend(NULL);
-			LWIP_DEBUGF(NETIF_DEBUG, ("eth0 ISR: Ethernet link down\n"));
+	while (1) {
+		/*
+		 * Read the phy's interrupt register to clear the interrupts,
+		 * then let the next one in: anything after this read
+		 * interrupts again.
+		 */
+		EthernetPHYRead(ep->base, ETH_INTSTATUS_REG);
+		EthernetIntClear(ep->base, ETH_INT_PHY);
+		EthernetIntEnable(ep->base, ETH_INT_PHY);
+
+		up = (EthernetPHYRead(ep->base, ETH_STATUS_REG) &
+		      ETH_PHY_LINK_UP) ? 1 : 0;
+		if (!up && netif_is_link_up(netif)) {
+			link_change(netif, 0);
+			up = (EthernetPHYRead(ep->base, ETH_STATUS_REG) &
+			      ETH_PHY_LINK_UP) ? 1 : 0;
 		}
+		if (up != netif_is_link_up(netif))
+			link_change(netif, up);
 
-		else
-			vTaskDelay(ETH_LINK_TASK_WAIT_MS);
+		ETHServiceTaskWaitEvent(ep->port, ethWaitPhy, portMAX_DELAY);
 	}
 }
 
@@ -373,6 +534,8 @@ void ethLinkTask(void *pParams)
  */
 static err_t low_level_output(struct netif *netif, struct pbuf *p)
 {
+	struct ethport *ep = (struct ethport *)netif->state;
+	unsigned long long cycles;
 	err_t status;
 
 	// Bump the reference count on the pbuf to prevent it from being
@@ -380,10 +543,16 @@ static err_t low_level_output(struct netif *netif, struct pbuf *p)
 	pbuf_ref(p);
 
 	// Prevent from simultaneously writing to ETH TX FIFO
-	xSemaphoreTake(ETHTxAccessMutex[0], ( portTickType ) portMAX_DELAY);
+	xSemaphoreTake(ETHTxAccessMutex[ep->port], ( portTickType ) portMAX_DELAY);
+
+	if (tx_reset_req[ep->port])
+	{
+		tx_stats_clear(&eth_stats[ep->port]);
+		tx_reset_req[ep->port] = 0;
+	}
 
 	// If the transmitter is idle, send the pbuf now.
-	if (((HWREG(ETH_BASE + MAC_O_TR) & MAC_TR_NEWTX) == 0))
+	if (((HWREG(ep->base + MAC_O_TR) & MAC_TR_NEWTX) == 0))
 	{
 		// Send packet via eth controller
 		status = low_level_transmit(netif, p);
@@ -392,20 +561,25 @@ static err_t low_level_output(struct netif *netif, struct pbuf *p)
 	{
 		LWIP_DEBUGF(NETIF_DEBUG, ("low_level_output: Ethernet transmitter busy\n"));
 		// Enable generating transmit interrupt for eth. controller
-		EthernetIntEnable(ETH_BASE, ETH_INT_TX);
+		EthernetIntEnable(ep->base, ETH_INT_TX);
 
-		// Waiting for finishing transmitting from interrupt routine
-		xSemaphoreTake(ETHTxBinSemaphore[0], ( portTickType ) portMAX_DELAY);
+		// Waiting for finishing transmitting from interrupt routine.  The
+		// interrupt is enabled before the check, so it can't be missed.
+		cycles = ullGetRunTimeCycles();
+		while (HWREG(ep->base + MAC_O_TR) & MAC_TR_NEWTX)
+			ETHServiceTaskWaitEvent(ep->port, ethWaitTx, portMAX_DELAY);
+		eth_stats[ep->port].tx_waits++;
+		eth_stats[ep->port].tx_wait_cycles += ullGetRunTimeCycles() - cycles;
 
 		// Send packet via eth controller
 		status = low_level_transmit(netif, p);
 
 		// Disable generating transmit interrupt for eth. controller
-		EthernetIntDisable(ETH_BASE, ETH_INT_TX);
+		EthernetIntDisable(ep->base, ETH_INT_TX);
 	}
 
 	// Release mutex
-	xSemaphoreGive(ETHTxAccessMutex[0]);
+	xSemaphoreGive(ETHTxAccessMutex[ep->port]);
 
 	pbuf_free(p);
 
@@ -428,6 +602,7 @@ static err_t low_level_output(struct netif *netif, struct pbuf *p)
  */
 static err_t low_level_transmit(struct netif *netif, struct pbuf *p)
 {
+	struct ethport *ep = (struct ethport *)netif->state;
 	int iBuf;
 	unsigned char *pucBuf;
 	unsigned long *pulBuf;
@@ -436,18 +611,14 @@ static err_t low_level_transmit(struct netif *netif, struct pbuf *p)
 	unsigned long ulGather;
 	unsigned char *pucGather;
 
-	if (0 == ETHServiceTaskLinkStatus(0))
+	// The link task keeps NETIF_FLAG_LINK_UP up to date.
+	if (0 == ETHServiceTaskLinkStatus(ep->port))
 	{
-		// ~ bitwise negation, all bit except NETIF_FLAG_LINK_UP set to 1 and AND with current flag
-		netif->flags &= ~NETIF_FLAG_LINK_UP;
 		LWIP_DEBUGF(NETIF_DEBUG, ("low_level_transmit: link is down\n"));
 		LINK_STATS_INC(link.err);
+		eth_stats[ep->port].tx_nolink++;
 		return (ERR_IF);
 	}
-	else
-	{
-		netif->flags |= NETIF_FLAG_LINK_UP;
-	}
 
 	/**
 	 * Fill in the first two bytes of the payload data (configured as padding
@@ -490,7 +661,7 @@ static err_t low_level_transmit(struct netif *netif, struct pbuf *p)
 		 */
 		if ((iGather == 0) && (iBuf != 0))
 		{
-			HWREG(ETH_BASE + MAC_O_DATA) = ulGather;
+			HWREG(ep->base + MAC_O_DATA) = ulGather;
 			ulGather = 0;
 		}
 
@@ -504,7 +675,7 @@ static err_t low_level_transmit(struct netif *netif, struct pbuf *p)
 		 */
 		while ((iBuf + 4) <= q->len)
 		{
-			HWREG(ETH_BASE + MAC_O_DATA) = *pulBuf++;
+			HWREG(ep->base + MAC_O_DATA) = *pulBuf++;
 			iBuf += 4;
 		}
 
@@ -524,14 +695,16 @@ static err_t low_level_transmit(struct netif *netif, struct pbuf *p)
 	}
 
 	/* Send any leftover data to the FIFO. */
-	HWREG(ETH_BASE + MAC_O_DATA) = ulGather;
+	HWREG(ep->base + MAC_O_DATA) = ulGather;
 
 	/* Wakeup the transmitter. */
-	HWREG(ETH_BASE + MAC_O_TR) = MAC_TR_NEWTX;
+	HWREG(ep->base + MAC_O_TR) = MAC_TR_NEWTX;
 
 	LWIP_DEBUGF(NETIF_DEBUG, ("low_level_transmit: frame sent\n"));
 
 	LINK_STATS_INC(link.xmit);
+	eth_stats[ep->port].tx_frames++;
+	eth_stats[ep->port].tx_bytes += p->tot_len - ETH_PAD_SIZE;
 
 	return (ERR_OK);
 }
@@ -583,34 +756,34 @@ err_t ethernetif_init(struct netif *netif)
 
 //*****************************************************************************
 //
-//! Initializes the lwIP TCP/IP stack.
-//! Call it from your main to initialize the lwip
+//! Adds an Ethernet port to the lwIP TCP/IP stack and starts getting its
+//! address.  LWIPServiceTaskInit() adds port 0, call this for the others
+//! after ETHServiceTaskInit() for the port.
 //!
-//! \param pucMAC is a pointer to a six byte array containing the MAC
-//! address to be used for the interface.
-//! \param ulIPAddr is the IP address to be used (static).
-//! \param ulNetMask is the network mask to be used (static).
-//! \param ulGWAddr is the Gateway address to be used (static).
-//! \param ulIPMode is the IP Address Mode.  \b IPADDR_USE_STATIC will force
-//! static IP addressing to be used, \b IPADDR_USE_DHCP will force DHCP with
-//! fallback to Link Local (Auto IP), while \b IPADDR_USE_AUTOIP will force
-//! Link Local only.
+//! \param ulPort is the Ethernet port number.
+//! \param ipCfg is the port's address configuration, \b IPADDR_USE_STATIC
+//! will force static IP addressing to be used, \b IPADDR_USE_DHCP will
+//! force DHCP with fallback to Link Local (Auto IP), while
+//! \b IPADDR_USE_AUTOIP will force Link Local only.
 //!
-//! This function performs initialization of the lwIP TCP/IP stack for the
-//! Stellaris Ethernet MAC, including DHCP and/or AutoIP, as configured.
+//! The port's netif is lwip_netif[ulPort].  It doesn't wait for the
+//! address.
 //!
-//! \return None.
+//! \return 0 or -1 if error.
 //
 //*****************************************************************************
-void LWIPServiceTaskInit(IP_CONFIG *ipCfg)
+int LWIPServiceTaskAddPort(const unsigned long ulPort, IP_CONFIG *ipCfg)
 {
 	struct ip_addr ip_addr;
 	struct ip_addr net_mask;
 	struct ip_addr gw_addr;
+	struct netif *netif;
 
 	LWIP_ASSERT("ipCfg != NULL", (ipCfg != NULL));
 
 	// Check the parameters.
+	if (ulPort >= MAX_ETH_PORTS)
+		return -1;
 #if LWIP_DHCP && LWIP_AUTOIP
 	ASSERT((ipCfg->IPMode == IPADDR_USE_STATIC) ||
 			(ipCfg->IPMode == IPADDR_USE_DHCP) ||
@@ -625,14 +798,8 @@ void LWIPServiceTaskInit(IP_CONFIG *ipCfg)
 	ASSERT(ipCfg->IPMode == IPADDR_USE_STATIC)
 #endif
 
-	LWIP_DEBUGF(DHCP_DEBUG, ("----- LWIP_DEBUGF calling tcpip_init -----\n"));
-	// Start the TCP/IP thread & init stuff
-	tcpip_init(NULL, NULL);
-
-	vTaskDelay(100 / portTICK_RATE_MS);
-
 	// Setup the network address values.
-if (ipCfg->IPMode == IPADDR_USE_STATIC)
+	if (ipCfg->IPMode == IPADDR_USE_STATIC)
 	{
 		ip_addr.addr = htonl(ipCfg->IPAddr);
 		net_mask.addr = htonl(ipCfg->NetMask);
@@ -645,22 +812,41 @@ if (ipCfg->IPMode == IPADDR_USE_STATIC)
 		gw_addr.addr = 0;
 	}
 
+	/*
+	 * The status callback tells us when the address is bound, it must
+	 * be there before the interface can come up.
+	 */
+	if (ip_bound[ulPort] == NULL)
+	{
+		vSemaphoreCreateBinary(ip_bound[ulPort]);
+		if (ip_bound[ulPort] == NULL)
+			return -1;
+	}
+	xSemaphoreTake(ip_bound[ulPort], 0);
+
+	ethports[ulPort].port = ulPort;
+	ethports[ulPort].base = ETHServiceTaskBase(ulPort);
+	netif = &lwip_netif[ulPort];
+
 	// Create, configure and add the Ethernet controller interface with
 	// default settings.
 	// WARNING: This must only be run after the OS has been started.
 	// Typically this is the case, however, if not, you must place this
 	// in a post-OS initialization
 	// @SEE http://lwip.wikia.com/wiki/Initialization_using_tcpip.c
-	netif_add(&lwip_netif, &ip_addr, &net_mask, &gw_addr,
-			NULL, ethernetif_init, tcpip_input);
-	netif_set_default(&lwip_netif);
+	if (netif_add(netif, &ip_addr, &net_mask, &gw_addr,
+			&ethports[ulPort], ethernetif_init, tcpip_input) == NULL)
+		return -1;
 
+	netif_set_status_callback(netif, lwip_status_callback);
+
+	LOCK_TCPIP_CORE();
 	// Start DHCP, if enabled.
 #if LWIP_DHCP
 	if (ipCfg->IPMode == IPADDR_USE_DHCP)
 	{
 		LWIP_DEBUGF(DHCP_DEBUG, ("----- Starting DHCP client -----\n"));
-		dhcp_start(&lwip_netif);
+		dhcp_start(netif);
 	}
 #endif
 
@@ -668,34 +854,92 @@ if (ipCfg->IPMode == IPADDR_USE_STATIC)
 #if LWIP_AUTOIP
 	if (ipCfg->IPMode == IPADDR_USE_AUTOIP)
 	{
-		autoip_start(&lwip_netif);
+		autoip_start(netif);
 	}
 #endif
 
 	if (ipCfg->IPMode == IPADDR_USE_STATIC)
 	{
 		// Bring the interface up.
-		netif_set_up(&lwip_netif);
+		netif_set_up(netif);
 	}
+	UNLOCK_TCPIP_CORE();
 
-	vTaskDelay(1000/portTICK_RATE_MS);
+	return 0;
+}
 
-	while (0 == netif_is_up(&lwip_netif))
+//*****************************************************************************
+//
+//! Waits for an Ethernet port to have an address.
+//!
+//! \param ulPort is the Ethernet port number.
+//! \param ipCfg is the port's address configuration.
+//!
+//! lwIP retries the DHCP discover itself with an exponential backoff; if
+//! that still hasn't bound an address, DHCP is restarted, backing off
+//! from DHCP_RESTART_MIN_MS to DHCP_RESTART_MAX_MS.
+//!
+//! \return None.
+//
+//*****************************************************************************
+void LWIPServiceTaskWaitAddress(const unsigned long ulPort, IP_CONFIG *ipCfg)
+{
+	unsigned long wait_ms;
+
+	for (wait_ms = DHCP_RESTART_MIN_MS;
+	     xSemaphoreTake(ip_bound[ulPort], wait_ms / portTICK_RATE_MS) != pdTRUE; )
 	{
-		lstr("<delay 5s>");
-		vTaskDelay(5000/portTICK_RATE_MS);
 #if LWIP_DHCP
 		if (ipCfg->IPMode == IPADDR_USE_DHCP) {
-			if (0 == netif_is_up(&lwip_netif)) {
-				lstr("<dhcp_renew>");
-				dhcp_renew(&lwip_netif);
-			}
+			lstr("<dhcp restart>");
+			LOCK_TCPIP_CORE();
+			dhcp_start(&lwip_netif[ulPort]);
+			UNLOCK_TCPIP_CORE();
+			if (wait_ms < DHCP_RESTART_MAX_MS)
+				wait_ms *= 2;
 		}
 #endif
 	}
+}
 
-	/* Initialize HTTP */
+//*****************************************************************************
+//
+//! Initializes the lwIP TCP/IP stack.
+//! Call it from your main to initialize the lwip
+//!
+//! \param ipCfg is the address configuration of port 0, see
+//! LWIPServiceTaskAddPort().
+//!
+//! This function performs initialization of the lwIP TCP/IP stack and the
+//! HTTP server and adds Ethernet port 0 as the default interface.  It
+//! returns when port 0 has an address.
+//!
+//! \return 0 or -1 if error: out of memory, or port 0 couldn't be added.
+//
+//*****************************************************************************
+int LWIPServiceTaskInit(IP_CONFIG *ipCfg)
+{
+	LWIP_DEBUGF(DHCP_DEBUG, ("----- LWIP_DEBUGF calling tcpip_init -----\n"));
+	// Start the TCP/IP thread & init stuff, and wait until it's done
+	// rather than for a fixed time.
+	vSemaphoreCreateBinary(tcpip_ready);
+	if (tcpip_ready == NULL)
+		return -1;
+	xSemaphoreTake(tcpip_ready, 0);
+	tcpip_init(tcpip_init_done, NULL);
+	xSemaphoreTake(tcpip_ready, portMAX_DELAY);
+	boot_mark("tcpip");
+
+	if (LWIPServiceTaskAddPort(0, ipCfg) != 0)
+		return -1;
+	netif_set_default(&lwip_netif[0]);
+	boot_mark("netif");
 
+	/*
+	 * Start HTTP now: it listens on any address, so it serves as soon
+	 * as the address is bound, on every port.
+	 */
+	LOCK_TCPIP_CORE();
 #ifdef INCLUDE_HTTPD_SSI
 	init_ssi_cgi_handlers();
 #else
@@ -704,6 +948,47 @@ if (ipCfg->IPMode == IPADDR_USE_STATIC)
 #endif
 #endif
 	httpd_init();
+	UNLOCK_TCPIP_CORE();
+	boot_mark("httpd");
+
+	LWIPServiceTaskWaitAddress(0, ipCfg);
+	return 0;
+}
+
+//*****************************************************************************
+//
+//! Clears the driver counters of every port.
+//!
+//! The receive task and the transmit path clear their own counters the next
+//! time they run; until then eth_stats_get() reports them as zero.
+//
+//*****************************************************************************
+void eth_stats_reset(void)
+{
+	int j;
+
+	for (j = 0; j < MAX_ETH_PORTS; j++)
+	{
+		rx_reset_req[j] = 1;
+		tx_reset_req[j] = 1;
+	}
+}
+
+//*****************************************************************************
+//
+//! Copies the driver counters of a port.
+//
+//*****************************************************************************
+void eth_stats_get(const unsigned long ulPort, struct eth_stats_s *es)
+{
+	taskENTER_CRITICAL();
+	*es = eth_stats[ulPort];
+	taskEXIT_CRITICAL();
+
+	if (rx_reset_req[ulPort])
+		rx_stats_clear(es);
+	if (tx_reset_req[ulPort])
+		tx_stats_clear(es);
 }
 
 //*****************************************************************************
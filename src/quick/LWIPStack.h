@@ -5,14 +5,12 @@
 #include <lwip/api.h>
 #include <lwip/netifapi.h>
 
-#define netifINTERFACE_TASK_STACK_SIZE				( 350 )
 #define netifINTERFACE_TASK_PRIORITY				( configMAX_PRIORITIES)
 #define netifBUFFER_WAIT_ATTEMPTS					10
 #define netifBUFFER_WAIT_DELAY						(10 / portTICK_RATE_MS)
 #define IFNAME0 'l'
 #define IFNAME1 'm'
 #define ETH_BLOCK_TIME_WAITING_FOR_INPUT_MS (5000)
-#define ETH_LINK_TASK_WAIT_MS (50)
 #define ETH_LINK_TASK_PRIORITY (2)
 
 typedef struct
@@ -37,17 +35,41 @@ typedef struct
 						   (((c) <<  8) & 0x0000FF00) | \
 						   (((d) <<  0) & 0x000000FF) ) 
 
+//*****************************************************************************
+//
+// Driver counters, per port, in eth_stats[].  Byte counts are the
+// Ethernet frames without the FCS.
+//
+//*****************************************************************************
+struct eth_stats_s
+{
+	unsigned long rx_frames;	// Frames received
+	unsigned long rx_bytes;
+	unsigned long rx_overflow;	// RX FIFO overflows
+	unsigned long rx_nopbuf;	// Frames dropped, no pbuf
+	unsigned long tx_frames;	// Frames sent
+	unsigned long tx_bytes;
+	unsigned long tx_nolink;	// Frames dropped, link down
+	unsigned long tx_waits;		// Waits for the transmitter
+	unsigned long long tx_wait_cycles;	// Time waiting, CPU clocks
+};
+
 //*****************************************************************************
 //
 //! Prototypes for the APIs.
 //
 //*****************************************************************************
-extern struct netif lwip_netif;
+extern struct netif lwip_netif[];	/* one per port, MAX_ETH_PORTS */
+extern struct eth_stats_s eth_stats[];	/* one per port, MAX_ETH_PORTS */
 err_t LWIPServiceTaskIPConfigGet(struct netif *netif, IP_CONFIG * ipCfg);
+void eth_stats_reset(void);
+void eth_stats_get(const unsigned long ulPort, struct eth_stats_s *es);
 
-extern xTaskHandle ethLink_task_handle;
+extern xTaskHandle ethLink_task_handle[];
 
-void LWIPServiceTaskInit(IP_CONFIG *ipCfg);
+int LWIPServiceTaskInit(IP_CONFIG *ipCfg);
+int LWIPServiceTaskAddPort(const unsigned long ulPort, IP_CONFIG *ipCfg);
+void LWIPServiceTaskWaitAddress(const unsigned long ulPort, IP_CONFIG *ipCfg);
 
 #if NETIF_DEBUG
 void stellarisif_debug_print(struct pbuf *p);
@@ -0,0 +1,473 @@
+/**
+ * \file adccap.c
+ *
+ * A/D waveform capture.
+
+\page adccappage1 A/D Waveform Capture Overview
+
+io_task() only converts each processor A/D channel once per scan, which
+is fine for slow values but useless for looking at a waveform.  The
+capture subsystem uses A/D sample sequencer 1, triggered by Timer 2, to
+convert up to four channels at a fixed rate into a RAM ring buffer
+from the sequencer 1 interrupt, independent of the RTOS.
+
+A capture is armed with adc_cap_arm():
+- The ring first fills with the requested number of pre-trigger sets.
+- Then the ring keeps wrapping until the trigger (none, rising or
+    falling through a level on one channel) is seen.
+- The remaining post-trigger sets fill the rest of the ring and the
+    capture stops itself.
+
+The completed capture is exported as a binary blob (struct adc_cap_info
+followed by the samples, oldest first) by the /adc_capture CGI or
+streamed as UDP datagrams by adc_cap_udp_send().  The blob is returned
+in place: the buffer reserves ADC_CAP_PREFIX_SIZE bytes in front of the
+blob so the CGI can put its HTTP header there without a copy.  The web
+server sends it a piece at a time, so adc_cap_arm() refuses to start a
+new capture over it until adc_cap_data_done() says it has been sent.
+
+The achieved rate is measured with the free-running Timer 1 from the
+first to the last set so the caller can see whether the interrupt kept
+up.  The ceiling is the interrupt, not the converter: each set costs
+one interrupt, so ADC_CAP_MAX_RATE is set well below the converter's
+rated throughput.
+
+Note: the hardware oversampler (adc_oversample_set()) applies to all
+sequencers, so it divides the capture rate too.
+
+ *
+ * \addtogroup io I/O
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#include <FreeRTOS.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <hw_types.h>
+#include <hw_memmap.h>
+#include <hw_ints.h>
+#include <sysctl.h>
+#include <interrupt.h>
+#include <adc.h>
+#include <timer.h>
+
+#include <lwip/udp.h>
+#include <lwip/pbuf.h>
+
+#include <config.h>
+#include <io.h>
+#include <adccap.h>
+#include <timerconfig.h>
+
+#define CAP_SEQ		1	/* A/D sample sequencer used */
+#define CAP_SEQ_MAX	4	/* Sequencer 1 FIFO depth */
+
+#define UDP_MAGIC	0x55434441UL	/* "ADCU" */
+
+/**
+ * Header prepended to every capture UDP datagram.
+ */
+struct adc_cap_udp_hdr {
+	uint32_t magic;		/**< UDP_MAGIC */
+	uint32_t offset;	/**< Byte offset of this chunk in the blob */
+	uint32_t total;		/**< Total blob length */
+};
+
+/*
+ * The capture buffer.  The prefix, header and samples are contiguous
+ * so the whole thing can be handed to the web server in one piece.
+ */
+static struct {
+	char prefix[ADC_CAP_PREFIX_SIZE];
+	struct adc_cap_info info;
+	uint16_t buf[ADC_CAP_SAMPLES];
+} cap;
+
+/*
+ * Capture state shared with the ISR.
+ */
+static volatile enum adc_cap_state state = adcCapIdle;
+static unsigned long wr;		/* next set to write */
+static unsigned long count;		/* sets remaining in this phase */
+static unsigned long first_tick;	/* Timer 1 at the first set */
+static unsigned long last_tick;		/* Timer 1 at the last set */
+static int have_first;			/* first_tick is valid */
+static int rotated;			/* oldest set has been moved to 0 */
+static int trig_idx;			/* trigger channel index in a set */
+static unsigned long prev_val;		/* previous trigger channel value */
+static struct adc_cap_req active;	/* the armed request */
+static int sending;			/* adc_cap_data() blobs being sent */
+
+/****************************************************************************/
+
+/**
+ * Translate trigger strings to the trigger enum.
+ */
+const struct enumxlate_s adctrigxlate[] = {
+	{"none", sizeof("none") - 1},
+	{"rise", sizeof("rise") - 1},
+	{"fall", sizeof("fall") - 1},
+	{"invalid", sizeof("invalid") - 1},
+};
+
+enum adc_cap_trig strtoadctrig(const char *trig)
+{
+	int j;
+
+	for (j = 0; j < adcTrigInvalid; j++) {
+		if (strncmp(trig, adctrigxlate[j].str, adctrigxlate[j].len) == 0)
+			return j;
+	}
+	return adcTrigInvalid;
+}
+
+/****************************************************************************/
+
+/*
+ * Stop the hardware: timer, sequencer and interrupt.
+ */
+static void cap_stop(void)
+{
+	TimerDisable(TIMER2_BASE, TIMER_A);
+	ADCIntDisable(ADC0_BASE, CAP_SEQ);
+	ADCSequenceDisable(ADC0_BASE, CAP_SEQ);
+}
+
+/****************************************************************************/
+
+/*
+ * Sequencer 1 interrupt: one set of samples per interrupt.
+ */
+void ADC0Seq1IntHandler(void)
+{
+	unsigned long vals[CAP_SEQ_MAX];
+	unsigned long now;
+	uint16_t *dp;
+	long n;
+	int j;
+
+	now = timerTIMER_1_COUNT_VALUE;
+	ADCIntClear(ADC0_BASE, CAP_SEQ);
+
+	n = ADCSequenceDataGet(ADC0_BASE, CAP_SEQ, vals);
+	if (ADCSequenceOverflow(ADC0_BASE, CAP_SEQ)) {
+		ADCSequenceOverflowClear(ADC0_BASE, CAP_SEQ);
+		cap.info.overflows++;
+	}
+	if ((n != cap.info.nchan) || (state < adcCapPre) ||
+	    (state > adcCapPost))
+		return;
+
+	dp = &cap.buf[wr * cap.info.nchan];
+	for (j = 0; j < n; j++)
+		dp[j] = vals[j];
+
+	if (!have_first) {
+		first_tick = now;
+		have_first = 1;
+	}
+	last_tick = now;
+
+	switch (state) {
+	case adcCapPre:
+		prev_val = vals[trig_idx];
+		if (--count != 0)
+			break;
+		state = adcCapArmed;
+		/* With no pre-trigger sets this set may be the trigger. */
+		if (cap.info.pre != 0)
+			break;
+		/* fall through */
+	case adcCapArmed:
+		if ((active.trig == adcTrigNone) ||
+		    ((active.trig == adcTrigRise) &&
+		     (prev_val < active.level) &&
+		     (vals[trig_idx] >= active.level)) ||
+		    ((active.trig == adcTrigFall) &&
+		     (prev_val > active.level) &&
+		     (vals[trig_idx] <= active.level))) {
+			count = cap.info.sets - cap.info.pre - 1;
+			state = count ? adcCapPost : adcCapDone;
+		}
+		prev_val = vals[trig_idx];
+		break;
+	case adcCapPost:
+		if (--count == 0)
+			state = adcCapDone;
+		break;
+	default:
+		break;
+	}
+
+	if (state == adcCapDone) {
+		cap_stop();
+		cap.info.state = adcCapDone;
+		return;
+	}
+	if (++wr >= cap.info.sets)
+		wr = 0;
+}
+
+/****************************************************************************/
+
+/*
+ * Abort a capture in progress.
+ */
+void adc_cap_abort(void)
+{
+	cap_stop();
+	state = adcCapIdle;
+	cap.info.state = adcCapIdle;
+}
+
+/****************************************************************************/
+
+/*
+ * Arm a capture.
+ */
+int adc_cap_arm(const struct adc_cap_req *req)
+{
+	unsigned long step;
+	int nchan;
+	int j;
+
+	if ((req->chan_mask == 0) || (req->chan_mask & ~0xF))
+		return -1;
+	if ((req->rate == 0) || (req->rate > ADC_CAP_MAX_RATE))
+		return -1;
+	if ((req->trig >= adcTrigInvalid) || (req->trig_chan >= CAP_SEQ_MAX) ||
+	    !(req->chan_mask & (1 << req->trig_chan)))
+		return -1;
+
+	for (nchan = 0, j = 0; j < CAP_SEQ_MAX; j++) {
+		if (req->chan_mask & (1 << j))
+			nchan++;
+	}
+	if (req->pre >= (ADC_CAP_SAMPLES / nchan))
+		return -1;
+	if (sending)
+		return -2;
+
+	adc_cap_abort();
+
+	active = *req;
+	memset(&cap.info, 0, sizeof(cap.info));
+	cap.info.magic     = ADC_CAP_MAGIC;
+	cap.info.version   = ADC_CAP_VERSION;
+	cap.info.chan_mask = req->chan_mask;
+	cap.info.nchan     = nchan;
+	cap.info.sets      = ADC_CAP_SAMPLES / nchan;
+	cap.info.pre       = req->pre;
+	cap.info.rate      = req->rate;
+	cap.info.state     = adcCapPre;
+
+	/*
+	 * Build the sequence: one step per selected channel, ascending.
+	 * Remember where the trigger channel lands in a set.
+	 */
+	ADCSequenceConfigure(ADC0_BASE, CAP_SEQ, ADC_TRIGGER_TIMER, 0);
+	for (step = 0, j = 0; j < CAP_SEQ_MAX; j++) {
+		if (!(req->chan_mask & (1 << j)))
+			continue;
+		if (j == req->trig_chan)
+			trig_idx = step;
+		ADCSequenceStepConfigure(ADC0_BASE, CAP_SEQ, step, j |
+			((step == nchan - 1) ? (ADC_CTL_IE | ADC_CTL_END) : 0));
+		step++;
+	}
+
+	wr = 0;
+	rotated = 0;
+	have_first = 0;
+	/* Pre-trigger sets, or one set to prime the trigger level. */
+	count = req->pre ? req->pre : 1;
+	state = adcCapPre;
+
+	/*
+	 * Timer 2 triggers the sequencer at the sample rate.
+	 */
+	SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER2);
+	TimerConfigure(TIMER2_BASE, TIMER_CFG_32_BIT_PER);
+	TimerLoadSet(TIMER2_BASE, TIMER_A, (configCPU_CLOCK_HZ / req->rate) - 1);
+	TimerControlTrigger(TIMER2_BASE, TIMER_A, true);
+
+	ADCIntClear(ADC0_BASE, CAP_SEQ);
+	ADCSequenceOverflowClear(ADC0_BASE, CAP_SEQ);
+	ADCSequenceEnable(ADC0_BASE, CAP_SEQ);
+	ADCIntEnable(ADC0_BASE, CAP_SEQ);
+	/*
+	 * The ISR makes no RTOS calls, so it can run above the kernel.
+	 */
+	IntPrioritySet(INT_ADC0SS1, SET_SYSCALL_INTERRUPT_PRIORITY(0));
+	IntEnable(INT_ADC0SS1);
+	TimerEnable(TIMER2_BASE, TIMER_A);
+
+	return 0;
+}
+
+/****************************************************************************/
+
+/*
+ * Reverse a run of samples in place.
+ */
+static void reverse(uint16_t *lo, uint16_t *hi)
+{
+	uint16_t tmp;
+
+	while (lo < --hi) {
+		tmp = *lo;
+		*lo++ = *hi;
+		*hi = tmp;
+	}
+}
+
+/*
+ * Rotate the ring so the oldest set is first.  The set after the last
+ * one written is the oldest because a completed capture always fills
+ * the whole ring.
+ */
+static void cap_unroll(void)
+{
+	unsigned long oldest;
+	unsigned long total;
+
+	if (rotated)
+		return;
+	rotated = 1;
+
+	oldest = (wr + 1) % cap.info.sets;
+	if (oldest == 0)
+		return;
+	oldest *= cap.info.nchan;
+	total = cap.info.sets * cap.info.nchan;
+
+	reverse(&cap.buf[0], &cap.buf[oldest]);
+	reverse(&cap.buf[oldest], &cap.buf[total]);
+	reverse(&cap.buf[0], &cap.buf[total]);
+}
+
+/****************************************************************************/
+
+/*
+ * Fill in the achieved rate from the Timer 1 stamps.  Timer 1 counts
+ * down and wraps every ~86 seconds at 50MHz; unsigned math copes
+ * with one wrap.
+ */
+static void cap_rate(void)
+{
+	unsigned long elapsed;
+
+	elapsed = first_tick - last_tick;
+	if ((cap.info.sets > 1) && (elapsed != 0)) {
+		cap.info.achieved = ((unsigned long long)(cap.info.sets - 1) *
+			configCPU_CLOCK_HZ) / elapsed;
+	}
+}
+
+/****************************************************************************/
+
+/*
+ * Get the capture status.
+ */
+void adc_cap_status(struct adc_cap_info *info)
+{
+	cap.info.state = state;
+	if (state == adcCapDone)
+		cap_rate();
+	*info = cap.info;
+}
+
+/****************************************************************************/
+
+/*
+ * Get the completed capture as a contiguous blob.
+ */
+int adc_cap_data(int hdrlen, char **blob)
+{
+	if ((state != adcCapDone) || (hdrlen > ADC_CAP_PREFIX_SIZE))
+		return 0;
+
+	cap_unroll();
+	cap_rate();
+
+	*blob = (char *)&cap.info - hdrlen;
+	sending++;
+	return sizeof(cap.info) +
+		cap.info.sets * cap.info.nchan * sizeof(cap.buf[0]);
+}
+
+/****************************************************************************/
+
+/*
+ * A blob from adc_cap_data() has been sent.
+ */
+void adc_cap_data_done(const char *blob)
+{
+	if ((blob >= (const char *)&cap) && (blob < (const char *)(&cap + 1)) &&
+	    (sending > 0))
+		sending--;
+}
+
+/****************************************************************************/
+
+/*
+ * Stream the completed capture as UDP datagrams.
+ */
+int adc_cap_udp_send(uint32_t addr, uint16_t port)
+{
+	struct adc_cap_udp_hdr hdr;
+	struct udp_pcb *pcb;
+	struct pbuf *p;
+	ip_addr_t dest;
+	char *blob;
+	int total;
+	int off;
+	int len;
+	int sent;
+
+	total = adc_cap_data(0, &blob);
+	if (total == 0)
+		return -1;
+
+	pcb = udp_new();
+	if (pcb == NULL) {
+		adc_cap_data_done(blob);
+		return -1;
+	}
+
+	dest.addr = addr;
+	hdr.magic = UDP_MAGIC;
+	hdr.total = total;
+
+	for (sent = 0, off = 0; off < total; off += len, sent++) {
+		len = total - off;
+		if (len > ADC_CAP_UDP_CHUNK)
+			len = ADC_CAP_UDP_CHUNK;
+
+		p = pbuf_alloc(PBUF_TRANSPORT, sizeof(hdr) + len, PBUF_RAM);
+		if (p == NULL) {
+			sent = -1;
+			break;
+		}
+		hdr.offset = off;
+		memcpy(p->payload, &hdr, sizeof(hdr));
+		memcpy((char *)p->payload + sizeof(hdr), blob + off, len);
+		if (udp_sendto(pcb, p, &dest, port) != ERR_OK) {
+			pbuf_free(p);
+			sent = -1;
+			break;
+		}
+		pbuf_free(p);
+	}
+
+	udp_remove(pcb);
+	adc_cap_data_done(blob);
+	return sent;
+}
+/** \} */
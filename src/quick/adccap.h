@@ -0,0 +1,150 @@
+/**
+ * \file adccap.h
+ *
+ * A/D waveform capture definitions and declarations.
+ *
+ * \addtogroup io I/O
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#ifndef ADCCAP_H_
+#define ADCCAP_H_
+
+#include <stdint.h>
+
+/**
+ * Magic number at the start of the binary capture blob ("ADCC").
+ */
+#define ADC_CAP_MAGIC		0x43434441UL
+
+/**
+ * Binary capture blob format version.
+ */
+#define ADC_CAP_VERSION		1
+
+/**
+ * Capture trigger modes.
+ */
+enum adc_cap_trig {
+	adcTrigNone,		/**< Trigger immediately once armed */
+	adcTrigRise,		/**< Trigger channel crosses level going up */
+	adcTrigFall,		/**< Trigger channel crosses level going down */
+	adcTrigInvalid		/**< Invalid flag, MUST BE LAST */
+};
+
+/**
+ * Capture state machine.
+ */
+enum adc_cap_state {
+	adcCapIdle,		/**< Never armed or aborted */
+	adcCapPre,		/**< Filling the pre-trigger samples */
+	adcCapArmed,		/**< Waiting for the trigger */
+	adcCapPost,		/**< Triggered, filling post-trigger samples */
+	adcCapDone		/**< Capture complete, data is valid */
+};
+
+/**
+ * Header of the binary capture blob.  The samples follow immediately,
+ * oldest first, as little endian 16 bit A/D counts interleaved by
+ * channel in ascending channel order (one "set" per trigger).
+ */
+struct adc_cap_info {
+	uint32_t magic;		/**< ADC_CAP_MAGIC */
+	uint16_t version;	/**< ADC_CAP_VERSION */
+	uint16_t chan_mask;	/**< Bit n set: channel n captured */
+	uint16_t nchan;		/**< Channels per set */
+	uint16_t state;		/**< enum adc_cap_state */
+	uint32_t sets;		/**< Number of sets in the capture */
+	uint32_t pre;		/**< Sets preceding the trigger set */
+	uint32_t rate;		/**< Requested sets/second */
+	uint32_t achieved;	/**< Measured sets/second */
+	uint32_t overflows;	/**< Sequencer FIFO overflows */
+};
+
+/**
+ * Capture request parameters.
+ */
+struct adc_cap_req {
+	unsigned int chan_mask;		/**< Channels 0..3 to capture */
+	unsigned long rate;		/**< Sets per second */
+	unsigned long pre;		/**< Pre-trigger sets */
+	enum adc_cap_trig trig;		/**< Trigger mode */
+	unsigned int trig_chan;		/**< Trigger channel (0..3) */
+	unsigned int level;		/**< Trigger level, A/D counts */
+};
+
+/**
+ * For static translations
+ */
+extern const struct enumxlate_s adctrigxlate[];
+
+/**
+ * String representation to trigger enum.
+ */
+enum adc_cap_trig strtoadctrig(const char *trig);
+
+/**
+ * Arm a capture, aborting any capture in progress.
+ *
+ * \param req The capture parameters.
+ * \returns 0 on success, -1 if the parameters are invalid, -2 if the
+ *   last capture is still being sent (adc_cap_data()).
+ */
+int adc_cap_arm(const struct adc_cap_req *req);
+
+/**
+ * Abort a capture in progress.
+ */
+void adc_cap_abort(void);
+
+/**
+ * Get the capture status.
+ *
+ * \param info Filled in with the capture header.
+ */
+void adc_cap_status(struct adc_cap_info *info);
+
+/**
+ * Get the completed capture as a contiguous blob: the
+ * struct adc_cap_info header followed by the samples, oldest first.
+ *
+ * \param hdrlen Bytes of room required in front of the blob (e.g. for
+ *   an HTTP header), up to ADC_CAP_PREFIX_SIZE.
+ * \param blob Returns a pointer hdrlen bytes in front of the blob.
+ * \returns The length of the blob (excluding hdrlen), 0 if no capture
+ *   is complete.  A blob returned must be given back with
+ *   adc_cap_data_done().
+ */
+int adc_cap_data(int hdrlen, char **blob);
+
+/**
+ * Tell the capture a blob from adc_cap_data() has been sent, so that it
+ * can be armed again.  Other pointers are ignored.
+ *
+ * \param blob The pointer adc_cap_data() returned.
+ */
+void adc_cap_data_done(const char *blob);
+
+/**
+ * Stream the completed capture as UDP datagrams.  Must be called from
+ * the lwIP (tcpip) thread.
+ *
+ * \param addr The destination IP address (network order).
+ * \param port The destination UDP port.
+ * \returns The number of datagrams sent, -1 if there is nothing to
+ *   send or the send failed.
+ */
+int adc_cap_udp_send(uint32_t addr, uint16_t port);
+
+/**
+ * Sequencer 1 interrupt handler (in the vector table).
+ */
+void ADC0Seq1IntHandler(void);
+
+#endif
+/** \} */
@@ -0,0 +1,194 @@
+/**
+ * \file adcfilt.c
+ *
+ * A/D sample filtering.
+
+\page adcfiltpage1 A/D Filtering Overview
+
+Each processor A/D channel has its own filter stage that is run by
+io_task() every time a conversion sequence completes.  The filters are
+all fixed point and cheap enough to run on every scan:
+- adcFiltNone: the latest sample (the original behavior).
+- adcFiltAverage: moving average over a power-of-two window, kept as a
+    running sum so each sample costs one add, one subtract and a shift.
+- adcFiltEma: exponential moving average, alpha = 1 / 2^shift, with
+    ADC_FILT_FRAC_BITS of fraction carried so small steps are not lost.
+- adcFiltMedian: median of an odd window, good for rejecting spikes.
+
+The hardware oversampler (see adc_oversample_set()) averages in the
+A/D converter itself before any of this, at the cost of conversion rate.
+
+ *
+ * \addtogroup io I/O
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#include <string.h>
+
+#include <io.h>
+#include <adcfilt.h>
+
+/****************************************************************************/
+
+/**
+ * Translate filter type strings to the filter enum.
+ */
+const struct enumxlate_s adcfiltxlate[] = {
+	{"none", sizeof("none") - 1},
+	{"avg", sizeof("avg") - 1},
+	{"ema", sizeof("ema") - 1},
+	{"median", sizeof("median") - 1},
+	{"invalid", sizeof("invalid") - 1},
+};
+
+const char *adcfilttostr(enum adc_filter_type type)
+{
+	if ((type < adcFiltNone) || (type > adcFiltInvalid))
+		return adcfiltxlate[adcFiltInvalid].str;
+	return adcfiltxlate[type].str;
+}
+
+enum adc_filter_type strtoadcfilt(const char *type)
+{
+	int j;
+
+	for (j = 0; j < adcFiltInvalid; j++) {
+		if (strncmp(type, adcfiltxlate[j].str, adcfiltxlate[j].len) == 0)
+			return j;
+	}
+	return adcFiltInvalid;
+}
+
+/****************************************************************************/
+
+/*
+ * Returns log2(n) if n is a power of two, -1 otherwise.
+ */
+static int log2_exact(int n)
+{
+	int shift;
+
+	for (shift = 0; (1 << shift) < n; shift++)
+		;
+	return ((1 << shift) == n) ? shift : -1;
+}
+
+/****************************************************************************/
+
+/*
+ * (Re)initialize a filter, discarding its history.
+ */
+int adc_filter_init(struct adc_filter_s *f,
+	enum adc_filter_type type, int param)
+{
+	switch (type) {
+	case adcFiltNone:
+		param = 0;
+		break;
+	case adcFiltAverage:
+		if ((param < 1) || (param > ADC_FILT_MAX_WINDOW) ||
+		    (log2_exact(param) < 0))
+			return -1;
+		break;
+	case adcFiltEma:
+		if ((param < 1) || (param > ADC_FILT_MAX_SHIFT))
+			return -1;
+		break;
+	case adcFiltMedian:
+		if ((param < 1) || (param > ADC_FILT_MAX_MEDIAN) ||
+		    ((param & 1) == 0))
+			return -1;
+		break;
+	default:
+		return -1;
+	}
+
+	memset(f, 0, sizeof(*f));
+	f->type  = type;
+	f->param = param;
+	return 0;
+}
+
+/****************************************************************************/
+
+/*
+ * Median of the history window: insertion sort a copy (N <= 9).
+ */
+static unsigned long median(const struct adc_filter_s *f)
+{
+	unsigned short sorted[ADC_FILT_MAX_MEDIAN];
+	unsigned short tmp;
+	int j, k;
+
+	for (j = 0; j < f->count; j++) {
+		tmp = f->hist[j];
+		for (k = j; (k > 0) && (sorted[k - 1] > tmp); k--)
+			sorted[k] = sorted[k - 1];
+		sorted[k] = tmp;
+	}
+	return sorted[f->count / 2];
+}
+
+/****************************************************************************/
+
+/*
+ * Run one sample through the filter.
+ */
+unsigned long adc_filter_run(struct adc_filter_s *f, unsigned long sample)
+{
+	long delta;
+
+	switch (f->type) {
+	case adcFiltAverage:
+		/*
+		 * Running sum: drop the oldest sample, add the newest.
+		 * Until the window fills, average what we have.
+		 */
+		if (f->count == f->param)
+			f->sum -= f->hist[f->next];
+		else
+			f->count++;
+		f->hist[f->next] = sample;
+		f->sum += sample;
+		if (++f->next >= f->param)
+			f->next = 0;
+		if (f->count == f->param)
+			return (f->sum + (f->param >> 1)) >>
+				log2_exact(f->param);
+		return (f->sum + (f->count >> 1)) / f->count;
+
+	case adcFiltEma:
+		/*
+		 * acc += (sample - acc) / 2^shift, in fixed point.
+		 * Seed with the first sample so we don't ramp up from 0.
+		 */
+		if (f->count == 0) {
+			f->acc = sample << ADC_FILT_FRAC_BITS;
+			f->count = 1;
+		} else {
+			delta = (long)(sample << ADC_FILT_FRAC_BITS) -
+				(long)f->acc;
+			f->acc += delta >> f->param;
+		}
+		return (f->acc + (1 << (ADC_FILT_FRAC_BITS - 1))) >>
+			ADC_FILT_FRAC_BITS;
+
+	case adcFiltMedian:
+		f->hist[f->next] = sample;
+		if (++f->next >= f->param)
+			f->next = 0;
+		if (f->count < f->param)
+			f->count++;
+		return median(f);
+
+	case adcFiltNone:
+	default:
+		return sample;
+	}
+}
+/** \} */
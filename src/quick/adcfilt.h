@@ -0,0 +1,101 @@
+/**
+ * \file adcfilt.h
+ *
+ * A/D sample filtering definitions and declarations.
+ *
+ * \addtogroup io I/O
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#ifndef ADCFILT_H_
+#define ADCFILT_H_
+
+/**
+ * Largest moving average window (samples).  Must be a power of two
+ * no larger than 64 so the sum of 10 bit samples fits easily.
+ */
+#define ADC_FILT_MAX_WINDOW	16
+
+/**
+ * Largest median window (samples).  Must be odd.  The median is
+ * found by sorting a copy of the window every sample, so keep it small.
+ */
+#define ADC_FILT_MAX_MEDIAN	9
+
+/**
+ * Largest exponential moving average shift (alpha = 1 / 2^shift).
+ */
+#define ADC_FILT_MAX_SHIFT	8
+
+/**
+ * Number of fractional bits carried in the EMA accumulator.
+ */
+#define ADC_FILT_FRAC_BITS	8
+
+/**
+ * Selects the digital filter applied to an A/D channel.
+ */
+enum adc_filter_type {
+	adcFiltNone,		/**< Latest sample, unfiltered */
+	adcFiltAverage,		/**< Moving average, param = window */
+	adcFiltEma,		/**< Exponential moving average, param = shift */
+	adcFiltMedian,		/**< Median of N, param = window (odd) */
+	adcFiltInvalid		/**< Invalid flag, MUST BE LAST */
+};
+
+/**
+ * Per-channel filter state.  All arithmetic is fixed point.
+ */
+struct adc_filter_s {
+	enum adc_filter_type type;	/**< Which filter is active */
+	int param;			/**< Window size or EMA shift */
+	int count;			/**< Valid samples in the history */
+	int next;			/**< Next history slot to fill */
+	unsigned long sum;		/**< Running sum of the history */
+	unsigned long acc;		/**< EMA accumulator (fixed point) */
+	unsigned short hist[ADC_FILT_MAX_WINDOW]; /**< Sample history */
+};
+
+/**
+ * For static translations
+ */
+extern const struct enumxlate_s adcfiltxlate[];
+
+/**
+ * Filter type enum to string representation.
+ */
+const char *adcfilttostr(enum adc_filter_type type);
+
+/**
+ * String representation to filter type enum.
+ */
+enum adc_filter_type strtoadcfilt(const char *type);
+
+/**
+ * (Re)initialize a filter, discarding its history.
+ *
+ * \param f The filter state to initialize.
+ * \param type Selects the filter kernel.
+ * \param param The window size (average, median) or shift (EMA).
+ * \returns 0 on success, -1 if the type or parameter is out of range
+ *   (in which case the filter is left untouched).
+ */
+int adc_filter_init(struct adc_filter_s *f,
+	enum adc_filter_type type, int param);
+
+/**
+ * Run one sample through the filter.
+ *
+ * \param f The filter state.
+ * \param sample The new raw A/D sample.
+ * \returns The filtered value in A/D counts.
+ */
+unsigned long adc_filter_run(struct adc_filter_s *f, unsigned long sample);
+
+#endif
+/** \} */
@@ -0,0 +1,96 @@
+/**
+ * \file boottime.c
+ *
+ * Boot phase timestamps.
+
+\page bootpage1 Boot Time Overview
+
+Only what has to be live quickly is done by main() before the scheduler
+starts: the clocks, the configuration, I/O scanning and the watchdog
+(util_task).  The rest - the OLED, the banner and the image check - is
+done by a low priority task and the network comes up in its own task,
+so neither delays the I/O.
+
+Each phase of the boot calls boot_mark() when it's done, which records
+the 64 bit Timer 1 time (the run time stats clock, see timertest.c).
+When the boot is complete boot_report() prints them as a table:
+
+\code
+Boot phase       ms     +ms
+timer         0.000   0.000
+config        0.412   0.412
+...
+\endcode
+
+The time from reset to vSetupHighFrequencyTimer() (the C startup and
+the clock setup) isn't included.
+
+ *
+ * \addtogroup util Utilities
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "timerconfig.h"
+#include "boottime.h"
+#include "logger.h"
+
+/*
+ * Private information.
+ */
+static struct {
+	const char *phase;
+	unsigned long long cycles;
+} marks[BOOT_MARKS_MAX];
+
+static int nmarks;
+
+#define CYCLES_PER_USEC	(configCPU_CLOCK_HZ / 1000000)
+
+/****************************************************************************/
+
+/*
+ * Record the end of a boot phase.
+ */
+void boot_mark(const char *phase)
+{
+	taskENTER_CRITICAL();
+	if (nmarks < BOOT_MARKS_MAX) {
+		marks[nmarks].phase = phase;
+		marks[nmarks].cycles = ullGetRunTimeCycles();
+		nmarks++;
+	}
+	taskEXIT_CRITICAL();
+}
+
+/****************************************************************************/
+
+/*
+ * Print the boot phases.
+ */
+void boot_report(void)
+{
+	unsigned long usec;
+	unsigned long delta;
+	unsigned long last = 0;
+	int j;
+
+	/* ustdlib pads %s on the right. */
+	lprintf("Boot phase       ms     +ms\r\n");
+	for (j = 0; j < nmarks; j++) {
+		usec = marks[j].cycles / CYCLES_PER_USEC;
+		delta = usec - last;
+		last = usec;
+		lprintf("%10s %4d.%03d %3d.%03d\r\n", marks[j].phase,
+			(int)(usec / 1000), (int)(usec % 1000),
+			(int)(delta / 1000), (int)(delta % 1000));
+	}
+}
+/** \} */
@@ -0,0 +1,39 @@
+/**
+ * \file boottime.h
+ *
+ * Boot phase timestamps definitions and declarations.
+ *
+ * \addtogroup util Utilities
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#ifndef BOOTTIME_H_
+#define BOOTTIME_H_
+
+/**
+ * Most boot phases recorded, later marks are dropped.
+ */
+#define BOOT_MARKS_MAX		16
+
+/**
+ * Record the end of a boot phase: the Timer 1 time since
+ * vSetupHighFrequencyTimer().  May be called before the scheduler starts
+ * and from any task, not from an ISR.
+ *
+ * \param phase Name of the phase, must be a constant string.
+ */
+void boot_mark(const char *phase);
+
+/**
+ * Print the boot phases on the serial log: the time of each from Timer 1
+ * start and from the previous phase, milliseconds.
+ */
+void boot_report(void);
+
+#endif /* BOOTTIME_H_ */
+/** \} */
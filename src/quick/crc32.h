@@ -0,0 +1,64 @@
+/**
+ * \file crc32.h
+ *
+ * CRC32 and application image check definitions and declarations.
+ *
+ * \addtogroup util Utilities
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#ifndef CRC32_H_
+#define CRC32_H_
+
+#include <stdint.h>
+
+/**
+ * Magic number of the image CRC trailer ("ICRC").
+ */
+#define IMAGE_CRC_MAGIC		0x43524349UL
+
+/**
+ * Image CRC trailer, appended to the binary image by the imagecrc
+ * script at the next word after the image.  Little endian.
+ */
+struct image_crc_s {
+	uint32_t magic;		/**< IMAGE_CRC_MAGIC */
+	uint32_t length;	/**< Image length, bytes from the start of flash */
+	uint32_t crc;		/**< CRC32 of the image */
+};
+
+/**
+ * Image check results.
+ */
+enum image_status {
+	imageOk,		/**< The image CRC is correct */
+	imageNoCrc,		/**< No trailer (e.g. loaded by the debugger) */
+	imageBad		/**< The image is corrupt */
+};
+
+/**
+ * Calculate a CRC32 (IEEE 802.3, the same as zlib's crc32()).
+ *
+ * \param crc 0 to start, or the CRC of the preceding data to continue.
+ * \param buf The data.
+ * \param len Length of the data, bytes.
+ * \returns The CRC.
+ */
+uint32_t crc32(uint32_t crc, const void *buf, int len);
+
+/**
+ * Check the application image against its CRC trailer and report the
+ * result (and how fast the CRC ran) on the serial log.  Timer 1 must be
+ * running (vSetupHighFrequencyTimer()).
+ *
+ * \returns The result.
+ */
+enum image_status image_check(void);
+
+#endif /* CRC32_H_ */
+/** \} */
@@ -0,0 +1,233 @@
+/**
+ * \file dioevent.c
+ *
+ * Discrete input change events.
+
+\page dioeventpage1 Discrete Input Events Overview
+
+The EVB buttons (dioUp, dioDown, dioLeft, dioRight, dioSelect) generate
+GPIO interrupts on both edges.  Each change is put on a queue with a
+Timer 1 time stamp so a task can block in dio_event_wait() instead of
+polling dio().
+
+Debouncing is "leading edge": the first edge is reported immediately
+(so the latency is the interrupt latency), then that pin's interrupt is
+masked for DIO_DEBOUNCE_MS.  When the lockout expires, dio_event_tick()
+(called from the tick hook) re-reads the pin and, if it settled at the
+other level during the lockout, reports that change too.  A bouncing
+contact therefore produces exactly one event per real transition.
+
+The web server takes the events with /dio_events, which drains the queue
+without waiting and reports dio_event_lost, the events dropped because
+nobody took them in time.
+
+ *
+ * \addtogroup io I/O
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#include <FreeRTOS.h>
+#include <queue.h>
+
+#include <hw_types.h>
+#include <hw_memmap.h>
+#include <hw_ints.h>
+#include <interrupt.h>
+#include <gpio.h>
+
+#include <config.h>
+#include <io.h>
+#include <dioevent.h>
+#include <timerconfig.h>
+
+#define DEBOUNCE_TICKS	((DIO_DEBOUNCE_MS * configTICK_RATE_HZ) / 1000)
+
+/*
+ * Public information.
+ */
+volatile unsigned long dio_event_lost;
+
+/*
+ * Private information.
+ */
+
+/**
+ * The inputs that generate events.
+ */
+static const struct dio_pin_s {
+	enum dio_sel which;	/**< The discrete */
+	unsigned long base;	/**< GPIO port base address */
+	unsigned char pin;	/**< GPIO pin mask */
+} pins[] = {
+	{ dioUp,     GPIO_PORTE_BASE, GPIO_PIN_0 },
+	{ dioDown,   GPIO_PORTE_BASE, GPIO_PIN_1 },
+	{ dioLeft,   GPIO_PORTE_BASE, GPIO_PIN_2 },
+	{ dioRight,  GPIO_PORTE_BASE, GPIO_PIN_3 },
+	{ dioSelect, GPIO_PORTF_BASE, GPIO_PIN_1 },
+};
+#define NUM_PINS	(sizeof(pins) / sizeof(pins[0]))
+
+static xQueueHandle event_queue;
+
+static volatile unsigned short lockout[NUM_PINS]; /* ticks remaining */
+static volatile unsigned char level[NUM_PINS];	  /* last reported level */
+
+/****************************************************************************/
+
+/*
+ * Read a pin, post an event if it differs from the last reported level.
+ * Called from interrupt context only (GPIO ISR or tick hook).
+ */
+static void post_if_changed(int j, unsigned long stamp,
+	signed portBASE_TYPE *woken)
+{
+	struct dio_event_s ev;
+	int now;
+
+	now = GPIOPinRead(pins[j].base, pins[j].pin) ? 1 : 0;
+	if (now == level[j])
+		return;
+	level[j] = now;
+
+	ev.which = pins[j].which;
+	ev.value = now;
+	ev.stamp = stamp;
+	if (xQueueSendFromISR(event_queue, &ev, woken) != pdPASS)
+		dio_event_lost++;
+}
+
+/****************************************************************************/
+
+/*
+ * Common port interrupt handling.
+ */
+static void port_isr(unsigned long base)
+{
+	signed portBASE_TYPE woken = pdFALSE;
+	unsigned long stamp;
+	long status;
+	int j;
+
+	stamp = timerTIMER_1_COUNT_VALUE;
+	status = GPIOPinIntStatus(base, true);
+	GPIOPinIntClear(base, status);
+
+	for (j = 0; j < NUM_PINS; j++) {
+		if ((pins[j].base != base) || !(status & pins[j].pin))
+			continue;
+		/*
+		 * Leading edge: report now, then ignore the bounce.
+		 */
+		GPIOPinIntDisable(base, pins[j].pin);
+		lockout[j] = DEBOUNCE_TICKS ? DEBOUNCE_TICKS : 1;
+		post_if_changed(j, stamp, &woken);
+	}
+	portEND_SWITCHING_ISR(woken);
+}
+
+void GPIOEIntHandler(void)
+{
+	port_isr(GPIO_PORTE_BASE);
+}
+
+void GPIOFIntHandler(void)
+{
+	port_isr(GPIO_PORTF_BASE);
+}
+
+/****************************************************************************/
+
+/*
+ * Debounce timer, called from the RTOS tick hook (interrupt context).
+ */
+void dio_event_tick(void)
+{
+	signed portBASE_TYPE woken = pdFALSE;
+	int j;
+
+	if (event_queue == NULL)
+		return;
+
+	for (j = 0; j < NUM_PINS; j++) {
+		if ((lockout[j] == 0) || (--lockout[j] != 0))
+			continue;
+		/*
+		 * Lockout expired.  Catch a change that completed while
+		 * we were ignoring the pin, then listen again.
+		 */
+		GPIOPinIntClear(pins[j].base, pins[j].pin);
+		post_if_changed(j, timerTIMER_1_COUNT_VALUE, &woken);
+		GPIOPinIntEnable(pins[j].base, pins[j].pin);
+	}
+	/* The tick interrupt does its own context switch. */
+}
+
+/****************************************************************************/
+
+/*
+ * Ticks until the first lockout runs out.
+ */
+portTickType dio_event_ticks_left(void)
+{
+	portTickType left = portMAX_DELAY;
+	int j;
+
+	for (j = 0; j < NUM_PINS; j++) {
+		if ((lockout[j] != 0) && (lockout[j] < left))
+			left = lockout[j];
+	}
+	return left;
+}
+
+/****************************************************************************/
+
+/*
+ * Wait for the next input change event.
+ */
+int dio_event_wait(struct dio_event_s *ev, portTickType ticks)
+{
+	if (event_queue == NULL)
+		return 0;
+	return (xQueueReceive(event_queue, ev, ticks) == pdTRUE) ? 1 : 0;
+}
+
+/****************************************************************************/
+
+/*
+ * Initialize the edge interrupts and the event queue.
+ */
+int dio_event_init(void)
+{
+#if (PART == LM3S8962)
+	int j;
+
+	event_queue = xQueueCreate(DIO_EVENT_QUEUE_LEN,
+		sizeof(struct dio_event_s));
+	if (event_queue == NULL)
+		return -1;
+
+	for (j = 0; j < NUM_PINS; j++) {
+		level[j] = GPIOPinRead(pins[j].base, pins[j].pin) ? 1 : 0;
+		lockout[j] = 0;
+		GPIOIntTypeSet(pins[j].base, pins[j].pin, GPIO_BOTH_EDGES);
+		GPIOPinIntClear(pins[j].base, pins[j].pin);
+		GPIOPinIntEnable(pins[j].base, pins[j].pin);
+	}
+
+	/*
+	 * The ISRs post to a queue so they must be at or below the
+	 * syscall priority.
+	 */
+	IntPrioritySet(INT_GPIOE, SET_SYSCALL_INTERRUPT_PRIORITY(5));
+	IntPrioritySet(INT_GPIOF, SET_SYSCALL_INTERRUPT_PRIORITY(5));
+	IntEnable(INT_GPIOE);
+	IntEnable(INT_GPIOF);
+#endif
+	return 0;
+}
+/** \} */
@@ -0,0 +1,72 @@
+/**
+ * \file dioevent.h
+ *
+ * Discrete input change event definitions and declarations.
+ *
+ * \addtogroup io I/O
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#ifndef DIOEVENT_H_
+#define DIOEVENT_H_
+
+/**
+ * A discrete input change event.
+ */
+struct dio_event_s {
+	enum dio_sel which;	/**< The input that changed */
+	int value;		/**< The new level {1|0}, as dio() returns */
+	unsigned long stamp;	/**< Timer 1 count at the edge (counts down) */
+};
+
+/**
+ * Number of events that were dropped because the queue was full.
+ */
+extern volatile unsigned long dio_event_lost;
+
+/**
+ * Initialize the edge interrupts and the event queue.
+ *
+ * \returns 0 on success, -1 on failure.
+ */
+int dio_event_init(void);
+
+/**
+ * Wait for the next input change event.
+ *
+ * \param ev Filled in with the event.
+ * \param ticks Maximum time to wait, in RTOS ticks.
+ * \returns 1 if an event was received, 0 on timeout.
+ */
+int dio_event_wait(struct dio_event_s *ev, portTickType ticks);
+
+/**
+ * Debounce timer, called from the RTOS tick hook.
+ */
+void dio_event_tick(void);
+
+/**
+ * Get the ticks until the first debounce lockout runs out, which the
+ * tick must not be suppressed past (see tickless.c).
+ *
+ * \returns The ticks, portMAX_DELAY if no pin is locked out.
+ */
+portTickType dio_event_ticks_left(void);
+
+/**
+ * GPIO port E interrupt handler (in the vector table).
+ */
+void GPIOEIntHandler(void);
+
+/**
+ * GPIO port F interrupt handler (in the vector table).
+ */
+void GPIOFIntHandler(void);
+
+#endif
+/** \} */
@@ -0,0 +1,404 @@
+/**
+ * \file fastmem.c
+ *
+ * Word and burst memory copy, fill and compare.
+
+\page fastmempage1 Fast Memory Functions Overview
+
+The C library's memcpy(), memset() and memcmp() are built for size and
+move a byte at a time.  The hot copies (lwIP's pbuf copies through
+MEMCPY in lwipopts.h, fs_read() of the web pages) are mostly hundreds
+of bytes, where moving words pays off many times over.
+
+- Copy: the destination is brought to a word boundary a byte at a time.
+  If the source is then aligned too, 32 bytes are moved per loop with
+  two LDM / STM pairs of four registers, the rest a word at a time.
+  Otherwise the source is read with unaligned word loads, which the
+  Cortex-M3 does in hardware (LDM can't), and stored as aligned words.
+- Fill: the byte is spread over a word and stored with STM bursts.
+- Compare: a word at a time while both are aligned, the first word that
+  differs is compared by bytes for the memcmp() sign.
+
+Short buffers go straight to the byte loops.  Without the Cortex-M3
+(a host build) the bursts are plain word loops, the results are the same.
+
+fastmem_selftest() checks the results for every alignment of the source
+and the destination and every length up to a limit.  On the target it
+runs the bursts (/mem_selftest); test/fastmem.c (make host-test) runs it
+on the host over longer lengths.
+
+fastmem_bench() times these against the C library for a buffer size,
+/mem_bench reports a set of sizes.
+
+ *
+ * \addtogroup util Utilities
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#include <FreeRTOS.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <fastmem.h>
+#include <timerconfig.h>
+
+/*
+ * Below this, the byte loops are faster than getting aligned.
+ */
+#define SHORT_LEN	12
+
+/*
+ * Word access.  The buffers hold anything (lwIP's pbufs, structures), so
+ * the words may alias any type: without may_alias the compiler could
+ * reorder them around the caller's own accesses, which -flto makes
+ * visible across files.
+ */
+typedef uint32_t __attribute__((may_alias)) word_t;
+
+struct unaligned_s {
+	word_t w;
+} __attribute__((packed, may_alias));
+
+#define ALIGNED(p)	((((uintptr_t)(p)) & 3) == 0)
+
+/*
+ * Benchmark: calls timed per operation, the best is kept.
+ */
+#define BENCH_RUNS	8
+
+/****************************************************************************/
+
+/*
+ * Copy.
+ */
+void *fast_memcpy(void *dst, const void *src, size_t len)
+{
+	uint8_t *d = dst;
+	const uint8_t *s = src;
+	word_t *dw;
+	const word_t *sw;
+
+	if (len >= SHORT_LEN) {
+		while (!ALIGNED(d)) {
+			*d++ = *s++;
+			len--;
+		}
+		dw = (word_t *)d;
+		if (ALIGNED(s)) {
+			sw = (const word_t *)s;
+#if defined(__ARM_ARCH_7M__)
+			while (len >= 32) {
+				__asm volatile (
+					"ldmia	%1!, {r3, r4, r5, r6}\n\t"
+					"stmia	%0!, {r3, r4, r5, r6}\n\t"
+					"ldmia	%1!, {r3, r4, r5, r6}\n\t"
+					"stmia	%0!, {r3, r4, r5, r6}"
+					: "+r" (dw), "+r" (sw)
+					:
+					: "r3", "r4", "r5", "r6", "memory");
+				len -= 32;
+			}
+#endif
+			while (len >= 4) {
+				*dw++ = *sw++;
+				len -= 4;
+			}
+			s = (const uint8_t *)sw;
+		} else {
+			while (len >= 16) {
+				dw[0] = ((const struct unaligned_s *)s)[0].w;
+				dw[1] = ((const struct unaligned_s *)s)[1].w;
+				dw[2] = ((const struct unaligned_s *)s)[2].w;
+				dw[3] = ((const struct unaligned_s *)s)[3].w;
+				dw += 4;
+				s += 16;
+				len -= 16;
+			}
+			while (len >= 4) {
+				*dw++ = ((const struct unaligned_s *)s)->w;
+				s += 4;
+				len -= 4;
+			}
+		}
+		d = (uint8_t *)dw;
+	}
+
+	while (len--)
+		*d++ = *s++;
+
+	return dst;
+}
+
+/****************************************************************************/
+
+/*
+ * Fill.
+ */
+void *fast_memset(void *dst, int c, size_t len)
+{
+	uint8_t *d = dst;
+	word_t *dw;
+	uint32_t w;
+
+	if (len >= SHORT_LEN) {
+		while (!ALIGNED(d)) {
+			*d++ = c;
+			len--;
+		}
+		w = (uint8_t)c;
+		w |= w << 8;
+		w |= w << 16;
+		dw = (word_t *)d;
+#if defined(__ARM_ARCH_7M__)
+		{
+			register uint32_t r3 __asm("r3") = w;
+			register uint32_t r4 __asm("r4") = w;
+			register uint32_t r5 __asm("r5") = w;
+			register uint32_t r6 __asm("r6") = w;
+
+			while (len >= 32) {
+				__asm volatile (
+					"stmia	%0!, {%1, %2, %3, %4}\n\t"
+					"stmia	%0!, {%1, %2, %3, %4}"
+					: "+r" (dw)
+					: "r" (r3), "r" (r4), "r" (r5), "r" (r6)
+					: "memory");
+				len -= 32;
+			}
+		}
+#endif
+		while (len >= 4) {
+			*dw++ = w;
+			len -= 4;
+		}
+		d = (uint8_t *)dw;
+	}
+
+	while (len--)
+		*d++ = c;
+
+	return dst;
+}
+
+/****************************************************************************/
+
+/*
+ * Compare.
+ */
+int fast_memcmp(const void *a, const void *b, size_t len)
+{
+	const uint8_t *pa = a;
+	const uint8_t *pb = b;
+	const word_t *wa;
+	const word_t *wb;
+
+	if ((len >= SHORT_LEN) && ALIGNED(pa) && ALIGNED(pb)) {
+		wa = (const word_t *)pa;
+		wb = (const word_t *)pb;
+		while ((len >= 4) && (*wa == *wb)) {
+			wa++;
+			wb++;
+			len -= 4;
+		}
+		pa = (const uint8_t *)wa;
+		pb = (const uint8_t *)wb;
+	}
+
+	for (; len; len--, pa++, pb++) {
+		if (*pa != *pb)
+			return *pa - *pb;
+	}
+	return 0;
+}
+
+/****************************************************************************/
+
+/*
+ * The bytes of buf outside [off, off + len) are all guard.
+ */
+static int guarded(const uint8_t *buf, size_t size, size_t off, size_t len,
+		uint8_t guard)
+{
+	size_t j;
+
+	for (j = 0; j < size; j++) {
+		if (((j < off) || (j >= off + len)) && (buf[j] != guard))
+			return 0;
+	}
+	return 1;
+}
+
+/*
+ * The same sign, and both zero or neither.
+ */
+static int same_sign(int a, int b)
+{
+	return ((a > 0) == (b > 0)) && ((a < 0) == (b < 0));
+}
+
+/*
+ * One byte different at k: both ways round, the sign must be memcmp()'s.
+ */
+static int compare_differ(uint8_t *a, uint8_t *b, size_t len, size_t k)
+{
+	int ok;
+
+	b[k] ^= 0x81;
+	ok = same_sign(fast_memcmp(a, b, len), memcmp(a, b, len)) &&
+		same_sign(fast_memcmp(b, a, len), memcmp(b, a, len)) &&
+		(fast_memcmp(a, b, len) != 0);
+	b[k] ^= 0x81;
+	return ok;
+}
+
+/*
+ * Check the functions over the alignments and the lengths.
+ */
+int fastmem_selftest(size_t max_len)
+{
+	const size_t size = max_len + 8;	/* misalignment and guard */
+	uint8_t *dst;
+	uint8_t *src;
+	size_t soff;
+	size_t doff;
+	size_t len;
+	size_t k;
+	int errors = 0;
+
+	if (max_len > FASTMEM_BENCH_MAX)
+		return -1;
+	if ((dst = pvPortMalloc(size)) == NULL)
+		return -1;
+	if ((src = pvPortMalloc(size)) == NULL) {
+		vPortFree(dst);
+		return -1;
+	}
+	for (k = 0; k < size; k++)
+		src[k] = k * 7 + 1;
+
+	for (soff = 0; soff < 4; soff++) {
+		for (doff = 0; doff < 4; doff++) {
+			for (len = 0; len <= max_len; len++) {
+				/* Copy. */
+				memset(dst, 0xee, size);
+				if ((fast_memcpy(dst + doff, src + soff, len) !=
+						dst + doff) ||
+				    (memcmp(dst + doff, src + soff, len) != 0) ||
+				    !guarded(dst, size, doff, len, 0xee))
+					errors++;
+
+				/* Fill, the value is cut to a byte. */
+				memset(dst, 0xee, size);
+				if ((fast_memset(dst + doff, 0x100 | (len & 0x7f),
+						len) != dst + doff) ||
+				    !guarded(dst, size, doff, len, 0xee) ||
+				    !guarded(dst + doff, len, 0, 0, len & 0x7f))
+					errors++;
+
+				/* Compare, equal then one byte different. */
+				memcpy(dst + doff, src + soff, len);
+				if (fast_memcmp(src + soff, dst + doff, len) != 0)
+					errors++;
+				for (k = 0; k < len; k++) {
+					if ((k >= 8) && (k + 8 < len) &&
+					    (k != len / 2))
+						continue;
+					if (!compare_differ(src + soff,
+							dst + doff, len, k))
+						errors++;
+				}
+			}
+		}
+	}
+
+	vPortFree(src);
+	vPortFree(dst);
+	return errors;
+}
+
+/****************************************************************************/
+
+/*
+ * Best time of one operation, CPU clocks.  The functions are called
+ * through pointers so the compiler can't expand the library's inline.
+ */
+static uint32_t bench_one(enum fastmem_op op, int fast,
+		uint8_t *dst, const uint8_t *src, size_t len)
+{
+	static void *(* volatile copy[2])(void *, const void *, size_t) = {
+		memcpy, fast_memcpy
+	};
+	static void *(* volatile set[2])(void *, int, size_t) = {
+		memset, fast_memset
+	};
+	static int (* volatile compare[2])(const void *, const void *,
+			size_t) = {
+		memcmp, fast_memcmp
+	};
+	unsigned long long t0, t1;
+	uint32_t best = UINT32_MAX;
+	uint32_t overhead = UINT32_MAX;
+	int j;
+
+	for (j = 0; j < BENCH_RUNS; j++) {
+		t0 = ullGetRunTimeCycles();
+		t1 = ullGetRunTimeCycles();
+		if (t1 - t0 < overhead)
+			overhead = t1 - t0;
+
+		t0 = ullGetRunTimeCycles();
+		switch (op) {
+		case fmCopy:
+			copy[fast](dst, src, len);
+			break;
+		case fmSet:
+			set[fast](dst, 0x5a, len);
+			break;
+		default:
+			compare[fast](dst, src, len);
+			break;
+		}
+		t1 = ullGetRunTimeCycles();
+		if (t1 - t0 < best)
+			best = t1 - t0;
+	}
+	return (best > overhead) ? best - overhead : 0;
+}
+
+/*
+ * Time the library and the fast functions.
+ */
+int fastmem_bench(size_t len, int offset, struct fastmem_bench_s *fb)
+{
+	uint8_t *dst;
+	uint8_t *src;
+	int op;
+
+	if ((len > FASTMEM_BENCH_MAX) || (offset < 0) || (offset > 3))
+		return -1;
+	if ((dst = pvPortMalloc(len)) == NULL)
+		return -1;
+	if ((src = pvPortMalloc(len + 3)) == NULL) {
+		vPortFree(dst);
+		return -1;
+	}
+	memset(src, 0xa5, len + 3);
+
+	for (op = fmCopy; op < fmInvalid; op++) {
+		/* The compare runs on the copy: equal, all of it is read. */
+		fb->lib[op] = bench_one(op, 0, dst, src + offset, len);
+		fb->fast[op] = bench_one(op, 1, dst, src + offset, len);
+		if (op == fmSet)
+			memcpy(dst, src + offset, len);
+	}
+
+	vPortFree(src);
+	vPortFree(dst);
+	return 0;
+}
+/** \} */
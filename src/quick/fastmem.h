@@ -0,0 +1,93 @@
+/**
+ * \file fastmem.h
+ *
+ * Word and burst memory copy, fill and compare definitions and
+ * declarations.
+ *
+ * \addtogroup util Utilities
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#ifndef FASTMEM_H_
+#define FASTMEM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * memcpy(): the buffers must not overlap.
+ */
+void *fast_memcpy(void *dst, const void *src, size_t len);
+
+/**
+ * memset().
+ */
+void *fast_memset(void *dst, int c, size_t len);
+
+/**
+ * memcmp().
+ */
+int fast_memcmp(const void *a, const void *b, size_t len);
+
+/**
+ * Longest buffer /mem_selftest checks, bytes: two bursts of the copy and
+ * fill, with the byte and word tails around them.
+ */
+#define FASTMEM_TEST_LEN	80
+
+/**
+ * Check the fast functions against the byte at a time result, for every
+ * source and destination misalignment (0 .. 3) and every length up to
+ * max_len.  The copy and the fill must leave the bytes around the
+ * destination alone; the compare is checked on equal buffers and with
+ * one byte different, near either end and in the middle.  The buffers
+ * come from the FreeRTOS heap for the duration.
+ *
+ * \param max_len Longest length, up to FASTMEM_BENCH_MAX.
+ * \returns The number of wrong results, -1 if max_len is too big or the
+ * buffers can't be had.
+ */
+int fastmem_selftest(size_t max_len);
+
+/**
+ * The functions fastmem_bench() times.
+ */
+enum fastmem_op {
+	fmCopy,			/**< memcpy() */
+	fmSet,			/**< memset() */
+	fmCompare,		/**< memcmp(), equal buffers */
+	fmInvalid		/**< Invalid flag, MUST BE LAST */
+};
+
+/**
+ * Longest buffer fastmem_bench() times, bytes.
+ */
+#define FASTMEM_BENCH_MAX	1536
+
+/**
+ * Benchmark result, CPU clocks per call.
+ */
+struct fastmem_bench_s {
+	uint32_t lib[fmInvalid];	/**< The C library's function */
+	uint32_t fast[fmInvalid];	/**< fast_xxx() */
+};
+
+/**
+ * Time the C library's and the fast functions on one buffer size: the
+ * best of a few calls each, less the timing overhead.  The buffers come
+ * from the FreeRTOS heap for the duration.
+ *
+ * \param len Buffer size, bytes, up to FASTMEM_BENCH_MAX.
+ * \param offset Misalignment of the source, 0 .. 3 bytes.
+ * \param fb Filled in with the results.
+ * \returns 0, -1 if the size is too big or the buffers can't be had.
+ */
+int fastmem_bench(size_t len, int offset, struct fastmem_bench_s *fb);
+
+#endif /* FASTMEM_H_ */
+/** \} */
@@ -36,6 +36,7 @@
 #include "../../obj/fsdata-stats.c"
 #include "../../obj/fsdata.c"
 #include <string.h>
+#include "fastmem.h"
 #include "logger.h"
 /*-----------------------------------------------------------------------------------*/
 /* Define the number of open files that we can support. */
@@ -191,7 +192,7 @@ fs_read(struct fs_file *file, char *buffer, int count)
     read = count;
   }
 
-  memcpy(buffer, (file->data + file->index), read);
+  fast_memcpy(buffer, (file->data + file->index), read);
   file->index += read;
 
   //lhex(read);lstr(">");
@@ -0,0 +1,303 @@
+/**
+ * \file heap_quick.c
+ *
+ * FreeRTOS heap: first fit, coalescing, with quick lists for small blocks.
+
+\page heapquickpage1 Heap Overview
+
+This replaces the kernel's heap_2.c, which keeps its free blocks sorted
+by size and never merges neighbours, so a long uptime of allocations of
+varying sizes (task create / delete, lwIP sys_arch semaphores and mail
+boxes) cuts the heap into pieces too small to use.
+
+The free list here is sorted by address instead, and a freed block is
+merged with the free blocks on either side, so the free space is only
+ever cut up by blocks in use.  Allocation is first fit, splitting off the
+remainder when it can hold a block of its own.
+
+Walking the list for each of the many small allocations of the same few
+sizes (TCBs, queues, semaphores) would be slow, so blocks up to
+HEAP_QUICK_MAX bytes are freed onto a quick list of their exact size
+(like the fast bins of dlmalloc) and handed straight back out by the next
+allocation of that size, without merging or splitting.  Those blocks are
+not lost to fragmentation: when nothing on the free list fits, all the
+quick lists are merged back into it and the fit is tried again.
+
+Everything runs with the scheduler suspended, as heap_2 does, so the heap
+must not be used from interrupts.  heap_stats_get() returns the counters
+and walks the free list for the largest block; /mem_stats reports them.
+
+test/heapsoak.c (make host-test) runs millions of random allocations and
+frees on the host and checks the lists and the counters after each.
+
+ *
+ * \addtogroup util Utilities
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#include <stdlib.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from
+redefining all the API functions to use the MPU wrappers. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include <config.h>
+#include <heap_quick.h>
+
+/*
+ * A block: the header, then the user's bytes.  size includes the header.
+ * next links free blocks in address order, it is NULL while in use.
+ */
+struct block_s {
+	struct block_s *next;
+	size_t size;
+};
+
+#define ALIGN_UP(n)	(((n) + portBYTE_ALIGNMENT_MASK) & \
+				~(size_t)portBYTE_ALIGNMENT_MASK)
+#define HDR_SIZE	ALIGN_UP(sizeof(struct block_s))
+#define MIN_BLOCK	(HDR_SIZE * 2)	/* smallest block worth splitting off */
+
+/*
+ * Quick lists, one per block size up to HEAP_QUICK_MAX.
+ */
+#define QUICK_SLOT(size)	((size) / portBYTE_ALIGNMENT)
+#define QUICK_SLOTS		(QUICK_SLOT(HEAP_QUICK_MAX) + 1)
+
+/*
+ * Private information.
+ */
+static union {
+	unsigned long long dummy;	/* alignment */
+	unsigned char bytes[configTOTAL_HEAP_SIZE];
+} heap;
+
+static struct block_s start;		/* free list head, size 0 */
+static struct block_s *quick[QUICK_SLOTS];
+static struct heap_stats_s stats;
+static int initialized;
+
+/****************************************************************************/
+
+/*
+ * Make the whole heap one free block.
+ */
+static void heap_init(void)
+{
+	struct block_s *blk;
+
+	blk = (struct block_s *)ALIGN_UP((size_t)heap.bytes);
+	blk->next = NULL;
+	blk->size = (heap.bytes + sizeof(heap.bytes) - (unsigned char *)blk) &
+		~(size_t)portBYTE_ALIGNMENT_MASK;
+
+	start.next = blk;
+	start.size = 0;
+
+	stats.size = stats.free = stats.min_free = blk->size;
+	initialized = 1;
+}
+
+/*
+ * Put a block on the free list, merging it with its neighbours.
+ */
+static void insert_free(struct block_s *blk)
+{
+	struct block_s *prev;
+	struct block_s *next;
+
+	for (prev = &start; (prev->next != NULL) && (prev->next < blk);
+			prev = prev->next)
+		;
+	next = prev->next;
+
+	if ((next != NULL) && ((unsigned char *)blk + blk->size ==
+			(unsigned char *)next)) {
+		blk->size += next->size;
+		next = next->next;
+	}
+	if ((prev != &start) && ((unsigned char *)prev + prev->size ==
+			(unsigned char *)blk)) {
+		prev->size += blk->size;
+		prev->next = next;
+	} else {
+		blk->next = next;
+		prev->next = blk;
+	}
+}
+
+/*
+ * Merge all the quick lists back into the free list.
+ */
+static void flush_quick(void)
+{
+	struct block_s *blk;
+	int j;
+
+	for (j = 0; j < QUICK_SLOTS; j++) {
+		while ((blk = quick[j]) != NULL) {
+			quick[j] = blk->next;
+			insert_free(blk);
+		}
+	}
+	stats.quick = 0;
+	stats.flushes++;
+}
+
+/*
+ * First fit from the free list, splitting off the rest.
+ */
+static struct block_s *first_fit(size_t size)
+{
+	struct block_s *prev;
+	struct block_s *blk;
+	struct block_s *rest;
+
+	for (prev = &start; (blk = prev->next) != NULL; prev = blk) {
+		if (blk->size < size)
+			continue;
+		if (blk->size - size >= MIN_BLOCK) {
+			rest = (struct block_s *)((unsigned char *)blk + size);
+			rest->size = blk->size - size;
+			rest->next = blk->next;
+			prev->next = rest;
+			blk->size = size;
+		} else {
+			prev->next = blk->next;
+		}
+		return blk;
+	}
+	return NULL;
+}
+
+/****************************************************************************/
+
+void *pvPortMalloc(size_t xWantedSize)
+{
+	struct block_s *blk = NULL;
+	size_t size;
+	void *pvReturn = NULL;
+
+	vTaskSuspendAll();
+	{
+		if (!initialized)
+			heap_init();
+
+		size = ALIGN_UP(xWantedSize + HDR_SIZE);
+		if (size < MIN_BLOCK)
+			size = MIN_BLOCK;
+
+		if ((xWantedSize > 0) && (size > xWantedSize)) {
+			if ((size <= HEAP_QUICK_MAX) &&
+			    ((blk = quick[QUICK_SLOT(size)]) != NULL)) {
+				quick[QUICK_SLOT(size)] = blk->next;
+				stats.quick -= size;
+				stats.quick_hits++;
+			} else if (((blk = first_fit(size)) == NULL) &&
+				   (stats.quick != 0)) {
+				flush_quick();
+				blk = first_fit(size);
+			}
+		}
+
+		if (blk != NULL) {
+			blk->next = NULL;
+			stats.free -= blk->size;
+			if (stats.free < stats.min_free)
+				stats.min_free = stats.free;
+			stats.allocs++;
+			pvReturn = (unsigned char *)blk + HDR_SIZE;
+		} else {
+			stats.fails++;
+		}
+	}
+	xTaskResumeAll();
+
+#if (configUSE_MALLOC_FAILED_HOOK == 1)
+	if (pvReturn == NULL) {
+		extern void vApplicationMallocFailedHook(void);
+		vApplicationMallocFailedHook();
+	}
+#endif
+
+	return pvReturn;
+}
+
+/****************************************************************************/
+
+void vPortFree(void *pv)
+{
+	struct block_s *blk;
+
+	/* Static task stacks aren't ours, vTaskDelete() frees any stack. */
+	if ((pv < (void *)heap.bytes) ||
+	    (pv >= (void *)(heap.bytes + sizeof(heap.bytes))))
+		return;
+
+	blk = (struct block_s *)((unsigned char *)pv - HDR_SIZE);
+
+	vTaskSuspendAll();
+	{
+		stats.free += blk->size;
+		stats.frees++;
+		if (blk->size <= HEAP_QUICK_MAX) {
+			blk->next = quick[QUICK_SLOT(blk->size)];
+			quick[QUICK_SLOT(blk->size)] = blk;
+			stats.quick += blk->size;
+		} else {
+			insert_free(blk);
+		}
+	}
+	xTaskResumeAll();
+}
+
+/****************************************************************************/
+
+size_t xPortGetFreeHeapSize(void)
+{
+	return stats.free;
+}
+
+/****************************************************************************/
+
+void vPortInitialiseBlocks(void)
+{
+	/* Only required when static memory is not cleared. */
+}
+
+/****************************************************************************/
+
+/*
+ * Get the statistics.
+ */
+void heap_stats_get(struct heap_stats_s *hs)
+{
+	struct block_s *blk;
+
+	vTaskSuspendAll();
+	{
+		if (!initialized)
+			heap_init();
+
+		*hs = stats;
+		hs->largest = 0;
+		hs->blocks = 0;
+		for (blk = start.next; blk != NULL; blk = blk->next) {
+			hs->blocks++;
+			if (blk->size > hs->largest)
+				hs->largest = blk->size;
+		}
+	}
+	xTaskResumeAll();
+}
+/** \} */
@@ -0,0 +1,47 @@
+/**
+ * \file heap_quick.h
+ *
+ * FreeRTOS heap (pvPortMalloc() / vPortFree()) definitions and
+ * declarations.
+ *
+ * \addtogroup util Utilities
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#ifndef HEAP_QUICK_H_
+#define HEAP_QUICK_H_
+
+#include <stddef.h>
+
+/**
+ * Heap statistics, bytes unless noted.  Block sizes include their header.
+ */
+struct heap_stats_s {
+	size_t size;		/**< configTOTAL_HEAP_SIZE, less the alignment */
+	size_t free;		/**< Free now, including the quick lists */
+	size_t min_free;	/**< Low water mark of free */
+	size_t largest;		/**< Largest free block */
+	size_t quick;		/**< Free in the quick lists */
+	unsigned blocks;	/**< Free blocks, not in the quick lists */
+	unsigned long allocs;	/**< pvPortMalloc() calls that succeeded */
+	unsigned long frees;	/**< vPortFree() calls */
+	unsigned long quick_hits; /**< Allocations from a quick list */
+	unsigned long flushes;	/**< Quick lists merged back for a fit */
+	unsigned long fails;	/**< pvPortMalloc() calls that failed */
+};
+
+/**
+ * Get the heap statistics.  Walks the free list with the scheduler
+ * suspended.
+ *
+ * \param hs Filled in with the statistics.
+ */
+void heap_stats_get(struct heap_stats_s *hs);
+
+#endif /* HEAP_QUICK_H_ */
+/** \} */
@@ -0,0 +1,278 @@
+/**
+ * \file history.c
+ *
+ * I/O point history.
+
+\page historypage1 I/O History Overview
+
+A web page that wants a trend chart would otherwise have to poll the
+I/O forever and can never show what happened before it was opened.
+The history store keeps the recent past of selected I/O points in RAM
+so a client gets a backfilled trend in one request.
+
+Each point is kept at three resolutions (tiers):
+- Tier 0: every io_task() scan (IO_POLL_HZ).
+- Tier 1: the average of HIST_T1_DECIMATE tier 0 samples.
+- Tier 2: the average of HIST_T2_DECIMATE tier 1 samples.
+
+Samples are delta encoded in 16 byte blocks (see struct hist_block_s),
+so a slowly changing input costs about 1.3 bytes per sample.  Each tier
+is a ring of blocks: the time covered depends on how well the data
+compresses, at least HIST_Tn_BLOCKS samples and at best
+(HIST_BLOCK_DELTAS + 1) times that.
+
+A/D points are recorded in filtered A/D counts (adc(which, raw)); the
+/history CGI can scale them with the channel's current calibration.
+Discretes are recorded as 0 or 100 so the coarser tiers show the duty
+cycle in percent.
+
+ *
+ * \addtogroup io I/O
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#include <FreeRTOS.h>
+#include <semphr.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <config.h>
+#include <io.h>
+#include <history.h>
+#include <logger.h>
+
+#define HIST_TIMEOUT	(configTICK_RATE_HZ / 100)
+
+/*
+ * Public information.
+ */
+
+/**
+ * The points that are recorded.
+ */
+const struct hist_point_s hist_points[] = {
+	{ histAdc, adcProc0 },
+	{ histAdc, adcProcTemp },
+};
+#define NUM_POINTS	(sizeof(hist_points) / sizeof(hist_points[0]))
+
+const int hist_num_points = NUM_POINTS;
+
+/*
+ * Private information.
+ */
+
+/**
+ * One resolution tier of one point.
+ */
+struct tier_s {
+	struct hist_block_s *ring;	/**< Block storage */
+	int size;			/**< Blocks in the ring */
+	int head;			/**< Newest block */
+	int used;			/**< Blocks holding data */
+	uint32_t samples;		/**< Samples ever recorded */
+	int32_t last;			/**< Newest sample */
+	int32_t acc;			/**< Decimation sum for the next tier */
+	int acc_n;			/**< Samples in acc */
+};
+
+static struct hist_block_s t0_store[NUM_POINTS][HIST_T0_BLOCKS];
+static struct hist_block_s t1_store[NUM_POINTS][HIST_T1_BLOCKS];
+static struct hist_block_s t2_store[NUM_POINTS][HIST_T2_BLOCKS];
+
+static struct tier_s tiers[NUM_POINTS][HIST_TIERS];
+
+static const int decimate[HIST_TIERS] = {
+	1, HIST_T1_DECIMATE, HIST_T2_DECIMATE
+};
+
+/** Mutex for exclusive access to the history. */
+static xSemaphoreHandle hist_mutex;
+
+/****************************************************************************/
+
+/*
+ * Append a sample to a tier.
+ */
+static void append(struct tier_s *t, int32_t val)
+{
+	struct hist_block_s *blk = &t->ring[t->head];
+	int32_t delta = val - t->last;
+
+	if ((t->used == 0) || (blk->count > HIST_BLOCK_DELTAS) ||
+	    (delta < -128) || (delta > 127)) {
+		/*
+		 * Start a new block, dropping the oldest if full.
+		 */
+		if (t->used != 0 && ++t->head >= t->size)
+			t->head = 0;
+		if (t->used < t->size)
+			t->used++;
+		blk = &t->ring[t->head];
+		blk->base  = val;
+		blk->count = 1;
+	} else {
+		blk->delta[blk->count - 1] = delta;
+		blk->count++;
+	}
+	t->last = val;
+	t->samples++;
+}
+
+/****************************************************************************/
+
+/*
+ * Record one sample of every point.
+ */
+void hist_sample(void)
+{
+	struct tier_s *t;
+	int32_t val;
+	int p, j;
+
+	if (hist_mutex == NULL)
+		return;
+
+	for (p = 0; p < NUM_POINTS; p++) {
+		if (hist_points[p].kind == histAdc)
+			val = adc(hist_points[p].which, raw);
+		else
+			val = dio(hist_points[p].which) ? 100 : 0;
+
+		if (xSemaphoreTake(hist_mutex, HIST_TIMEOUT) != pdTRUE)
+			continue;
+		/*
+		 * Each tier feeds its average into the next one.
+		 */
+		for (j = 0; j < HIST_TIERS; j++) {
+			t = &tiers[p][j];
+			append(t, val);
+			if (j == HIST_TIERS - 1)
+				break;
+			t->acc += val;
+			if (++t->acc_n < decimate[j + 1])
+				break;
+			val = (t->acc + (t->acc_n / 2)) / t->acc_n;
+			t->acc = 0;
+			t->acc_n = 0;
+		}
+		xSemaphoreGive(hist_mutex);
+	}
+}
+
+/****************************************************************************/
+
+/*
+ * Get the sample period of a tier.
+ */
+uint32_t hist_period_ms(int tier)
+{
+	uint32_t ms = 1000 / IO_POLL_HZ;
+	int j;
+
+	for (j = 1; (j <= tier) && (j < HIST_TIERS); j++)
+		ms *= decimate[j];
+	return ms;
+}
+
+/****************************************************************************/
+
+/*
+ * Copy a header and the newest blocks of a point's tier into a buffer.
+ * The buffer needn't be aligned, everything is copied with memcpy().
+ */
+int hist_read(int point, int tier, int start, char *buf, int size)
+{
+	struct hist_hdr_s hdr;
+	struct tier_s *t;
+	char *bp;
+	uint32_t newest;
+	int max;
+	int idx;
+	int n;
+	int j;
+
+	if ((point < 0) || (point >= NUM_POINTS) ||
+	    (tier < 0) || (tier >= HIST_TIERS) || (start < 0) ||
+	    (hist_mutex == NULL) || (size < (int)sizeof(hdr)))
+		return -1;
+
+	t = &tiers[point][tier];
+	max = (size - sizeof(hdr)) / sizeof(struct hist_block_s);
+
+	hdr.magic     = HIST_MAGIC;
+	hdr.version   = HIST_VERSION;
+	hdr.point     = point;
+	hdr.tier      = tier;
+	hdr.period_ms = hist_period_ms(tier);
+
+	if (xSemaphoreTake(hist_mutex, HIST_TIMEOUT) != pdTRUE)
+		return -1;
+
+	if (start > t->used)
+		start = t->used;
+	n = t->used - start;
+	if (n > max)
+		n = max;
+
+	/* Step back over the skipped blocks for the newest sample number. */
+	newest = t->samples - 1;
+	idx = t->head;
+	for (j = 0; j < start; j++) {
+		newest -= t->ring[idx].count;
+		if (--idx < 0)
+			idx += t->size;
+	}
+
+	idx = idx - n + 1;
+	if (idx < 0)
+		idx += t->size;
+	bp = buf + sizeof(hdr);
+	for (j = 0; j < n; j++) {
+		memcpy(bp, &t->ring[idx], sizeof(struct hist_block_s));
+		bp += sizeof(struct hist_block_s);
+		if (++idx >= t->size)
+			idx = 0;
+	}
+	hdr.newest  = newest;
+	hdr.nblocks = n;
+	hdr.older   = t->used - start - n;
+
+	xSemaphoreGive(hist_mutex);
+
+	memcpy(buf, &hdr, sizeof(hdr));
+	return bp - buf;
+}
+
+/****************************************************************************/
+
+/*
+ * Initialize the history store.
+ */
+int hist_init(void)
+{
+	int p;
+
+	for (p = 0; p < NUM_POINTS; p++) {
+		memset(tiers[p], 0, sizeof(tiers[p]));
+		tiers[p][0].ring = t0_store[p];
+		tiers[p][0].size = HIST_T0_BLOCKS;
+		tiers[p][1].ring = t1_store[p];
+		tiers[p][1].size = HIST_T1_BLOCKS;
+		tiers[p][2].ring = t2_store[p];
+		tiers[p][2].size = HIST_T2_BLOCKS;
+	}
+
+	hist_mutex = xSemaphoreCreateMutex();
+	if (hist_mutex == NULL) {
+		lprintf("hist_init() mutex create failed\r\n");
+		return -1;
+	}
+	return 0;
+}
+/** \} */
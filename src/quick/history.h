@@ -0,0 +1,133 @@
+/**
+ * \file history.h
+ *
+ * I/O point history definitions and declarations.
+ *
+ * \addtogroup io I/O
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#ifndef HISTORY_H_
+#define HISTORY_H_
+
+#include <stdint.h>
+
+/**
+ * Magic number at the start of the binary history blob ("HIST").
+ */
+#define HIST_MAGIC		0x54534948UL
+
+/**
+ * Binary history blob format version.
+ */
+#define HIST_VERSION		2
+
+/**
+ * Number of resolution tiers.
+ */
+#define HIST_TIERS		3
+
+/**
+ * Deltas per block; a block holds up to HIST_BLOCK_DELTAS + 1 samples.
+ */
+#define HIST_BLOCK_DELTAS	11
+
+/**
+ * A delta-encoded run of consecutive samples: the first sample is
+ * stored whole, each following one as a signed 8 bit difference from
+ * its predecessor.  A difference that doesn't fit starts a new block.
+ * Blocks in a tier are contiguous in time; the newest sample of the
+ * newest block is sample number hist_hdr_s.newest of the tier.
+ */
+struct hist_block_s {
+	int32_t base;			/**< First sample */
+	uint8_t count;			/**< Samples in the block (1..12) */
+	int8_t  delta[HIST_BLOCK_DELTAS]; /**< Differences */
+};
+
+/**
+ * Header of the binary history blob, followed by nblocks blocks,
+ * oldest first.  The blocks are a page of the tier: older blocks that
+ * didn't fit are left for a later read with a bigger start.
+ */
+struct hist_hdr_s {
+	uint32_t magic;		/**< HIST_MAGIC */
+	uint16_t version;	/**< HIST_VERSION */
+	uint8_t  point;		/**< History point index */
+	uint8_t  tier;		/**< Tier */
+	uint32_t period_ms;	/**< Sample period of the tier */
+	uint32_t newest;	/**< Sample number of the newest sample */
+	uint32_t nblocks;	/**< Blocks that follow */
+	uint32_t older;		/**< Blocks held older than these */
+};
+
+/**
+ * Kind of I/O point being recorded.
+ */
+enum hist_kind {
+	histAdc,		/**< A/D, recorded in (filtered) counts */
+	histDio			/**< Discrete, recorded as 0 or 100 (%) */
+};
+
+/**
+ * A recorded I/O point.
+ */
+struct hist_point_s {
+	enum hist_kind kind;	/**< A/D or discrete */
+	int which;		/**< enum adc_sel or enum dio_sel */
+};
+
+/**
+ * The recorded points (index is the point number).
+ */
+extern const struct hist_point_s hist_points[];
+
+/**
+ * Number of recorded points.
+ */
+extern const int hist_num_points;
+
+/**
+ * Initialize the history store.
+ *
+ * \returns 0 on success, -1 on failure.
+ */
+int hist_init(void);
+
+/**
+ * Record one sample of every point into tier 0 (and the coarser tiers
+ * as their decimation comes due).  Called by io_task() every scan.
+ */
+void hist_sample(void);
+
+/**
+ * Get the sample period of a tier.
+ *
+ * \param tier The tier.
+ * \returns The period in milliseconds.
+ */
+uint32_t hist_period_ms(int tier);
+
+/**
+ * Get a page of a point's tier as a binary blob: a struct hist_hdr_s
+ * followed by as many blocks as fit, oldest first, the newest of them
+ * start blocks back from the newest of the tier.  hdr.older says how
+ * many are left for the next page (start + nblocks).  Host byte order
+ * (little endian), no padding.
+ *
+ * \param point The history point.
+ * \param tier The tier.
+ * \param start Blocks to skip back from the newest, 0 for the newest.
+ * \param buf Where to put the blob (needn't be aligned).
+ * \param size Size of buf in bytes.
+ * \returns The length of the blob, -1 if point or tier is invalid.
+ */
+int hist_read(int point, int tier, int start, char *buf, int size);
+
+#endif
+/** \} */
@@ -51,21 +51,34 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdarg.h>
 
 #include <lwip/opt.h>
 #include <lwip/debug.h>
 #include <lwip/stats.h>
 #include <LWIPStack.h>
+#include <ETHIsr.h>
 #include <httpd.h>
 #include <httpd-cgi.h>
 
 #include <hw_types.h>
 #include <hw_memmap.h>
 #include <io.h>
+#include <dioevent.h>
+#include <adccap.h>
+#include <history.h>
+#include <taskstats.h>
+#include <latency.h>
+#include <memstats.h>
+#include <heap_quick.h>
+#include <fastmem.h>
+#include <util.h>
+#include <syslog.h>
 #include <gpio.h>
 
 #include <config.h>
 #include <partnum.h>
+#include <kvcfg.h>
 
 #include <fs.h>
 #include <fsdata.h>
@@ -106,6 +119,30 @@ static inline void split_eng(int a, int *integer, int *fract)
 
 /*---------------------------------------------------------------------------*/
 
+/*
+ * Room kept for the end of a JSON reply whose records are dropped whole
+ * when they don't fit.
+ */
+#define REPLY_ROOM	32
+
+/*
+ * Append formatted text.  Returns the new length, limited to size - 1
+ * like json_str().
+ */
+static int append(char *buf, int len, int size, const char *fmt, ...)
+{
+	va_list ap;
+
+	if (len >= size - 1)
+		return size - 1;
+	va_start(ap, fmt);
+	len += vsnprintf(buf + len, size - len, fmt, ap);
+	va_end(ap);
+	return (len > size - 1) ? size - 1 : len;
+}
+
+/*---------------------------------------------------------------------------*/
+
 unsigned int refreshCount = 0;
 static char cCountBuf[32];
 
@@ -147,6 +184,607 @@ static int rtos_stats(int index, int iNumParams,
 
 /*---------------------------------------------------------------------------*/
 
+/*
+ * Room for the HTTP header in front of the binary task statistics.
+ */
+#define TASK_STATS_HTTP_ROOM	160
+
+/*
+ * Task statistics without formatting a text table under the scheduler
+ * lock (see taskstats.c).
+ *   /task_stats			JSON
+ *   /task_stats?fmt=bin		binary blob (see taskstats.h)
+ * cpu and cpu_total are in hundredths of a percent, stack in words.
+ * window, total and the sleep times are in run time counts.
+ */
+static int task_stats(int index, int iNumParams,
+		char *pcParam[], char *pcValue[], char **resultBuffer)
+{
+	static const char *statestr[] = {
+		"running", "ready", "blocked", "suspended", "deleted"
+	};
+	struct task_stats_hdr_s hdr;
+	struct task_stats_rec_s rec;
+	char name[TASK_STATS_NAME_LEN + 1];
+	char *blob;
+	int blen;
+	int hdrlen;
+	int room;
+	int len;
+	int bin = 0;
+	int n;
+	int j;
+
+	*resultBuffer = uip_appdata;
+
+	for (j = 0; j < iNumParams; j++) {
+		if (strcmp(pcParam[j], "fmt") == 0)
+			bin = (strcmp(pcValue[j], "bin") == 0);
+	}
+
+	if (bin) {
+		blen = task_stats_read(uip_appdata + TASK_STATS_HTTP_ROOM,
+			UIP_APPDATA_SIZE - TASK_STATS_HTTP_ROOM);
+		hdrlen = snprintf((char *)uip_appdata, TASK_STATS_HTTP_ROOM,
+			"HTTP/1.1 200 OK\r\n"
+			"Server: lwIP/CGI (FreeRTOS)\r\n"
+			"Content-type: application/octet-stream\r\n"
+			"Content-length: %d\r\n"
+			"Cache-control: no-cache\r\n\r\n", blen);
+		memmove(uip_appdata + hdrlen,
+			uip_appdata + TASK_STATS_HTTP_ROOM, blen);
+		return hdrlen + blen;
+	}
+
+	/*
+	 * JSON: the blob goes at the end of the scratch buffer and is
+	 * decoded into the front, one record at a time.
+	 */
+	blen = sizeof(hdr) + TASK_STATS_MAX * sizeof(rec);
+	blob = uip_appdata + UIP_APPDATA_SIZE - blen;
+	task_stats_read(blob, blen);
+	memcpy(&hdr, blob, sizeof(hdr));
+	blob += sizeof(hdr);
+
+	len = snprintf((char *)uip_appdata, UIP_APPDATA_SIZE,
+		"HTTP/1.1 200 OK\r\n"
+		"Server: lwIP/CGI (FreeRTOS)\r\n"
+		"Content-type: application/json\r\n"
+		"Cache-control: no-cache\r\n\r\n"
+
+		"{\"ticks\": %u, \"window\": %u, \"total\": %u"
+		", \"sleep\": %u, \"sleep_total\": %u, \"tasks\": [",
+		(unsigned)hdr.ticks, (unsigned)hdr.window,
+		(unsigned)hdr.total, (unsigned)hdr.sleep_window,
+		(unsigned)hdr.sleep_total);
+
+	for (j = 0; j < hdr.ntasks; j++) {
+		memcpy(&rec, blob + j * sizeof(rec), sizeof(rec));
+		memcpy(name, rec.name, TASK_STATS_NAME_LEN);
+		name[TASK_STATS_NAME_LEN] = '\0';
+		/*
+		 * The text may use the records already copied out, not
+		 * the next one.  A record that doesn't fit is dropped
+		 * whole and counted.
+		 */
+		room = (blob + (j + 1) * sizeof(rec)) -
+			((char *)uip_appdata + len);
+		if (room <= 0)
+			break;
+		n = snprintf((char *)uip_appdata + len, room,
+			"%s{\"name\": \"%s\", \"pri\": %d, \"state\": \"%s\""
+			", \"stack\": %d, \"cpu\": %d, \"cpu_total\": %d}",
+			j ? ", " : "", name, rec.priority,
+			(rec.state <= taskDeleted) ? statestr[rec.state] : "?",
+			rec.stack_free, rec.cpu_window, rec.cpu_total);
+		if (n >= room)
+			break;
+		len += n;
+	}
+	len += snprintf((char *)uip_appdata + len, UIP_APPDATA_SIZE - len,
+		"], \"dropped\": %d}", (int)hdr.ntasks - j);
+	return len;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Task CPU and stack budgets (see util.c).
+ *   /supervisor		JSON
+ * cpu is in hundredths of a percent, stack in words.
+ */
+static int supervisor(int index, int iNumParams,
+		char *pcParam[], char *pcValue[], char **resultBuffer)
+{
+	struct task_super_s sup;
+	int limit = UIP_APPDATA_SIZE - REPLY_ROOM;
+	char *buf = (char *)uip_appdata;
+	int dropped = 0;
+	int start;
+	int mark;
+	int len;
+	int j;
+
+	*resultBuffer = uip_appdata;
+
+	len = snprintf(buf, UIP_APPDATA_SIZE,
+		"HTTP/1.1 200 OK\r\n"
+		"Server: lwIP/CGI (FreeRTOS)\r\n"
+		"Content-type: application/json\r\n"
+		"Cache-control: no-cache\r\n\r\n"
+
+		"{\"tasks\": [");
+
+	start = len;
+	for (j = 0; j < TASK_STATS_MAX; j++) {
+		if (util_super_get(j, &sup) != 0)
+			continue;
+		if (dropped) {
+			dropped++;
+			continue;
+		}
+		mark = len;
+		len = append(buf, len, limit,
+			"%s{\"name\": \"%s\", \"cpu\": %d, \"cpu_max\": %d"
+			", \"stack\": %d, \"stack_min\": %d"
+			", \"cpu_over\": %d, \"stack_over\": %d"
+			", \"cpu_viol\": %d, \"stack_viol\": %d}",
+			(mark == start) ? "" : ", ", sup.name, sup.cpu,
+			sup.cpu_max, sup.stack, sup.stack_min,
+			(sup.over & SUPER_OVER_CPU) != 0,
+			(sup.over & SUPER_OVER_STACK) != 0,
+			sup.cpu_viol, sup.stack_viol);
+		if (len >= limit - 1) {
+			len = mark;
+			dropped = 1;
+		}
+	}
+	len = append(buf, len, UIP_APPDATA_SIZE,
+		"], \"dropped\": %d, \"syslog_dropped\": %u}", dropped,
+		(unsigned)syslog_dropped());
+	return len;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Latency and jitter histograms (see latency.c).
+ *   /latency			JSON
+ *   /latency?reset=1		clear them (reports the old values)
+ *   /latency?probe=secs		run the ISR entry probe for secs,
+ *				LATENCY_PROBE_SECS if 1, stop it if 0
+ * Times are in CPU clocks; buckets[n] counts 2^(n-1) .. 2^n - 1 clocks.
+ * probe is the seconds the ISR entry probe has left.  Histograms that
+ * don't fit are counted in "dropped".
+ */
+static int latency(int index, int iNumParams,
+		char *pcParam[], char *pcValue[], char **resultBuffer)
+{
+	struct latency_hist_s hist;
+	int limit = UIP_APPDATA_SIZE - REPLY_ROOM;
+	char *buf = (char *)uip_appdata;
+	int dropped = 0;
+	int reset = 0;
+	int probe;
+	int mark;
+	int len;
+	int j, k;
+
+	*resultBuffer = uip_appdata;
+
+	for (j = 0; j < iNumParams; j++) {
+		if (strcmp(pcParam[j], "reset") == 0) {
+			reset = strtol(pcValue[j], NULL, 10);
+		} else if (strcmp(pcParam[j], "probe") == 0) {
+			probe = strtol(pcValue[j], NULL, 10);
+			if (probe == 1)
+				probe = LATENCY_PROBE_SECS;
+			latency_probe((probe > 0) ? probe : 0);
+		}
+	}
+
+	len = snprintf(buf, UIP_APPDATA_SIZE,
+		"HTTP/1.1 200 OK\r\n"
+		"Server: lwIP/CGI (FreeRTOS)\r\n"
+		"Content-type: application/json\r\n"
+		"Cache-control: no-cache\r\n\r\n"
+
+		"{\"clock_hz\": %u, \"probe\": %u",
+		(unsigned)configCPU_CLOCK_HZ, latency_probe_left());
+
+	for (j = latIsrEntry; j < latInvalid; j++) {
+		if (dropped) {
+			dropped++;
+			continue;
+		}
+		latency_get(j, &hist);
+		mark = len;
+		len = append(buf, len, limit,
+			", \"%s\": {\"count\": %u, \"min\": %u, \"max\": %u"
+			", \"buckets\": [",
+			latencytostr(j), (unsigned)hist.count,
+			(unsigned)hist.min, (unsigned)hist.max);
+		for (k = 0; k < LATENCY_BUCKETS; k++) {
+			len = append(buf, len, limit, "%s%u",
+				k ? "," : "", (unsigned)hist.bucket[k]);
+		}
+		len = append(buf, len, limit, "]}");
+		if (len >= limit - 1) {
+			len = mark;
+			dropped = 1;
+		}
+	}
+	len = append(buf, len, UIP_APPDATA_SIZE, ", \"dropped\": %d}",
+		dropped);
+
+	if (reset)
+		latency_reset();
+
+	return len;
+}
+
+/*---------------------------------------------------------------------------*/
+
+#if LWIP_STATS
+/*
+ * Append one lwIP protocol's counters as JSON.  Returns the new length,
+ * or mark if they don't fit below limit.
+ */
+static int proto_stats(char *buf, int len, int limit, const char *name,
+		const struct stats_proto *sp)
+{
+	int mark = len;
+
+	len = append(buf, len, limit,
+		", \"%s\": {\"xmit\": %u, \"recv\": %u, \"fw\": %u"
+		", \"drop\": %u, \"chkerr\": %u, \"lenerr\": %u"
+		", \"memerr\": %u, \"rterr\": %u, \"proterr\": %u"
+		", \"opterr\": %u, \"err\": %u, \"cachehit\": %u}",
+		name, sp->xmit, sp->recv, sp->fw, sp->drop, sp->chkerr,
+		sp->lenerr, sp->memerr, sp->rterr, sp->proterr, sp->opterr,
+		sp->err, sp->cachehit);
+	return (len >= limit - 1) ? mark : len;
+}
+#endif
+
+/*
+ * Network interface statistics: the driver counters of each port
+ * (LWIPStack.c) and the lwIP protocol counters.
+ *   /net_stats			JSON
+ *   /net_stats?reset=1		clear the driver counters (reports the old
+ *				values)
+ * tx_wait_us is the time low_level_output() waited for the transmitter.
+ * The lwIP counters are written from every network task, so they aren't
+ * cleared.  A record that doesn't fit is left out, "truncated" says so.
+ */
+static int net_stats(int index, int iNumParams,
+		char *pcParam[], char *pcValue[], char **resultBuffer)
+{
+	struct eth_stats_s es;
+	int limit = UIP_APPDATA_SIZE - REPLY_ROOM;
+	char *buf = (char *)uip_appdata;
+	int truncated = 0;
+	int reset = 0;
+	int mark;
+	int len;
+	int j;
+
+	*resultBuffer = uip_appdata;
+
+	for (j = 0; j < iNumParams; j++) {
+		if (strcmp(pcParam[j], "reset") == 0)
+			reset = strtol(pcValue[j], NULL, 10);
+	}
+
+	len = snprintf(buf, UIP_APPDATA_SIZE,
+		"HTTP/1.1 200 OK\r\n"
+		"Server: lwIP/CGI (FreeRTOS)\r\n"
+		"Content-type: application/json\r\n"
+		"Cache-control: no-cache\r\n\r\n"
+
+		"{\"ports\": [");
+
+	for (j = 0; (j < MAX_ETH_PORTS) && !truncated; j++) {
+		eth_stats_get(j, &es);
+
+		mark = len;
+		len = append(buf, len, limit,
+			"%s{\"port\": %d, \"link\": %d"
+			", \"rx_frames\": %u, \"rx_bytes\": %u"
+			", \"rx_overflow\": %u, \"rx_nopbuf\": %u"
+			", \"tx_frames\": %u, \"tx_bytes\": %u"
+			", \"tx_nolink\": %u, \"tx_waits\": %u"
+			", \"tx_wait_us\": %u}",
+			j ? ", " : "", j, (int)ETHServiceTaskLinkStatus(j),
+			(unsigned)es.rx_frames, (unsigned)es.rx_bytes,
+			(unsigned)es.rx_overflow, (unsigned)es.rx_nopbuf,
+			(unsigned)es.tx_frames, (unsigned)es.tx_bytes,
+			(unsigned)es.tx_nolink, (unsigned)es.tx_waits,
+			(unsigned)(es.tx_wait_cycles /
+				(configCPU_CLOCK_HZ / 1000000)));
+		if (len >= limit - 1) {
+			len = mark;
+			truncated = 1;
+		}
+	}
+	if (reset)
+		eth_stats_reset();
+	len = append(buf, len, limit, "]");
+
+#if LWIP_STATS
+	{
+		static const struct {
+			const char *name;
+			const struct stats_proto *sp;
+		} protos[] = {
+			{ "link", &lwip_stats.link },
+			{ "etharp", &lwip_stats.etharp },
+			{ "ip", &lwip_stats.ip },
+			{ "tcp", &lwip_stats.tcp },
+			{ "udp", &lwip_stats.udp },
+		};
+
+		for (j = 0; (j < sizeof(protos) / sizeof(protos[0])) &&
+		     !truncated; j++) {
+			mark = len;
+			len = proto_stats(buf, len, limit, protos[j].name,
+				protos[j].sp);
+			if (len == mark)
+				truncated = 1;
+		}
+	}
+#endif
+	len = append(buf, len, UIP_APPDATA_SIZE, ", \"truncated\": %s}",
+		truncated ? "true" : "false");
+
+	return len;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * lwIP heap and pool usage (see memstats.c).
+ *   /mem_stats			JSON
+ *   /mem_stats?reset=1		start new high water marks (reports the
+ *				old values)
+ *   /mem_stats?log=1		also print them on the serial log
+ * Heap numbers are bytes, pool numbers are elements.  rtos_heap is the
+ * FreeRTOS heap (see heap_quick.c).  Pools that don't fit are counted in
+ * "dropped".
+ */
+static int mem_stats(int index, int iNumParams,
+		char *pcParam[], char *pcValue[], char **resultBuffer)
+{
+	struct memstats_s ms;
+	struct memstats_heap_s mh;
+	struct heap_stats_s hs;
+	int limit = UIP_APPDATA_SIZE - REPLY_ROOM;
+	char *buf = (char *)uip_appdata;
+	int dropped = 0;
+	int reset = 0;
+	int log = 0;
+	int start;
+	int mark;
+	int len;
+	int j;
+
+	*resultBuffer = uip_appdata;
+
+	for (j = 0; j < iNumParams; j++) {
+		if (strcmp(pcParam[j], "reset") == 0)
+			reset = strtol(pcValue[j], NULL, 10);
+		else if (strcmp(pcParam[j], "log") == 0)
+			log = strtol(pcValue[j], NULL, 10);
+	}
+
+	if (log)
+		memstats_log();
+
+	memstats_heap(&mh);
+	heap_stats_get(&hs);
+	len = snprintf(buf, UIP_APPDATA_SIZE,
+		"HTTP/1.1 200 OK\r\n"
+		"Server: lwIP/CGI (FreeRTOS)\r\n"
+		"Content-type: application/json\r\n"
+		"Cache-control: no-cache\r\n\r\n"
+
+		"{\"heap_free\": %u, \"heap_largest\": %u"
+		", \"heap_blocks\": %u"
+		", \"rtos_heap\": {\"size\": %u, \"free\": %u"
+		", \"min_free\": %u, \"largest\": %u, \"blocks\": %u"
+		", \"quick\": %u, \"allocs\": %u, \"frees\": %u"
+		", \"quick_hits\": %u, \"flushes\": %u, \"fails\": %u}"
+		", \"pools\": [",
+		mh.free, mh.largest, mh.blocks,
+		(unsigned)hs.size, (unsigned)hs.free, (unsigned)hs.min_free,
+		(unsigned)hs.largest, hs.blocks, (unsigned)hs.quick,
+		(unsigned)hs.allocs, (unsigned)hs.frees,
+		(unsigned)hs.quick_hits, (unsigned)hs.flushes,
+		(unsigned)hs.fails);
+	start = len;
+
+	/* The pools last, one that doesn't fit is dropped with the rest. */
+	for (j = 0; memstats_get(j, &ms) == 0; j++) {
+		if (dropped) {
+			dropped++;
+			continue;
+		}
+		mark = len;
+		len = append(buf, len, limit,
+			"%s{\"name\": \"%s\", \"size\": %u, \"used\": %u"
+			", \"max\": %u, \"err\": %u}",
+			(mark == start) ? "" : ", ", ms.name, ms.avail, ms.used,
+			ms.max, ms.err);
+		if (len >= limit - 1) {
+			len = mark;
+			dropped = 1;
+		}
+	}
+	len = append(buf, len, UIP_APPDATA_SIZE, "], \"dropped\": %d}",
+		dropped);
+
+	if (reset)
+		memstats_reset();
+
+	return len;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Room kept after the pool rows of mem_table() for the heap lines.
+ */
+#define MEM_TABLE_ROOM	160
+
+/*
+ * lwIP heap and pool usage table for mem.shtml.  Pool rows that don't fit
+ * are left out, a "..." row says so.
+ */
+static int mem_table(int index, int iNumParams,
+		char *pcParam[], char *pcValue[], char **resultBuffer)
+{
+	struct memstats_s ms;
+	struct memstats_heap_s mh;
+	struct heap_stats_s hs;
+	int limit = UIP_APPDATA_SIZE - MEM_TABLE_ROOM;
+	char *buf = (char *)uip_appdata;
+	int mark;
+	int len;
+	int j;
+
+	*resultBuffer = uip_appdata;
+
+	len = snprintf(buf, UIP_APPDATA_SIZE, MEMSTATS_HDR);
+	for (j = 0; memstats_get(j, &ms) == 0; j++) {
+		mark = len;
+		len = append(buf, len, limit, MEMSTATS_ROW,
+			ms.name, ms.avail, ms.used, ms.max, ms.err);
+		if (len >= limit - 1) {
+			len = append(buf, mark, UIP_APPDATA_SIZE, "...\r\n");
+			break;
+		}
+	}
+	memstats_heap(&mh);
+	len = append(buf, len, UIP_APPDATA_SIZE,
+		"\r\nHeap free %u in %u blocks, largest %u\r\n",
+		mh.free, mh.blocks, mh.largest);
+	heap_stats_get(&hs);
+	len = append(buf, len, UIP_APPDATA_SIZE,
+		"RTOS heap free %u (min %u) in %u blocks, largest %u"
+		", %u quick\r\n",
+		(unsigned)hs.free, (unsigned)hs.min_free, hs.blocks,
+		(unsigned)hs.largest, (unsigned)hs.quick);
+	return len;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * One /mem_bench run: C library, fast CPU clocks per call for each function.
+ */
+static int mem_bench_run(int len, int size, int offset, int first)
+{
+	struct fastmem_bench_s fb;
+
+	if (fastmem_bench(size, offset, &fb) != 0)
+		return len;
+	return len + snprintf((char *)uip_appdata + len, UIP_APPDATA_SIZE - len,
+		"%s{\"len\": %d, \"offset\": %d"
+		", \"memcpy\": [%u, %u], \"memset\": [%u, %u]"
+		", \"memcmp\": [%u, %u]}",
+		first ? "" : ", ", size, offset,
+		(unsigned)fb.lib[fmCopy], (unsigned)fb.fast[fmCopy],
+		(unsigned)fb.lib[fmSet], (unsigned)fb.fast[fmSet],
+		(unsigned)fb.lib[fmCompare], (unsigned)fb.fast[fmCompare]);
+}
+
+/*
+ * C library vs fast memcpy / memset / memcmp, CPU clocks per call (see
+ * fastmem.c).
+ *   /mem_bench			the sizes lwIP and fs_read() copy, with the
+ *				source aligned and one byte off
+ *   /mem_bench?len=n&offset=k	one size and source misalignment
+ * Runs in the tcp-ip thread, a few ms for the whole set.
+ */
+static int mem_bench(int index, int iNumParams,
+		char *pcParam[], char *pcValue[], char **resultBuffer)
+{
+	static const unsigned short sizes[] = { 4, 16, 64, 256, 1024, 1460 };
+	int size = -1;
+	int offset = 0;
+	int start;
+	int len;
+	int j;
+
+	*resultBuffer = uip_appdata;
+
+	for (j = 0; j < iNumParams; j++) {
+		if (strcmp(pcParam[j], "len") == 0)
+			size = strtol(pcValue[j], NULL, 10);
+		else if (strcmp(pcParam[j], "offset") == 0)
+			offset = strtol(pcValue[j], NULL, 10);
+	}
+
+	len = snprintf((char *)uip_appdata, UIP_APPDATA_SIZE,
+		"HTTP/1.1 200 OK\r\n"
+		"Server: lwIP/CGI (FreeRTOS)\r\n"
+		"Content-type: application/json\r\n"
+		"Cache-control: no-cache\r\n\r\n"
+
+		"{\"clock_hz\": %u, \"runs\": [", (unsigned)configCPU_CLOCK_HZ);
+
+	start = len;
+	if (size >= 0) {
+		len = mem_bench_run(len, size, offset, 1);
+	} else {
+		for (j = 0; j < (int)(sizeof(sizes) / sizeof(sizes[0])) * 2; j++)
+			len = mem_bench_run(len, sizes[j / 2], j % 2,
+				len == start);
+	}
+	len += snprintf((char *)uip_appdata + len, UIP_APPDATA_SIZE - len,
+		"]}");
+
+	return len;
+}
+
+/*
+ * Check the fast memcpy / memset / memcmp with the bursts the target
+ * runs (see fastmem_selftest()), apart from the benchmark.
+ *   /mem_selftest		lengths up to FASTMEM_TEST_LEN
+ *   /mem_selftest?len=n	lengths up to n, at most FASTMEM_TEST_LEN
+ * "errors" is the number of wrong results, -1 if the test couldn't run.
+ * It runs in the tcp-ip thread with the core locked, hence the cap: the
+ * longer lengths are the host test's (test/fastmem.c).
+ */
+static int mem_selftest(int index, int iNumParams,
+		char *pcParam[], char *pcValue[], char **resultBuffer)
+{
+	int max_len = FASTMEM_TEST_LEN;
+	int j;
+
+	*resultBuffer = uip_appdata;
+
+	for (j = 0; j < iNumParams; j++) {
+		if (strcmp(pcParam[j], "len") == 0)
+			max_len = strtol(pcValue[j], NULL, 10);
+	}
+	if (max_len < 0)
+		max_len = 0;
+	if (max_len > FASTMEM_TEST_LEN)
+		max_len = FASTMEM_TEST_LEN;
+
+	return snprintf((char *)uip_appdata, UIP_APPDATA_SIZE,
+		"HTTP/1.1 200 OK\r\n"
+		"Server: lwIP/CGI (FreeRTOS)\r\n"
+		"Content-type: application/json\r\n"
+		"Cache-control: no-cache\r\n\r\n"
+
+		"{\"len\": %d, \"errors\": %d}",
+		max_len, fastmem_selftest(max_len));
+}
+
+/*---------------------------------------------------------------------------*/
+
 int perm_config(int index, int iNumParams,
 		char *pcParam[], char *pcValue[], char **resultBuffer)
 {
@@ -201,7 +839,7 @@ int perm_config(int index, int iNumParams,
 int user_config(int index, int iNumParams,
 		char *pcParam[], char *pcValue[], char **resultBuffer)
 {
-	int ucvalid = usercfg_valid();
+	int ucvalid = kvcfg_valid();
 
 	*resultBuffer = uip_appdata;
 
@@ -243,27 +881,27 @@ int user_config(int index, int iNumParams,
 "	<textarea name=\"NOTES\" rows=\"4\" cols=\"63\">%s</textarea></td>"
 "</tr>",
 		ucvalid ? "Valid" : "Invalid",
-		usercfg.assy_pn,
-		usercfg.assy_sn,
+		kvcfg.assy_pn,
+		kvcfg.assy_sn,
 
-		usercfg.ip[0],
-		usercfg.ip[1],
-		usercfg.ip[2],
-		usercfg.ip[3],
+		kvcfg.ip[0],
+		kvcfg.ip[1],
+		kvcfg.ip[2],
+		kvcfg.ip[3],
 
-		usercfg.netmask[0],
-		usercfg.netmask[1],
-		usercfg.netmask[2],
-		usercfg.netmask[3],
+		kvcfg.netmask[0],
+		kvcfg.netmask[1],
+		kvcfg.netmask[2],
+		kvcfg.netmask[3],
 
-		usercfg.gateway[0],
-		usercfg.gateway[1],
-		usercfg.gateway[2],
-		usercfg.gateway[3],
+		kvcfg.gateway[0],
+		kvcfg.gateway[1],
+		kvcfg.gateway[2],
+		kvcfg.gateway[3],
 
-		usercfg.IPMode,
+		(int)kvcfg.ip_mode,
 
-		usercfg.notes
+		kvcfg.notes
 	);
 }
 
@@ -354,18 +992,18 @@ static int config_form(int index, int iNumParams,
 		 * Ditto for the assembly part number
 		 */
 		if (STRNCMP(pcParam[i], "AYPN=") == 0) {
-			len = strncpy_html(usercfg.assy_pn, pcValue[i],
-				sizeof(usercfg.assy_pn) - 1);
-			usercfg.assy_pn[len] = '\0';
+			len = strncpy_html(kvcfg.assy_pn, pcValue[i],
+				sizeof(kvcfg.assy_pn) - 1);
+			kvcfg.assy_pn[len] = '\0';
 			continue;
 		}
 		/*
 		 * Ditto for the assembly serial number
 		 */
 		if (STRNCMP(pcParam[i], "AYSN=") == 0) {
-			len = strncpy_html(usercfg.assy_sn, pcValue[i],
-				sizeof(usercfg.assy_sn) - 1);
-			usercfg.assy_sn[len] = '\0';
+			len = strncpy_html(kvcfg.assy_sn, pcValue[i],
+				sizeof(kvcfg.assy_sn) - 1);
+			kvcfg.assy_sn[len] = '\0';
 			continue;
 		}
 		/*
@@ -400,7 +1038,7 @@ static int config_form(int index, int iNumParams,
 					lstr(".err>");
 					return 0;
 				}
-				usercfg.IPMode = IPMode;
+				kvcfg.ip_mode = IPMode;
 			}
 			lstr(">");
 			continue;
@@ -418,7 +1056,7 @@ static int config_form(int index, int iNumParams,
 			if (idx > 3)
 				return 0;
 			if (isdigit(*pcValue[i]))
-				usercfg.ip[idx] = strtol(pcValue[i], NULL, 10) & 0xFF;
+				kvcfg.ip[idx] = strtol(pcValue[i], NULL, 10) & 0xFF;
 			continue;
 		}
 		/*
@@ -433,7 +1071,7 @@ static int config_form(int index, int iNumParams,
 			if (idx > 3)
 				return 0;
 			if (isdigit(*pcValue[i]))
-				usercfg.netmask[idx] = strtol(pcValue[i], NULL, 10) & 0xFF;
+				kvcfg.netmask[idx] = strtol(pcValue[i], NULL, 10) & 0xFF;
 			continue;
 		}
 		/*
@@ -448,16 +1086,16 @@ static int config_form(int index, int iNumParams,
 			if (idx > 3)
 				return 0;
 			if (isdigit(*pcValue[i]))
-				usercfg.gateway[idx] = strtol(pcValue[i], NULL, 10) & 0xFF;
+				kvcfg.gateway[idx] = strtol(pcValue[i], NULL, 10) & 0xFF;
 			continue;
 		}
 		/*
 		 * Save the notes field.
 		 */
 		if (STRNCMP(pcParam[i], "NOTES") == 0) {
-			len = strncpy_html(usercfg.notes, pcValue[i],
-				sizeof(usercfg.notes) - 1);
-			usercfg.notes[len] = '\0';
+			len = strncpy_html(kvcfg.notes, pcValue[i],
+				sizeof(kvcfg.notes) - 1);
+			kvcfg.notes[len] = '\0';
 			continue;
 		}
 	}
@@ -471,7 +1109,7 @@ static int config_form(int index, int iNumParams,
 	{
 		permcfg_save();
 	}
-	usercfg_save();
+	kvcfg_save();
 
 	/*
 	 * Return a trivial save confirmation page with a button that
@@ -503,6 +1141,135 @@ static int config_form(int index, int iNumParams,
 
 /*---------------------------------------------------------------------------*/
 
+/*
+ * Append a JSON string, escaping what JSON needs.  Returns the new
+ * length, limited to size - 1.
+ */
+static int json_str(char *buf, int len, int size, const char *str)
+{
+	unsigned char c;
+
+	if (len < size - 1)
+		buf[len++] = '"';
+	while ((c = *str++) != '\0') {
+		if ((c == '"') || (c == '\\'))
+			len += snprintf(buf + len, size - len, "\\%c", c);
+		else if (c < ' ')
+			len += snprintf(buf + len, size - len, "\\u%04x", c);
+		else if (len < size - 1)
+			buf[len++] = c;
+		if (len > size - 1)
+			len = size - 1;
+	}
+	if (len < size - 1)
+		buf[len++] = '"';
+	buf[len] = '\0';
+	return len;
+}
+
+/*---------------------------------------------------------------------------*/
+
+#define KV_ROOM		32	/* Room kept for the end */
+
+/*
+ * Report and set the key/value settings (see kvcfg.h).
+ *   /kvcfg				all settings as JSON
+ *   /kvcfg?key=syslog_port&value=514	set one
+ *   &save=1 also saves the settings that changed to flash.
+ * Blobs are only reported by size; they are set by their own CGI
+ * (e.g. /adc_cal).  Settings that don't fit are left out whole and
+ * counted in "dropped".
+ */
+static int kv_config(int index, int iNumParams,
+		char *pcParam[], char *pcValue[], char **resultBuffer)
+{
+	static const char *typestr[] = { "str", "u32", "ip4", "blob" };
+	static char text[KVCFG_TEXT_MAX];
+	const struct kvcfg_key_s *kp = NULL;
+	int have_value = 0;
+	int save = 0;
+	int err = 0;
+	int limit = UIP_APPDATA_SIZE - KV_ROOM;
+	char *buf = (char *)uip_appdata;
+	int dropped = 0;
+	int start;
+	int mark;
+	int len;
+	int j;
+
+	*resultBuffer = uip_appdata;
+
+	for (j = 0; j < iNumParams; j++) {
+		if (strcmp(pcParam[j], "key") == 0) {
+			if ((kp = kvcfg_find(pcValue[j])) == NULL)
+				err = 1;
+		} else if (strcmp(pcParam[j], "value") == 0) {
+			len = strncpy_html(text, pcValue[j], sizeof(text) - 1);
+			text[len] = '\0';
+			have_value = 1;
+		} else if (strcmp(pcParam[j], "save") == 0) {
+			save = strtol(pcValue[j], NULL, 10);
+		}
+	}
+
+	if (kp && have_value && (kvcfg_set(kp, text) != 0))
+		err = 1;
+	if (save && !err && !kvcfg_save())
+		err = 1;
+
+	len = snprintf((char *)uip_appdata, UIP_APPDATA_SIZE,
+		"HTTP/1.1 200 OK\r\n"
+		"Server: lwIP/CGI (FreeRTOS)\r\n"
+		"Content-type: application/json\r\n"
+		"Cache-control: no-cache\r\n\r\n"
+
+		"{\"status\": \"%s\", \"valid\": %s, \"settings\": {",
+		err ? "error" : "ok", kvcfg_valid() ? "true" : "false");
+	start = len;
+
+	/*
+	 * A setting that reaches the limit may have been cut: take it
+	 * back out, and count it and the rest as dropped.
+	 */
+	for (j = 0; (kp = kvcfg_key(j)) != NULL; j++) {
+		if (dropped) {
+			dropped++;
+			continue;
+		}
+		mark = len;
+		len = append(buf, len, limit,
+			"%s\"%s\": {\"id\": %d, \"type\": \"%s\"",
+			(mark == start) ? "" : ", ", kp->name, kp->id,
+			typestr[kp->type]);
+		if (kp->type == kvU32)
+			len = append(buf, len, limit,
+				", \"min\": %u, \"max\": %u",
+				(unsigned)kp->min, (unsigned)kp->max);
+		if (kp->type == kvBlob) {
+			len = append(buf, len, limit, ", \"size\": %d}",
+				kp->size);
+		} else {
+			kvcfg_format(kp, text, sizeof(text));
+			len = append(buf, len, limit, ", \"value\": ");
+			if (kp->type == kvU32)
+				len = append(buf, len, limit, "%s", text);
+			else
+				len = json_str(buf, len, limit, text);
+			len = append(buf, len, limit, "}");
+		}
+		if (len >= limit - 1) {
+			len = mark;
+			dropped = 1;
+		}
+	}
+	len += snprintf(buf + len, UIP_APPDATA_SIZE - len,
+		"}, \"dropped\": %d}", dropped);
+
+	return len;
+}
+
+/*---------------------------------------------------------------------------*/
+
 static int proc_io_upd(int index, int iNumParams,
 		char *pcParam[], char *pcValue[], char **resultBuffer)
 {
@@ -704,6 +1471,524 @@ static int control_upd(int index, int iNumParams,
 
 /*---------------------------------------------------------------------------*/
 
+/*
+ * Report the button change events queued since the last call.
+ *   /dio_events
+ * The httpd runs in the tcpip thread, so this takes what is on the queue
+ * and doesn't wait for more.  When the reply runs out of room the rest
+ * stay queued for the next call, and "more" says so.  "lost" counts the events dropped
+ * because the queue was full.
+ */
+static int dio_events(int index, int iNumParams,
+		char *pcParam[], char *pcValue[], char **resultBuffer)
+{
+	struct dio_event_s ev;
+	int limit = UIP_APPDATA_SIZE - REPLY_ROOM;
+	char *buf = (char *)uip_appdata;
+	int more = 0;
+	int start;
+	int len;
+
+	*resultBuffer = uip_appdata;
+
+	len = snprintf(buf, UIP_APPDATA_SIZE,
+		"HTTP/1.1 200 OK\r\n"
+		"Server: lwIP/CGI (FreeRTOS)\r\n"
+		"Content-type: application/json\r\n"
+		"Cache-control: no-cache\r\n\r\n"
+		"{\"lost\": %u, \"events\": [",
+		(unsigned)dio_event_lost);
+	start = len;
+
+	/* Each event takes well under 64 bytes. */
+	for (;;) {
+		if (len >= limit - 64) {
+			more = 1;
+			break;
+		}
+		if (!dio_event_wait(&ev, 0))
+			break;
+		len = append(buf, len, limit,
+			"%s{\"which\": \"%s\", \"value\": %d, \"stamp\": %u}",
+			(len == start) ? "" : ", ", diotostr(ev.which),
+			ev.value, (unsigned)ev.stamp);
+	}
+	len = append(buf, len, UIP_APPDATA_SIZE, "], \"more\": %s}",
+		more ? "true" : "false");
+
+	return len;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Set and/or report the A/D filter configuration.
+ *   /adc_filter?ch=adcProc0&type=avg&n=8	filter one channel
+ *   /adc_filter?ch=all&type=ema&n=3		filter all channels
+ *   /adc_filter?os=16				hardware oversample
+ * Always returns the resulting configuration as JSON.  Channels that don't
+ * fit are counted in "dropped".
+ */
+static int adc_filter(int index, int iNumParams,
+		char *pcParam[], char *pcValue[], char **resultBuffer)
+{
+	enum adc_sel which = adcInvalid;
+	enum adc_filter_type type = adcFiltInvalid;
+	enum adc_filter_type curtype;
+	int limit = UIP_APPDATA_SIZE - REPLY_ROOM;
+	char *buf = (char *)uip_appdata;
+	int dropped = 0;
+	int all = 0;
+	int param = 0;
+	int err = 0;
+	int mark;
+	int len;
+	int j;
+
+	*resultBuffer = uip_appdata;
+
+	for (j = 0; j < iNumParams; j++) {
+		if (strcmp(pcParam[j], "ch") == 0) {
+			if (strcmp(pcValue[j], "all") == 0)
+				all = 1;
+			else
+				which = strtoadc(pcValue[j]);
+		} else if (strcmp(pcParam[j], "type") == 0) {
+			type = strtoadcfilt(pcValue[j]);
+		} else if (strcmp(pcParam[j], "n") == 0) {
+			param = strtol(pcValue[j], NULL, 10);
+		} else if (strcmp(pcParam[j], "os") == 0) {
+			if (adc_oversample_set(strtol(pcValue[j], NULL, 10)))
+				err = 1;
+		}
+	}
+
+	if (type != adcFiltInvalid) {
+		for (j = adcProc0; j <= adcProcTemp; j++) {
+			if ((all || (j == which)) &&
+			    adc_filter_set(j, type, param))
+				err = 1;
+		}
+	}
+
+	len = snprintf(buf, UIP_APPDATA_SIZE,
+		"HTTP/1.1 200 OK\r\n"
+		"Server: lwIP/CGI (FreeRTOS)\r\n"
+		"Content-type: application/json\r\n"
+		"Cache-control: no-cache\r\n\r\n"
+
+		"{\"status\": \"%s\", \"oversample\": %d",
+		err ? "error" : "ok", adc_oversample_get());
+
+	for (j = adcProc0; j <= adcProcTemp; j++) {
+		if (dropped) {
+			dropped++;
+			continue;
+		}
+		adc_filter_get(j, &curtype, &param);
+		mark = len;
+		len = append(buf, len, limit,
+			", \"%s\": {\"type\": \"%s\", \"n\": %d}",
+			adcxlate[j].str, adcfilttostr(curtype), param);
+		if (len >= limit - 1) {
+			len = mark;
+			dropped = 1;
+		}
+	}
+	len = append(buf, len, UIP_APPDATA_SIZE, ", \"dropped\": %d}",
+		dropped);
+
+	return len;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Set and/or report the A/D calibration (A/D counts to milliunits).
+ *   /adc_cal?ch=adcProc0&type=linear&c0=0&c1=192000
+ *   /adc_cal?ch=adcProc1&type=poly&c0=10&c1=190000&c2=-5
+ *   /adc_cal?ch=adcProc2&type=table&n=3&x0=0&y0=0&x1=512&y1=900&x2=1023&y2=2000
+ *   &save=1 also writes the user configuration to flash.
+ * c1 is Q16 and c2 is Q24 (see struct adc_cal_s).
+ * Always returns the resulting calibration as JSON.
+ */
+static int adc_cal(int index, int iNumParams,
+		char *pcParam[], char *pcValue[], char **resultBuffer)
+{
+	static const char *typestr[] = { "linear", "poly", "table" };
+	enum adc_sel which = adcInvalid;
+	struct adc_cal_s cal;
+	struct adc_cal_s *cp;
+	int limit = UIP_APPDATA_SIZE - REPLY_ROOM;
+	char *buf = (char *)uip_appdata;
+	int dropped = 0;
+	int save = 0;
+	int err = 0;
+	int mark;
+	int idx;
+	int len;
+	int j, k;
+
+	*resultBuffer = uip_appdata;
+
+	memset(&cal, 0, sizeof(cal));
+	cal.type = adcCalInvalid;
+
+	for (j = 0; j < iNumParams; j++) {
+		if (strcmp(pcParam[j], "ch") == 0) {
+			which = strtoadc(pcValue[j]);
+		} else if (strcmp(pcParam[j], "type") == 0) {
+			for (k = 0; k < adcCalInvalid; k++) {
+				if (strcmp(pcValue[j], typestr[k]) == 0)
+					cal.type = k;
+			}
+		} else if (strcmp(pcParam[j], "save") == 0) {
+			save = strtol(pcValue[j], NULL, 10);
+		} else if (strcmp(pcParam[j], "n") == 0) {
+			cal.npoints = strtol(pcValue[j], NULL, 10);
+		} else if ((pcParam[j][0] == 'c') || (pcParam[j][0] == 'x') ||
+			   (pcParam[j][0] == 'y')) {
+			if (!isdigit(pcParam[j][1]))
+				continue;
+			idx = pcParam[j][1] - '0';
+			if (pcParam[j][0] == 'c' && idx < 3)
+				cal.coef[idx] = strtol(pcValue[j], NULL, 10);
+			else if (pcParam[j][0] == 'x' && idx < ADC_CAL_PWL_POINTS)
+				cal.x[idx] = strtol(pcValue[j], NULL, 10);
+			else if (pcParam[j][0] == 'y' && idx < ADC_CAL_PWL_POINTS)
+				cal.y[idx] = strtol(pcValue[j], NULL, 10);
+		}
+	}
+
+	if ((which != adcInvalid) && (cal.type != adcCalInvalid)) {
+		if (adc_cal_set(which, &cal) == 0)
+			kvcfg.adc_cal[which] = cal;
+		else
+			err = 1;
+	}
+	if (save && !err && !kvcfg_save())
+		err = 1;
+
+	len = snprintf((char *)uip_appdata, UIP_APPDATA_SIZE,
+		"HTTP/1.1 200 OK\r\n"
+		"Server: lwIP/CGI (FreeRTOS)\r\n"
+		"Content-type: application/json\r\n"
+		"Cache-control: no-cache\r\n\r\n"
+
+		"{\"status\": \"%s\"", err ? "error" : "ok");
+
+	for (j = 0; j < ADC_CAL_CHANNELS; j++) {
+		if (dropped) {
+			dropped++;
+			continue;
+		}
+		cp = &kvcfg.adc_cal[j];
+		mark = len;
+		len = append(buf, len, limit,
+			", \"%s\": {\"type\": \"%s\", \"eng\": %d"
+			", \"c\": [%d, %d, %d], \"n\": %d, \"pts\": [",
+			adcxlate[j].str,
+			(cp->type < adcCalInvalid) ? typestr[cp->type] : "?",
+			adc(j, engineering),
+			(int)cp->coef[0], (int)cp->coef[1], (int)cp->coef[2],
+			(int)cp->npoints);
+		for (k = 0; (cp->type == adcCalTable) && (k < cp->npoints) &&
+		     (k < ADC_CAL_PWL_POINTS); k++) {
+			len = append(buf, len, limit, "%s[%d, %d]",
+				k ? ", " : "", cp->x[k], (int)cp->y[k]);
+		}
+		len = append(buf, len, limit, "]}");
+		if (len >= limit - 1) {
+			len = mark;
+			dropped = 1;
+		}
+	}
+	len = append(buf, len, UIP_APPDATA_SIZE, ", \"dropped\": %d}",
+		dropped);
+
+	return len;
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * A/D waveform capture.
+ *   /adc_capture?cmd=arm&mask=3&rate=10000&pre=100&trig=rise&ch=0&level=512
+ *   /adc_capture?cmd=abort
+ *   /adc_capture?cmd=status			JSON status
+ *   /adc_capture?cmd=data			binary blob (see adccap.h)
+ *   /adc_capture?cmd=udp&ip=a.b.c.d&port=n	stream blob as UDP
+ * Everything but cmd=data returns the JSON status.  cmd=arm answers
+ * "busy" while a cmd=data reply is still being sent from the ring.
+ */
+static int adc_capture(int index, int iNumParams,
+		char *pcParam[], char *pcValue[], char **resultBuffer)
+{
+	static const char *statestr[] = {
+		"idle", "pre", "armed", "post", "done"
+	};
+	struct adc_cap_req req;
+	struct adc_cap_info info;
+	const char *cmd = "status";
+	uint32_t ipaddr = 0;
+	uint16_t port = 0;
+	char *blob;
+	int result = 0;
+	int hdrlen;
+	int len;
+	int j;
+
+	req.chan_mask = 0x1;
+	req.rate      = 10000;
+	req.pre       = 0;
+	req.trig      = adcTrigNone;
+	req.trig_chan = 0;
+	req.level     = 512;
+
+	for (j = 0; j < iNumParams; j++) {
+		if (strcmp(pcParam[j], "cmd") == 0)
+			cmd = pcValue[j];
+		else if (strcmp(pcParam[j], "mask") == 0)
+			req.chan_mask = strtol(pcValue[j], NULL, 0);
+		else if (strcmp(pcParam[j], "rate") == 0)
+			req.rate = strtol(pcValue[j], NULL, 10);
+		else if (strcmp(pcParam[j], "pre") == 0)
+			req.pre = strtol(pcValue[j], NULL, 10);
+		else if (strcmp(pcParam[j], "trig") == 0)
+			req.trig = strtoadctrig(pcValue[j]);
+		else if (strcmp(pcParam[j], "ch") == 0)
+			req.trig_chan = strtol(pcValue[j], NULL, 10);
+		else if (strcmp(pcParam[j], "level") == 0)
+			req.level = strtol(pcValue[j], NULL, 10);
+		else if (strcmp(pcParam[j], "ip") == 0)
+			ipaddr = ipaddr_addr(pcValue[j]);
+		else if (strcmp(pcParam[j], "port") == 0)
+			port = strtol(pcValue[j], NULL, 10);
+	}
+
+	if (strcmp(cmd, "data") == 0) {
+		/*
+		 * Build the HTTP header in the scratch buffer, then copy
+		 * it into the room reserved in front of the capture so
+		 * the blob itself is sent in place.  The capture can't be
+		 * armed again until httpd_cgi_done() gives it back.
+		 */
+		len = adc_cap_data(0, &blob);
+		if (len != 0)
+			adc_cap_data_done(blob);	/* just the length */
+		if (len == 0) {
+			*resultBuffer = "HTTP/1.1 404 Not Found\r\n"
+				"Content-type: text/plain\r\n\r\n"
+				"No capture\r\n";
+			return strlen(*resultBuffer);
+		}
+		hdrlen = snprintf((char *)uip_appdata, UIP_APPDATA_SIZE,
+			"HTTP/1.1 200 OK\r\n"
+			"Server: lwIP/CGI (FreeRTOS)\r\n"
+			"Content-type: application/octet-stream\r\n"
+			"Content-length: %d\r\n"
+			"Cache-control: no-cache\r\n\r\n", len);
+		len = adc_cap_data(hdrlen, resultBuffer);
+		memcpy(*resultBuffer, uip_appdata, hdrlen);
+		return hdrlen + len;
+	}
+
+	if (strcmp(cmd, "arm") == 0)
+		result = adc_cap_arm(&req);
+	else if (strcmp(cmd, "abort") == 0)
+		adc_cap_abort();
+	else if (strcmp(cmd, "udp") == 0)
+		result = (ipaddr && port) ? adc_cap_udp_send(ipaddr, port) : -1;
+
+	adc_cap_status(&info);
+	*resultBuffer = uip_appdata;
+
+	return snprintf((char *)uip_appdata, UIP_APPDATA_SIZE,
+		"HTTP/1.1 200 OK\r\n"
+		"Server: lwIP/CGI (FreeRTOS)\r\n"
+		"Content-type: application/json\r\n"
+		"Cache-control: no-cache\r\n\r\n"
+
+		"{\"status\": \"%s\", \"result\": %d"
+		", \"state\": \"%s\", \"mask\": %d, \"nchan\": %d"
+		", \"sets\": %d, \"pre\": %d, \"rate\": %d"
+		", \"achieved\": %d, \"overflows\": %d}",
+		(result == -2) ? "busy" : (result < 0) ? "error" : "ok", result,
+		(info.state <= adcCapDone) ? statestr[info.state] : "?",
+		info.chan_mask, info.nchan,
+		(int)info.sets, (int)info.pre, (int)info.rate,
+		(int)info.achieved, (int)info.overflows);
+}
+
+/*---------------------------------------------------------------------------*/
+
+/*
+ * Room for the HTTP header in front of the binary history blob, and the
+ * number of blocks decoded for JSON per page (up to 12 values of ~8
+ * characters each per block must fit in the scratch buffer along with
+ * the blob).
+ */
+#define HIST_HTTP_ROOM		160
+#define HIST_JSON_BLOCKS	14
+
+/*
+ * I/O history (see history.h).
+ *   /history				list the points and tiers
+ *   /history?pt=0&tier=1&fmt=bin		binary blob
+ *   /history?pt=0&tier=1&units=mv		JSON values, oldest first
+ *   /history?pt=0&tier=1&start=14		the page before that
+ * units is raw (A/D counts, the default), mv or eng.  A page is as many
+ * blocks as fit, start blocks back from the newest; "older" is what's
+ * left, fetch it with start set to "next" until older is 0.
+ */
+static int history(int index, int iNumParams,
+		char *pcParam[], char *pcValue[], char **resultBuffer)
+{
+	struct hist_hdr_s hdr;
+	struct hist_block_s blk;
+	enum adc_units units = raw;
+	const struct hist_point_s *hp;
+	char *blob;
+	int point = -1;
+	int tier = 0;
+	int start = 0;
+	int bin = 0;
+	int cut = 0;
+	int blen;
+	int hdrlen;
+	int room;
+	int len;
+	int val;
+	int n;
+	int j, k;
+
+	*resultBuffer = uip_appdata;
+
+	for (j = 0; j < iNumParams; j++) {
+		if (strcmp(pcParam[j], "pt") == 0)
+			point = strtol(pcValue[j], NULL, 10);
+		else if (strcmp(pcParam[j], "tier") == 0)
+			tier = strtol(pcValue[j], NULL, 10);
+		else if (strcmp(pcParam[j], "start") == 0)
+			start = strtol(pcValue[j], NULL, 10);
+		else if (strcmp(pcParam[j], "fmt") == 0)
+			bin = (strcmp(pcValue[j], "bin") == 0);
+		else if (strcmp(pcParam[j], "units") == 0) {
+			if (strcmp(pcValue[j], "mv") == 0)
+				units = millivolts;
+			else if (strcmp(pcValue[j], "eng") == 0)
+				units = engineering;
+		}
+	}
+
+	if (point < 0) {
+		len = snprintf((char *)uip_appdata, UIP_APPDATA_SIZE,
+			"HTTP/1.1 200 OK\r\n"
+			"Server: lwIP/CGI (FreeRTOS)\r\n"
+			"Content-type: application/json\r\n"
+			"Cache-control: no-cache\r\n\r\n"
+
+			"{\"period_ms\": [%d, %d, %d], \"points\": [",
+			(int)hist_period_ms(0), (int)hist_period_ms(1),
+			(int)hist_period_ms(2));
+		for (j = 0; j < hist_num_points; j++) {
+			hp = &hist_points[j];
+			len += snprintf((char *)uip_appdata + len,
+				UIP_APPDATA_SIZE - len, "%s\"%s\"",
+				j ? ", " : "", (hp->kind == histAdc) ?
+				adcxlate[hp->which].str :
+				dioxlate[hp->which].str);
+		}
+		len += snprintf((char *)uip_appdata + len,
+			UIP_APPDATA_SIZE - len, "]}");
+		return len;
+	}
+
+	if (bin) {
+		/*
+		 * Read the blob after room for the header, then slide
+		 * it down against the header once its length is known.
+		 */
+		blen = hist_read(point, tier, start,
+			uip_appdata + HIST_HTTP_ROOM,
+			UIP_APPDATA_SIZE - HIST_HTTP_ROOM);
+		if (blen < 0)
+			goto notfound;
+		hdrlen = snprintf((char *)uip_appdata, HIST_HTTP_ROOM,
+			"HTTP/1.1 200 OK\r\n"
+			"Server: lwIP/CGI (FreeRTOS)\r\n"
+			"Content-type: application/octet-stream\r\n"
+			"Content-length: %d\r\n"
+			"Cache-control: no-cache\r\n\r\n", blen);
+		memmove(uip_appdata + hdrlen, uip_appdata + HIST_HTTP_ROOM,
+			blen);
+		return hdrlen + blen;
+	}
+
+	/*
+	 * JSON: the blob goes at the end of the scratch buffer and is
+	 * decoded into the front.  The text never overruns a block that
+	 * hasn't been copied out yet.
+	 */
+	blen = sizeof(hdr) + HIST_JSON_BLOCKS * sizeof(blk);
+	blob = uip_appdata + UIP_APPDATA_SIZE - blen;
+	if (hist_read(point, tier, start, blob, blen) < 0)
+		goto notfound;
+	memcpy(&hdr, blob, sizeof(hdr));
+	blob += sizeof(hdr);
+	hp = &hist_points[point];
+
+	len = snprintf((char *)uip_appdata, UIP_APPDATA_SIZE,
+		"HTTP/1.1 200 OK\r\n"
+		"Server: lwIP/CGI (FreeRTOS)\r\n"
+		"Content-type: application/json\r\n"
+		"Cache-control: no-cache\r\n\r\n"
+
+		"{\"point\": \"%s\", \"tier\": %d, \"period_ms\": %d"
+		", \"newest\": %u, \"start\": %d, \"blocks\": %u"
+		", \"older\": %u, \"next\": %d"
+		", \"units\": \"%s\", \"values\": [",
+		(hp->kind == histAdc) ? adcxlate[hp->which].str :
+			dioxlate[hp->which].str,
+		tier, (int)hdr.period_ms, (unsigned)hdr.newest, start,
+		(unsigned)hdr.nblocks, (unsigned)hdr.older,
+		start + (int)hdr.nblocks,
+		(hp->kind != histAdc) ? "%" : (units == millivolts) ? "mv" :
+			(units == engineering) ? "eng" : "raw");
+
+	for (j = 0; (j < hdr.nblocks) && !cut; j++) {
+		memcpy(&blk, blob + j * sizeof(blk), sizeof(blk));
+		val = blk.base;
+		for (k = 0; k < blk.count; k++) {
+			if (k > 0)
+				val += blk.delta[k - 1];
+			/* Never into a block that hasn't been copied out. */
+			room = (blob + (j + 1) * sizeof(blk)) -
+				((char *)uip_appdata + len);
+			n = (room > 0) ? snprintf((char *)uip_appdata + len,
+				room, "%s%d", (j || k) ? "," : "",
+				(hp->kind == histAdc) ?
+				adc_scale(hp->which, units, val) : val) : 0;
+			if ((room <= 0) || (n >= room)) {
+				cut = 1;
+				break;
+			}
+			len += n;
+		}
+	}
+	len += snprintf((char *)uip_appdata + len, UIP_APPDATA_SIZE - len,
+		"], \"truncated\": %s}", cut ? "true" : "false");
+	return len;
+
+notfound:
+	*resultBuffer = "HTTP/1.1 404 Not Found\r\n"
+		"Content-type: text/plain\r\n\r\n"
+		"No such history\r\n";
+	return strlen(*resultBuffer);
+}
+
+/*---------------------------------------------------------------------------*/
+
 static int button(int index, int iNumParams,
 		char *pcParam[], char *pcValue[], char **resultBuffer)
 {
@@ -727,19 +2012,48 @@ static int button(int index, int iNumParams,
 
 /*---------------------------------------------------------------------------*/
 
+/*
+ * A reply has been sent (or its connection dropped).  Only the capture
+ * blob is sent from a buffer that has to be given back.
+ */
+void httpd_cgi_done(const char *resultBuffer)
+{
+	adc_cap_data_done(resultBuffer);
+}
+
+/*---------------------------------------------------------------------------*/
+
 static const tCGI ssi_cgi_funcs[] = {
 
 		{ "/rtos_stats", rtos_stats },
 		{ "/run_time", run_time },
+		{ "/task_stats", task_stats },
+		{ "/supervisor", supervisor },
+		{ "/latency", latency },
+		{ "/net_stats", net_stats },
+		{ "/mem_stats", mem_stats },
+		{ "/mem_table", mem_table },
+		{ "/mem_bench", mem_bench },
+		{ "/mem_selftest", mem_selftest },
 
 		/* Configuration */
 		{ "/perm_config", perm_config },
 		{ "/user_config", user_config },
 		{ "/config_form", config_form },
+		{ "/kvcfg", kv_config },
 
 		/* AJAX page updates */
 		{ "/control_upd", control_upd },
 		{ "/proc_io_upd", proc_io_upd },
+		{ "/dio_events", dio_events },
+
+		/* A/D filtering */
+		{ "/adc_filter", adc_filter },
+		{ "/adc_capture", adc_capture },
+		{ "/adc_cal", adc_cal },
+
+		/* I/O history */
+		{ "/history", history },
 
 		/* Button press reports */
 		{ "/button", button },
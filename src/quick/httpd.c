@@ -84,6 +84,7 @@
 #include "httpd.h"
 #include "lwip/tcp.h"
 #include "fs.h"
+#include "quickstart-opts.h"
 
 #include <string.h>
 
@@ -181,6 +182,9 @@ struct http_state {
   enum tag_check_state tag_state; /* State of the tag processor */
 #endif
 #ifdef INCLUDE_HTTPD_CGI
+#if HTTPD_CGI_USE_STATIC_BUFFER
+  char *cgi_buffer; /* CGI reply being sent in place, see httpd_cgi_done() */
+#endif
   char *params[MAX_CGI_PARAMETERS]; /* Params extracted from the request URI */
   char *param_vals[MAX_CGI_PARAMETERS]; /* Values for each extracted param */
 #endif
@@ -300,6 +304,20 @@ tHTTPHeader g_psHTTPHeaders[] =
 
 #endif
 
+/*-----------------------------------------------------------------------------------*/
+/* Let the CGI code know a reply it gave us isn't needed any more. */
+static void
+cgi_release(struct http_state *hs)
+{
+#if defined(INCLUDE_HTTPD_CGI) && HTTPD_CGI_USE_STATIC_BUFFER
+  if(hs->cgi_buffer) {
+    httpd_cgi_done(hs->cgi_buffer);
+    hs->cgi_buffer = NULL;
+  }
+#else
+  LWIP_UNUSED_ARG(hs);
+#endif
+}
 /*-----------------------------------------------------------------------------------*/
 static void
 conn_err(void *arg, err_t err)
@@ -311,6 +329,7 @@ conn_err(void *arg, err_t err)
   if(arg)
   {
       hs = arg;
+      cgi_release(hs);
       if(hs->handle) {
         fs_close(hs->handle);
         hs->handle = NULL;
@@ -333,6 +352,7 @@ close_conn(struct tcp_pcb *pcb, struct http_state *hs)
   tcp_sent(pcb, NULL);
   tcp_recv(pcb, NULL);
   if(hs) {
+    cgi_release(hs);
     if(hs->handle) {
       fs_close(hs->handle);
       hs->handle = NULL;
@@ -599,7 +619,7 @@ get_http_headers(struct http_state *pState, char *pszURI)
 #endif
 
 /*-----------------------------------------------------------------------------------*/
-static void
+static HOT_PATH void
 send_data(struct tcp_pcb *pcb, struct http_state *hs)
 {
   err_t err;
@@ -1407,6 +1427,8 @@ http_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
           hs->tag_end = cgi_buffer;
 #endif
           hs->handle = NULL;
+          cgi_release(hs);
+          hs->cgi_buffer = cgi_buffer;
           hs->file = cgi_buffer;
           hs->left = cgi_len;
           hs->retries = 0;
@@ -1493,6 +1515,9 @@ http_accept(void *arg, struct tcp_pcb *pcb, err_t err)
   hs->buf_len = 0;
   hs->left = 0;
   hs->retries = 0;
+#if defined(INCLUDE_HTTPD_CGI) && HTTPD_CGI_USE_STATIC_BUFFER
+  hs->cgi_buffer = NULL;
+#endif
 #ifdef DYNAMIC_HTTP_HEADERS
   /* Indicate that the headers are not yet valid */
   hs->hdr_index = NUM_FILE_HDR_STRINGS;
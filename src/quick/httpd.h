@@ -89,6 +89,16 @@ typedef struct
 
 void http_set_cgi_handlers(const tCGI *pCGIs, int iNumHandlers);
 
+#if HTTPD_CGI_USE_STATIC_BUFFER
+/*
+ * Provided by the CGI code.  httpd.c calls it when a connection is done
+ * with the resultBuffer a CGI handler gave it: the reply was sent, or the
+ * connection closed or failed.  Until then the reply is sent from the
+ * buffer in place.
+ */
+void httpd_cgi_done(const char *resultBuffer);
+#endif
+
 
 /* The maximum number of parameters that the CGI handler can be sent. */
 #ifndef MAX_CGI_PARAMETERS
@@ -50,9 +50,15 @@ done in the I/O task.
 
 #include <config.h>
 #include <io.h>
+#include <adcfilt.h>
 #include <util.h>
 #include <logger.h>
 #include <utilwdtcfg.h>
+#include <partnum.h>
+#include <kvcfg.h>
+#include <boottime.h>
+#include <history.h>
+#include <latency.h>
 
 #include <ETHIsr.h>
 #include <ethernet.h>
@@ -66,7 +72,7 @@ xTaskHandle io_task_handle;	/**< I/O task handle */
 /*
  * Private information.
  */
-#define POLL_HZ		10
+#define POLL_HZ		IO_POLL_HZ
 #define POLL_DELAY	(configTICK_RATE_HZ / POLL_HZ)
 
 #define IO_TIMEOUT	(POLL_DELAY / 10)
@@ -76,6 +82,14 @@ static void io_task(void *params);
 /** Mutex for exclusive access to the data. */
 static xSemaphoreHandle io_mutex;
 
+/** The task stack, unless it comes from the heap. */
+#if STATIC_TASK_STACKS
+static portSTACK_TYPE io_stack[IO_STACK_SIZE];
+#define IO_STACK	io_stack
+#else
+#define IO_STACK	NULL
+#endif
+
 /*
  * Internal A/D converter.
  *
@@ -91,6 +105,40 @@ static xSemaphoreHandle io_mutex;
 
 static volatile unsigned long adc_val[PROC_ADC_CHANNELS];
 
+/*
+ * Per-channel filters and their outputs (A/D counts).  Both are
+ * protected by io_mutex.
+ */
+static struct adc_filter_s adc_filt[ADC_SAMPLES];
+static unsigned long adc_filtered[PROC_ADC_CHANNELS];
+
+/*
+ * Scaled values, computed once per scan in io_task so adc() is just
+ * a read.  Protected by io_mutex.
+ */
+static int adc_mv[PROC_ADC_CHANNELS];
+static int adc_eng[PROC_ADC_CHANNELS];
+
+/**
+ * Calibration, precomputed from struct adc_cal_s by adc_cal_set() so
+ * the per-scan conversion is multiplies and shifts only.
+ */
+static struct adc_cal_rt_s {
+	int type;			/**< enum adc_cal_type */
+	int32_t c0;			/**< milliunits */
+	int32_t c1;			/**< milliunits per count, Q16 */
+	int32_t c2;			/**< milliunits per count^2, Q24 */
+	int npoints;			/**< table points */
+	int32_t x[ADC_CAL_PWL_POINTS];	/**< table counts */
+	int32_t y[ADC_CAL_PWL_POINTS];	/**< table milliunits */
+	int32_t slope[ADC_CAL_PWL_POINTS]; /**< segment slope, Q16 */
+} adc_cal_rt[ADC_CAL_CHANNELS];
+
+/*
+ * Hardware oversample factor (0 = off, else 2..64, power of 2).
+ */
+static int adc_oversample = 0;
+
 
 /****************************************************************************/
 
@@ -487,38 +535,160 @@ int dio_set(enum dio_sel which, int value)
  *   raw: A/D conversion value
  *   millivolts: A/D converted to millivolts (integer)
  *   engineering: A/D converted to engineering units * 1000 (i.e. milliunits)
+ *
+ * All of these are computed by io_task() when the sample is taken.
  */
 int adc(enum adc_sel which, enum adc_units scaling)
 {
-	unsigned long raw_val;	/* library defines ADC as unsigned long */
+	int val;
+
+	if ((which < adcProc0) || (which >= adcInvalid))
+		return -1;
 
 	if (xSemaphoreTake(io_mutex, IO_TIMEOUT) == pdTRUE) {
-		raw_val = adc_val[which];
+		switch (scaling) {
+		case raw:
+			val = adc_filtered[which];
+			break;
+		case millivolts:
+			val = adc_mv[which];
+			break;
+		case engineering:
+			val = adc_eng[which];
+			break;
+		default:
+			val = -1;	/* Shouldn't get here */
+			break;
+		}
 		xSemaphoreGive(io_mutex);
 	} else {
 		lprintf("I2C semaphore timeout line %d\r\n", __LINE__);
 		return 0;
 	}
+	return val;
+}
+
+/****************************************************************************/
+
+/*
+ * Convert A/D counts to engineering milliunits with a precomputed
+ * calibration.
+ */
+static int adc_cal_eval(const struct adc_cal_rt_s *cal, int32_t counts)
+{
+	int64_t acc;
+	int j;
+
+	switch (cal->type) {
+	case adcCalLinear:
+		return cal->c0 + (int32_t)(((int64_t)cal->c1 * counts) >> 16);
+	case adcCalPoly:
+		acc = ((int64_t)cal->c2 * counts * counts) >> 8;
+		acc += (int64_t)cal->c1 * counts;
+		return cal->c0 + (int32_t)(acc >> 16);
+	case adcCalTable:
+		/*
+		 * Find the segment; extrapolate off either end with the
+		 * first or last segment.
+		 */
+		for (j = 0; j < cal->npoints - 2; j++) {
+			if (counts < cal->x[j + 1])
+				break;
+		}
+		return cal->y[j] + (int32_t)(((int64_t)cal->slope[j] *
+			(counts - cal->x[j])) >> 16);
+	default:
+		return 0;
+	}
+}
+
+/****************************************************************************/
+
+/*
+ * Set the calibration of an A/D channel.
+ */
+int adc_cal_set(enum adc_sel which, const struct adc_cal_s *cal)
+{
+	struct adc_cal_rt_s rt;
+	int64_t slope;
+	int j;
+
+	if ((which < adcProc0) || (which >= ADC_CAL_CHANNELS))
+		return -1;
+
+	memset(&rt, 0, sizeof(rt));
+	rt.type = cal->type;
+	switch (cal->type) {
+	case adcCalLinear:
+	case adcCalPoly:
+		rt.c0 = cal->coef[0];
+		rt.c1 = cal->coef[1];
+		rt.c2 = (cal->type == adcCalPoly) ? cal->coef[2] : 0;
+		break;
+	case adcCalTable:
+		if ((cal->npoints < 2) || (cal->npoints > ADC_CAL_PWL_POINTS))
+			return -1;
+		rt.npoints = cal->npoints;
+		for (j = 0; j < cal->npoints; j++) {
+			rt.x[j] = cal->x[j];
+			rt.y[j] = cal->y[j];
+			if ((j > 0) && (rt.x[j] <= rt.x[j - 1]))
+				return -1;
+		}
+		/*
+		 * The only divides: once per segment, here.
+		 */
+		for (j = 0; j < cal->npoints - 1; j++) {
+			slope = (((int64_t)rt.y[j + 1] - (int64_t)rt.y[j])
+					<< 16) /
+				((int64_t)rt.x[j + 1] - (int64_t)rt.x[j]);
+			if ((slope > INT32_MAX) || (slope < INT32_MIN))
+				return -1;
+			rt.slope[j] = slope;
+		}
+		break;
+	default:
+		return -1;
+	}
+
+	if (xSemaphoreTake(io_mutex, IO_TIMEOUT) == pdTRUE) {
+		adc_cal_rt[which] = rt;
+		xSemaphoreGive(io_mutex);
+		return 0;
+	}
+	lprintf("adc_cal_set() semaphore timeout line %d\r\n", __LINE__);
+	return -1;
+}
+
+/****************************************************************************/
+
+/*
+ * Scale A/D counts (e.g. from the history) like adc() scales a sample.
+ */
+int adc_scale(enum adc_sel which, enum adc_units scaling, int counts)
+{
+	int val;
+
+	if ((which < adcProc0) || (which >= adcInvalid))
+		return -1;
 
 	switch (scaling) {
 	case raw:
-		return raw_val;
+		return counts;
 	case millivolts:
-		return (raw_val * VREF) / 1024;
+		return (counts * VREF) >> 10;
 	case engineering:
-		if (which == adcProcTemp) {
-			/*
-			 * SENSOR = 2.7 - ((T + 55) / 75)
-			 * T = ((2.7 - SENSOR) * 75) - 55
-			 */
-			return ((2700 - (raw_val * VREF) / 1024) * 75) - 55000;
-		}
-		/*
-		 * We don't have engineering units, just return mV
-		 */
-		return (raw_val * VREF) / 1024;
+		/* Only these have a calibration. */
+		if (which >= ADC_CAL_CHANNELS)
+			return -1;
+		if (xSemaphoreTake(io_mutex, IO_TIMEOUT) != pdTRUE)
+			return 0;
+		val = adc_cal_eval(&adc_cal_rt[which], counts);
+		xSemaphoreGive(io_mutex);
+		return val;
+	default:
+		return -1;
 	}
-	return -1;	/* Shouldn't get here */
 }
 
 /****************************************************************************/
@@ -528,13 +698,17 @@ int adc(enum adc_sel which, enum adc_units scaling)
  */
 static void adc_setup(void)
 {
-	ADCHardwareOversampleConfigure(ADC0_BASE, ADC_SAC_AVG_OFF);
+	ADCHardwareOversampleConfigure(ADC0_BASE, adc_oversample);
 	ADCReferenceSet(ADC0_BASE, ADC_REF_INT);
 
 	/*
 	 * Create a sample sequence for our A/D (what inputs to sample).
 	 */
-	ADCSequenceConfigure(ADC0_BASE, 0, ADC_TRIGGER_PROCESSOR, 0);
+	/*
+	 * Priority 1: the waveform capture sequencer (adccap.c) gets
+	 * priority 0 so a scan doesn't delay its timed conversions.
+	 */
+	ADCSequenceConfigure(ADC0_BASE, 0, ADC_TRIGGER_PROCESSOR, 1);
 	ADCSequenceStepConfigure(ADC0_BASE, 0, 0, ADC_CTL_CH0);
 	ADCSequenceStepConfigure(ADC0_BASE, 0, 1, ADC_CTL_CH1);
 	ADCSequenceStepConfigure(ADC0_BASE, 0, 2, ADC_CTL_CH2);
@@ -546,6 +720,107 @@ static void adc_setup(void)
 
 /****************************************************************************/
 
+/**
+ * Run the freshly converted samples through the per-channel filters
+ * and scale them.  Must be called with io_mutex held.
+ */
+static void filter_proc_adc(void)
+{
+	int j;
+
+	for (j = 0; j < ADC_SAMPLES; j++) {
+		adc_filtered[j] = adc_filter_run(&adc_filt[j], adc_val[j]);
+		adc_mv[j] = (adc_filtered[j] * VREF) >> 10;
+		adc_eng[j] = adc_cal_eval(&adc_cal_rt[j], adc_filtered[j]);
+	}
+}
+
+/****************************************************************************/
+
+/*
+ * Select the digital filter for an A/D channel.
+ */
+int adc_filter_set(enum adc_sel which, enum adc_filter_type type, int param)
+{
+	struct adc_filter_s tmp;
+	int ret;
+
+	if ((which < adcProc0) || (which >= ADC_SAMPLES))
+		return -1;
+	/*
+	 * Validate into a scratch copy so a bad request doesn't
+	 * disturb the running filter.
+	 */
+	if (adc_filter_init(&tmp, type, param) != 0)
+		return -1;
+
+	if (xSemaphoreTake(io_mutex, IO_TIMEOUT) == pdTRUE) {
+		adc_filt[which] = tmp;
+		xSemaphoreGive(io_mutex);
+		ret = 0;
+	} else {
+		lprintf("adc_filter_set() semaphore timeout line %d\r\n",
+			__LINE__);
+		ret = -1;
+	}
+	return ret;
+}
+
+/****************************************************************************/
+
+/*
+ * Get the digital filter configuration of an A/D channel.
+ */
+int adc_filter_get(enum adc_sel which, enum adc_filter_type *type, int *param)
+{
+	if ((which < adcProc0) || (which >= ADC_SAMPLES))
+		return -1;
+
+	/*
+	 * Two word reads, the mutex isn't worth it.
+	 */
+	*type  = adc_filt[which].type;
+	*param = adc_filt[which].param;
+	return 0;
+}
+
+/****************************************************************************/
+
+/*
+ * Set the A/D hardware oversampling factor.
+ */
+int adc_oversample_set(int factor)
+{
+	if ((factor == 1) || (factor > 64) || (factor & (factor - 1)))
+		return -1;
+
+	if (xSemaphoreTake(io_mutex, IO_TIMEOUT) == pdTRUE) {
+		adc_oversample = factor;
+		/*
+		 * If a sequence is converting right now, that one scan
+		 * may be averaged either way; the filters don't care.
+		 */
+#if (PART != LM3S2110)
+		ADCHardwareOversampleConfigure(ADC0_BASE, adc_oversample);
+#endif
+		xSemaphoreGive(io_mutex);
+		return 0;
+	}
+	lprintf("adc_oversample_set() semaphore timeout line %d\r\n",
+		__LINE__);
+	return -1;
+}
+
+/*
+ * Get the A/D hardware oversampling factor.
+ */
+int adc_oversample_get(void)
+{
+	return adc_oversample;
+}
+
+/****************************************************************************/
+
 /**
  * Do a processor A/D conversion sequence.
  */
@@ -573,6 +848,8 @@ static void scan_proc_adc(void)
 		if (xSemaphoreTake(io_mutex, IO_TIMEOUT)) {
 			samples = ADCSequenceDataGet(ADC0_BASE, 0,
 				(unsigned long *)adc_val);
+			if (samples == ADC_SAMPLES)
+				filter_proc_adc();
 			xSemaphoreGive(io_mutex);
 		}
 #if (DEBUG > 0)
@@ -594,6 +871,7 @@ static void io_task(void *params)
 {
 	portTickType last_wake_time;
 	int ticks=0;
+	int scanned = FALSE;	/* first scan done */
 
 #if (PART != LM3S2110)
 	adc_setup();
@@ -611,7 +889,12 @@ static void io_task(void *params)
 
 #if (PART != LM3S2110)
 		scan_proc_adc();
+		hist_sample();
 #endif
+		if (!scanned) {
+			boot_mark("io_scan");
+			scanned = TRUE;
+		}
 		/*
 		 * Send a char out the serial port every 10 sec.
 		 */
@@ -622,6 +905,9 @@ static void io_task(void *params)
 		ticks++;
 
 		vTaskDelayUntil(&last_wake_time, POLL_DELAY);
+#if (PART != LM3S2110)
+		latency_io(configCPU_CLOCK_HZ / POLL_HZ);
+#endif
 	}
 }
 
@@ -635,19 +921,34 @@ int io_init(void)
 	portBASE_TYPE ret;
 	int j;
 
-	for (j = 0; j < sizeof(adc_val) / sizeof(adc_val[0]); j++)
+	for (j = 0; j < sizeof(adc_val) / sizeof(adc_val[0]); j++) {
 		adc_val[j] = 0;
+		adc_filtered[j] = 0;
+	}
+	for (j = 0; j < ADC_SAMPLES; j++)
+		adc_filter_init(&adc_filt[j], adcFiltNone, 0);
 
 	io_mutex = xSemaphoreCreateMutex();
 	if (io_mutex == NULL)
 		return -1;	/* return failure flag */
 
-	ret = xTaskCreate(io_task,
+	for (j = 0; j < ADC_CAL_CHANNELS; j++) {
+		if (adc_cal_set(j, &kvcfg.adc_cal[j]) != 0)
+			lprintf("adc_cal_set(%d) bad calibration\r\n", j);
+	}
+
+#if (PART != LM3S2110)
+	hist_init();
+#endif
+
+	ret = xTaskGenericCreate(io_task,
 		(signed portCHAR *)"io",
-		DEFAULT_STACK_SIZE,
+		IO_STACK_SIZE,
 		NULL,
 		IO_TASK_PRIORITY,
-		&io_task_handle);
+		&io_task_handle,
+		IO_STACK,
+		NULL);
 	if (ret != pdPASS)
 		lprintf("Creation of IO task failed: %d\r\n", ret);
 
@@ -23,6 +23,8 @@ struct enumxlate_s {
         const int  len;		/**< String length, excluding the null */
 };
 
+#include <adcfilt.h>
+
 /****************************************************************************/
 
 /**
@@ -148,5 +150,68 @@ int dio_set(enum dio_sel which, int value);
  */
 int adc(enum adc_sel which, enum adc_units scaling);
 
+/**
+ * Scale A/D counts the way adc() scales a fresh sample, using the
+ * channel's current calibration.  Used for recorded values.
+ *
+ * \param which Selects which analog input the counts came from.
+ * \param scaling Selects the scaling (see adc()).
+ * \param counts Filtered A/D counts.
+ * \return The scaled value, -1 for a bad channel, or for engineering
+ * units of a channel without a calibration (ADC_CAL_CHANNELS).
+ */
+int adc_scale(enum adc_sel which, enum adc_units scaling, int counts);
+
+struct adc_cal_s;
+
+/**
+ * Set the calibration used to compute engineering units for an A/D
+ * channel.  The conversion constants are precomputed here so io_task()
+ * only multiplies and shifts once per scan and adc() does no math.
+ * This does not save the calibration; see kvcfg.adc_cal[].
+ *
+ * \param which Selects which analog input.
+ * \param cal The calibration (see partnum.h).
+ * \returns 0 on success, -1 if the channel or calibration is invalid.
+ */
+int adc_cal_set(enum adc_sel which, const struct adc_cal_s *cal);
+
+/**
+ * Select the digital filter applied to an A/D channel every scan.
+ * Changing the filter discards the channel's filter history.
+ *
+ * \param which Selects which analog input to filter.
+ * \param type Selects the filter (see adcfilt.h).
+ * \param param The window size (average, median) or shift (EMA).
+ * \returns 0 on success, -1 if the channel or parameters are invalid.
+ */
+int adc_filter_set(enum adc_sel which, enum adc_filter_type type, int param);
+
+/**
+ * Get the digital filter configuration of an A/D channel.
+ *
+ * \param which Selects which analog input.
+ * \param type Returns the filter type.
+ * \param param Returns the filter parameter.
+ * \returns 0 on success, -1 if the channel is invalid.
+ */
+int adc_filter_get(enum adc_sel which, enum adc_filter_type *type, int *param);
+
+/**
+ * Set the A/D converter hardware oversampling (averaging) factor.
+ * This applies to all channels and divides the conversion rate.
+ *
+ * \param factor 0 (off) or 2, 4, 8, 16, 32, 64 samples averaged.
+ * \returns 0 on success, -1 if the factor is invalid.
+ */
+int adc_oversample_set(int factor);
+
+/**
+ * Get the A/D converter hardware oversampling factor.
+ *
+ * \returns 0 (off) or the number of samples averaged.
+ */
+int adc_oversample_get(void);
+
 #endif
 /** \} */
@@ -0,0 +1,345 @@
+/**
+ * \file kvcfg.c
+ *
+ * Key/value user configuration.
+
+\page kvcfgpage1 Key/Value Configuration Overview
+
+The user configuration is a set of typed settings, described once by
+KVCFG_SCHEMA() in kvcfg-schema.h: id, type, name, default and valid range.
+The schema generates struct kvcfg_s, so the settings are read directly
+(kvcfg.ip, kvcfg.notes, ...) with no lookup, and a table of
+struct kvcfg_key_s for the generic accesses (by index or by name).
+
+Each setting is saved as its own record in the configuration log
+(partnum.c): the record tag is cfgTagKey + the key id and the data is the
+value (strings only up to the NUL).  Only the settings that changed are
+written.  A setting is loaded if its record is valid for the current
+schema, otherwise it keeps its default, so settings can be added without
+disturbing the ones already saved.
+
+If no setting has ever been saved, the legacy struct usercfg_s record is
+migrated and saved as settings.
+
+ *
+ * \addtogroup util Utilities
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ustdlib.h>
+
+#include <hw_types.h>
+
+#include "config.h"
+#include "partnum.h"
+#include "kvcfg.h"
+#include "logger.h"
+
+/*
+ * Public information.
+ */
+struct kvcfg_s kvcfg;
+
+/*
+ * Private information.
+ */
+#define KV_DEFAULT(id, type, name, size, dflt, min, max) \
+	.name = dflt,
+
+static const struct kvcfg_s kvcfg_defaults = {
+	KVCFG_SCHEMA(KV_DEFAULT)
+};
+
+#define KV_TYPE_str	kvStr
+#define KV_TYPE_u32	kvU32
+#define KV_TYPE_ip4	kvIp4
+#define KV_TYPE_cal	kvBlob
+
+#define KV_KEY(id, type, name, size, dflt, min, max)		\
+	{ #name, (id), KV_TYPE_##type, offsetof(struct kvcfg_s, name),	\
+	  sizeof(kvcfg.name), (min), (max) },
+
+static const struct kvcfg_key_s kv_keys[] = {
+	KVCFG_SCHEMA(KV_KEY)
+};
+
+#define KV_KEYS		(sizeof(kv_keys) / sizeof(kv_keys[0]))
+
+/*
+ * Key ids must fit in the configuration log tags.
+ */
+#define KV_ID_CHECK(id, type, name, size, dflt, min, max) \
+	typedef char kv_id_check_##name[				\
+		(((id) > 0) && ((id) < KVCFG_KEYS_MAX)) ? 1 : -1];
+
+KVCFG_SCHEMA(KV_ID_CHECK)
+
+static int kv_valid;		/* settings came from flash */
+
+/****************************************************************************/
+
+/*
+ * The setting in kvcfg.
+ */
+static void *field(const struct kvcfg_key_s *kp)
+{
+	return (char *)&kvcfg + kp->offset;
+}
+
+/*
+ * Check a value of a setting, len is its stored length.
+ */
+static int check(const struct kvcfg_key_s *kp, const void *value, int len)
+{
+	uint32_t u;
+
+	switch (kp->type) {
+	case kvStr:
+		/* Must be terminated, may be shorter than the field. */
+		return (len > 0) && (len <= kp->size) &&
+			(memchr(value, '\0', len) != NULL);
+	case kvU32:
+		if (len != sizeof(u))
+			return FALSE;
+		memcpy(&u, value, sizeof(u));
+		return (u >= kp->min) && (u <= kp->max);
+	case kvIp4:
+	case kvBlob:
+		return len == kp->size;
+	}
+	return FALSE;
+}
+
+/*
+ * The length of a setting to save: strings up to the NUL.
+ */
+static int stored_len(const struct kvcfg_key_s *kp)
+{
+	const char *p = field(kp);
+	const char *end;
+
+	if ((kp->type == kvStr) &&
+	    ((end = memchr(p, '\0', kp->size)) != NULL))
+		return end - p + 1;
+	return kp->size;
+}
+
+/****************************************************************************/
+
+/*
+ * Migrate the legacy user configuration.  A short record from older
+ * firmware only has the fields that fit in its length.
+ */
+#define LEGACY_HAS(field) \
+	(offsetof(struct usercfg_s, field) + sizeof(old->field) <= len)
+
+static int migrate(void)
+{
+	const struct usercfg_s *old;
+	int len;
+
+	if ((old = usercfg_legacy(&len)) == NULL)
+		return FALSE;
+
+	if (LEGACY_HAS(assy_pn))
+		strncpy(kvcfg.assy_pn, old->assy_pn, sizeof(kvcfg.assy_pn) - 1);
+	if (LEGACY_HAS(assy_sn))
+		strncpy(kvcfg.assy_sn, old->assy_sn, sizeof(kvcfg.assy_sn) - 1);
+	if (LEGACY_HAS(ip))
+		memcpy(kvcfg.ip, old->ip, sizeof(kvcfg.ip));
+	if (LEGACY_HAS(netmask))
+		memcpy(kvcfg.netmask, old->netmask, sizeof(kvcfg.netmask));
+	if (LEGACY_HAS(gateway))
+		memcpy(kvcfg.gateway, old->gateway, sizeof(kvcfg.gateway));
+	if (LEGACY_HAS(IPMode) && (old->IPMode <= IPADDR_USE_AUTOIP))
+		kvcfg.ip_mode = old->IPMode;
+	if (LEGACY_HAS(notes))
+		strncpy(kvcfg.notes, old->notes, sizeof(kvcfg.notes) - 1);
+	if (LEGACY_HAS(adc_cal))
+		memcpy(kvcfg.adc_cal, old->adc_cal, sizeof(kvcfg.adc_cal));
+
+	lprintf("kvcfg: migrating the legacy configuration\r\n");
+	return kvcfg_save();
+}
+
+/****************************************************************************/
+
+/*
+ * Load the settings.
+ */
+int kvcfg_init(void)
+{
+	const struct kvcfg_key_s *kp;
+	const void *rec;
+	int accepted = 0;
+	int len;
+
+	/*
+	 * Duplicate key ids are duplicate case labels.
+	 */
+#define KV_ID_CASE(id, type, name, size, dflt, min, max) case (id):
+	switch (0) {
+	KVCFG_SCHEMA(KV_ID_CASE)
+	default:
+		break;
+	}
+
+	kvcfg = kvcfg_defaults;
+
+	for (kp = kv_keys; kp < &kv_keys[KV_KEYS]; kp++) {
+		rec = cfglog_read(cfgTagKey + kp->id, &len);
+		if (rec == NULL)
+			continue;
+		if (check(kp, rec, len)) {
+			memcpy(field(kp), rec, len);
+			accepted++;
+		} else {
+			lprintf("kvcfg: %s invalid, using the default\r\n",
+				kp->name);
+		}
+	}
+
+	/* Records that all failed their checks are no configuration. */
+	kv_valid = accepted ? TRUE : migrate();
+	return kv_valid;
+}
+
+/****************************************************************************/
+
+/*
+ * Check if the settings came from flash.
+ */
+int kvcfg_valid(void)
+{
+	return kv_valid;
+}
+
+/****************************************************************************/
+
+/*
+ * Get the description of a setting by index.
+ */
+const struct kvcfg_key_s *kvcfg_key(int j)
+{
+	if ((j < 0) || (j >= KV_KEYS))
+		return NULL;
+	return &kv_keys[j];
+}
+
+/****************************************************************************/
+
+/*
+ * Find a setting by name.
+ */
+const struct kvcfg_key_s *kvcfg_find(const char *name)
+{
+	const struct kvcfg_key_s *kp;
+
+	for (kp = kv_keys; kp < &kv_keys[KV_KEYS]; kp++) {
+		if (strcmp(kp->name, name) == 0)
+			return kp;
+	}
+	return NULL;
+}
+
+/****************************************************************************/
+
+/*
+ * Set a setting from text.
+ */
+int kvcfg_set(const struct kvcfg_key_s *kp, const char *text)
+{
+	uint8_t ip[4];
+	uint32_t u;
+	char *end;
+	int j;
+
+	switch (kp->type) {
+	case kvStr:
+		if (strlen(text) >= kp->size)
+			return -1;
+		strcpy(field(kp), text);
+		return 0;
+	case kvU32:
+		u = strtoul(text, &end, 10);
+		if ((end == text) || *end || !check(kp, &u, sizeof(u)))
+			return -1;
+		memcpy(field(kp), &u, sizeof(u));
+		return 0;
+	case kvIp4:
+		for (j = 0; j < 4; j++) {
+			u = strtoul(text, &end, 10);
+			if ((end == text) || (u > 255) ||
+			    (*end != ((j < 3) ? '.' : '\0')))
+				return -1;
+			ip[j] = u;
+			text = end + 1;
+		}
+		memcpy(field(kp), ip, sizeof(ip));
+		return 0;
+	}
+	return -1;
+}
+
+/****************************************************************************/
+
+/*
+ * Format a setting as text.
+ */
+int kvcfg_format(const struct kvcfg_key_s *kp, char *buf, int size)
+{
+	const uint8_t *p = field(kp);
+	uint32_t u;
+	int len;
+	int j;
+
+	switch (kp->type) {
+	case kvStr:
+		return snprintf(buf, size, "%s", (const char *)p);
+	case kvU32:
+		memcpy(&u, p, sizeof(u));
+		return snprintf(buf, size, "%u", (unsigned)u);
+	case kvIp4:
+		return snprintf(buf, size, "%d.%d.%d.%d",
+			p[0], p[1], p[2], p[3]);
+	}
+	for (len = 0, j = 0; j < kp->size; j++) {
+		len += snprintf(buf + len, (len < size) ? size - len : 0,
+			"%02x", p[j]);
+	}
+	return len;
+}
+
+/****************************************************************************/
+
+/*
+ * Save the settings that changed.  cfglog_write() doesn't write a
+ * record that is the same as the newest one.
+ */
+int kvcfg_save(void)
+{
+	const struct kvcfg_key_s *kp;
+	int ok = TRUE;
+
+	for (kp = kv_keys; kp < &kv_keys[KV_KEYS]; kp++) {
+		if (!check(kp, field(kp), stored_len(kp)))
+			return FALSE;
+	}
+	for (kp = kv_keys; kp < &kv_keys[KV_KEYS]; kp++) {
+		if (!cfglog_write(cfgTagKey + kp->id, field(kp), stored_len(kp)))
+			ok = FALSE;
+	}
+	if (ok)
+		kv_valid = TRUE;
+	return ok;
+}
+/** \} */
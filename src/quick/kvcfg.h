@@ -0,0 +1,127 @@
+/**
+ * \file kvcfg.h
+ *
+ * Key/value user configuration definitions and declarations.
+ *
+ * \addtogroup util Utilities
+ * \{
+ *
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#ifndef KVCFG_H_
+#define KVCFG_H_
+
+#include <stdint.h>
+
+#include "partnum.h"
+#include "kvcfg-schema.h"
+
+/*
+ * The C declaration of each setting type.
+ */
+#define KV_DECL_str(name, size)	char name[size];
+#define KV_DECL_u32(name, size)	uint32_t name;
+#define KV_DECL_ip4(name, size)	uint8_t name[4];
+#define KV_DECL_cal(name, size)	struct adc_cal_s name[ADC_CAL_CHANNELS];
+
+#define KV_FIELD(id, type, name, size, dflt, min, max) \
+	KV_DECL_##type(name, size)
+
+/**
+ * The settings, one field per key of KVCFG_SCHEMA().
+ */
+struct kvcfg_s {
+	KVCFG_SCHEMA(KV_FIELD)
+};
+
+/**
+ * The current settings.  Read them directly; after changing them,
+ * kvcfg_save() checks and saves them.
+ */
+extern struct kvcfg_s kvcfg;
+
+/**
+ * Longest text of a setting (not a blob) with the NUL, see kvcfg_format().
+ */
+#define KVCFG_TEXT_MAX		256
+
+/**
+ * Setting types.
+ */
+enum kvcfg_type {
+	kvStr,			/**< NUL terminated string */
+	kvU32,			/**< Unsigned 32 bit number, min .. max */
+	kvIp4,			/**< IPv4 address, 4 bytes network order */
+	kvBlob,			/**< Anything else, fixed size */
+	kvInvalid		/**< Invalid flag, MUST BE LAST */
+};
+
+/**
+ * Description of a setting.
+ */
+struct kvcfg_key_s {
+	const char *name;	/**< Key name, the field name */
+	uint8_t  id;		/**< Key id in flash */
+	uint8_t  type;		/**< enum kvcfg_type */
+	uint16_t offset;	/**< offsetof(struct kvcfg_s, name) */
+	uint16_t size;		/**< sizeof the field */
+	uint32_t min;		/**< kvU32: minimum */
+	uint32_t max;		/**< kvU32: maximum */
+};
+
+/**
+ * Load the settings: the defaults, overridden by the newest valid
+ * records in the configuration log.  If there are none, the legacy
+ * user configuration is migrated and saved.  config_init() must have
+ * been called.
+ * \returns true => the settings came from flash.
+ */
+int kvcfg_init(void);
+
+/**
+ * Check if the settings came from flash (or have been saved).
+ */
+int kvcfg_valid(void);
+
+/**
+ * Get the description of a setting.
+ * \param j Index, 0 .. number of settings - 1.
+ * \returns The description, NULL past the last setting.
+ */
+const struct kvcfg_key_s *kvcfg_key(int j);
+
+/**
+ * Find a setting by name.
+ * \returns The description, NULL if there is no such setting.
+ */
+const struct kvcfg_key_s *kvcfg_find(const char *name);
+
+/**
+ * Set a setting from text: a string, a decimal number or a dotted IP
+ * address.  Blobs can't be set this way.  Doesn't save it.
+ * \returns 0 on success, -1 if the text isn't valid for the setting.
+ */
+int kvcfg_set(const struct kvcfg_key_s *kp, const char *text);
+
+/**
+ * Format a setting as text (as kvcfg_set() takes it, blobs in hex).
+ * \returns The length of the text, as snprintf().
+ */
+int kvcfg_format(const struct kvcfg_key_s *kp, char *buf, int size);
+
+/**
+ * Save the settings that changed to the configuration log.
+ * \returns
+ *  - TRUE => settings saved.
+ *  - FALSE => a setting is invalid (nothing is saved) or the
+ *    flash couldn't be written.
+ */
+int kvcfg_save(void);
+
+#endif /* KVCFG_H_ */
+/** \} */
@@ -0,0 +1,289 @@
+/**
+ * \file latency.c
+ *
+ * Interrupt latency and jitter histograms.
+
+\page latencypage1 Latency Overview
+
+To see how Ethernet traffic and logging affect the real time behavior,
+a few latencies are collected into log2 histograms of CPU clocks:
+- ISR entry: Timer 3 interrupts LATENCY_PROBE_HZ times a second at
+  priority LATENCY_PROBE_PRIORITY.  The ISR reads how far the timer has
+  already counted past its timeout, which is exactly the time it took to
+  get into the ISR.  Since the probe is below the maximum syscall
+  priority, this includes the kernel's critical sections.  The probe is
+  a constant interrupt load and wakes the idle sleep, so it only runs
+  when asked (/latency?probe=secs) and stops itself when the time is up.
+- Tick jitter: the error of each RTOS tick period, from the tick hook.
+- Ethernet wakeup: from the receive interrupt giving the semaphore to
+  the receive task running.
+- io_task() jitter: the error of each io_task() scan period.
+
+All but the ISR entry use Timer 1, the free running run time stats
+timer.  Nothing is locked: each histogram is written by one context,
+and a reset is only requested here and carried out by that writer.
+The /latency CGI reports them (and resets them with reset=1).
+
+ *
+ * \addtogroup util Utilities
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <hw_types.h>
+#include <hw_memmap.h>
+#include <hw_ints.h>
+#include <hw_timer.h>
+#include <interrupt.h>
+#include <sysctl.h>
+#include <timer.h>
+
+#include <config.h>
+#include <latency.h>
+#include <timerconfig.h>
+
+#define PROBE_LOAD	(configCPU_CLOCK_HZ / LATENCY_PROBE_HZ - 1)
+#define TICK_CLOCKS	(configCPU_CLOCK_HZ / configTICK_RATE_HZ)
+
+/*
+ * Private information.
+ */
+static const char *latnames[] = {
+	"isr_entry", "tick_jitter", "eth_wake", "io_jitter"
+};
+
+static struct latency_hist_s hists[latInvalid];
+static volatile unsigned char reset_req[latInvalid];
+
+static volatile uint32_t eth_stamp;	/* Timer 1 at the receive interrupt */
+static volatile int eth_pending;	/* eth_stamp is valid */
+
+static uint32_t tick_last;		/* Timer 1 at the last tick */
+
+static volatile uint32_t probe_left;	/* probe interrupts to go */
+static int probe_forever;		/* LATENCY_PROBE_BOOT */
+
+/****************************************************************************/
+
+/*
+ * Get the name of a measurement.
+ */
+const char *latencytostr(enum latency_sel which)
+{
+	if ((which < latIsrEntry) || (which >= latInvalid))
+		return "?";
+	return latnames[which];
+}
+
+/****************************************************************************/
+
+/*
+ * Record a sample.
+ */
+void latency_record(enum latency_sel which, uint32_t clocks)
+{
+	struct latency_hist_s *hp = &hists[which];
+	int b;
+
+	if (reset_req[which]) {
+		memset(hp, 0, sizeof(*hp));
+		reset_req[which] = 0;
+	}
+
+	/* Bucket is the number of significant bits. */
+	b = clocks ? (32 - __builtin_clz(clocks)) : 0;
+	if (b >= LATENCY_BUCKETS)
+		b = LATENCY_BUCKETS - 1;
+	hp->bucket[b]++;
+
+	if ((hp->count == 0) || (clocks < hp->min))
+		hp->min = clocks;
+	if (clocks > hp->max)
+		hp->max = clocks;
+	hp->count++;
+}
+
+/****************************************************************************/
+
+/*
+ * Record how far a period measured with Timer 1 was off.
+ */
+static void record_period(enum latency_sel which, uint32_t *last,
+	uint32_t expected)
+{
+	uint32_t now = timerTIMER_1_COUNT_VALUE;
+	uint32_t period = *last - now;		/* counts down */
+
+	if (*last != 0)
+		latency_record(which, (period > expected) ?
+			(period - expected) : (expected - period));
+	*last = now ? now : 1;
+}
+
+/****************************************************************************/
+
+/*
+ * Clear all histograms.
+ */
+void latency_reset(void)
+{
+	int j;
+
+	for (j = 0; j < latInvalid; j++)
+		reset_req[j] = 1;
+}
+
+/****************************************************************************/
+
+/*
+ * Copy a histogram.
+ */
+void latency_get(enum latency_sel which, struct latency_hist_s *hist)
+{
+	if (reset_req[which])
+		memset(hist, 0, sizeof(*hist));
+	else
+		*hist = hists[which];
+}
+
+/****************************************************************************/
+
+/*
+ * Measure the tick period.
+ */
+void latency_tick(void)
+{
+	record_period(latTickJitter, &tick_last, TICK_CLOCKS);
+}
+
+/****************************************************************************/
+
+/*
+ * The tick wasn't a tick period, start over with the next one.
+ */
+void latency_tick_resync(void)
+{
+	tick_last = 0;
+}
+
+/****************************************************************************/
+
+/*
+ * Measure the io_task() period.
+ */
+void latency_io(uint32_t expected)
+{
+	static uint32_t last;
+
+	record_period(latIoJitter, &last, expected);
+}
+
+/****************************************************************************/
+
+/*
+ * Time stamp a receive interrupt.  Only the first one counts until the
+ * task wakes up.
+ */
+void latency_eth_isr(void)
+{
+	if (!eth_pending) {
+		eth_stamp = timerTIMER_1_COUNT_VALUE;
+		eth_pending = 1;
+	}
+}
+
+/****************************************************************************/
+
+/*
+ * The receive task woke up.
+ */
+void latency_eth_wake(void)
+{
+	if (eth_pending) {
+		latency_record(latEthWake, eth_stamp - timerTIMER_1_COUNT_VALUE);
+		eth_pending = 0;
+	}
+}
+
+/****************************************************************************/
+
+/*
+ * Probe timer interrupt: the timer reloaded at the timeout and has been
+ * counting down since, so how far it got is the entry latency.
+ */
+void LatencyProbeIntHandler(void)
+{
+	uint32_t now = HWREG(TIMER3_BASE + TIMER_O_TAR);
+
+	TimerIntClear(TIMER3_BASE, TIMER_TIMA_TIMEOUT);
+	latency_record(latIsrEntry, PROBE_LOAD - now);
+
+	if (!probe_forever && (--probe_left == 0))
+		TimerDisable(TIMER3_BASE, TIMER_A);
+}
+
+/****************************************************************************/
+
+/*
+ * Set up the probe timer.
+ */
+void latency_init(void)
+{
+	SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER3);
+	TimerConfigure(TIMER3_BASE, TIMER_CFG_32_BIT_PER);
+	TimerLoadSet(TIMER3_BASE, TIMER_A, PROBE_LOAD);
+
+	IntPrioritySet(INT_TIMER3A,
+		SET_SYSCALL_INTERRUPT_PRIORITY(LATENCY_PROBE_PRIORITY));
+	IntEnable(INT_TIMER3A);
+	TimerIntEnable(TIMER3_BASE, TIMER_TIMA_TIMEOUT);
+
+#if (LATENCY_PROBE_BOOT == 1)
+	probe_forever = 1;
+	TimerEnable(TIMER3_BASE, TIMER_A);
+#endif
+}
+
+/****************************************************************************/
+
+/*
+ * Start or stop the probe.
+ */
+void latency_probe(unsigned secs)
+{
+	if (probe_forever)
+		return;
+	if (secs > (UINT32_MAX / LATENCY_PROBE_HZ))
+		secs = UINT32_MAX / LATENCY_PROBE_HZ;
+
+	taskENTER_CRITICAL();
+	TimerDisable(TIMER3_BASE, TIMER_A);
+	probe_left = secs * LATENCY_PROBE_HZ;
+	if (probe_left != 0) {
+		TimerLoadSet(TIMER3_BASE, TIMER_A, PROBE_LOAD);
+		TimerEnable(TIMER3_BASE, TIMER_A);
+	}
+	taskEXIT_CRITICAL();
+}
+
+/****************************************************************************/
+
+/*
+ * Seconds the probe has left.
+ */
+unsigned latency_probe_left(void)
+{
+	if (probe_forever)
+		return UINT32_MAX / LATENCY_PROBE_HZ;
+	return (probe_left + LATENCY_PROBE_HZ - 1) / LATENCY_PROBE_HZ;
+}
+/** \} */
@@ -0,0 +1,135 @@
+/**
+ * \file latency.h
+ *
+ * Interrupt latency and jitter histogram definitions and declarations.
+ *
+ * \addtogroup util Utilities
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+#include <stdint.h>
+
+/**
+ * Histogram buckets: bucket 0 counts 0, bucket n counts
+ * 2^(n-1) .. 2^n - 1 CPU clocks, the last bucket counts everything longer.
+ */
+#define LATENCY_BUCKETS		24
+
+/**
+ * The measurements.
+ */
+enum latency_sel {
+	latIsrEntry,		/**< Probe timer timeout to its ISR */
+	latTickJitter,		/**< RTOS tick period error */
+	latEthWake,		/**< ETH0IntHandler() to the receive task */
+	latIoJitter,		/**< io_task() period error */
+	latInvalid		/**< Invalid flag, MUST BE LAST */
+};
+
+/**
+ * A histogram, all times in CPU clocks.
+ */
+struct latency_hist_s {
+	uint32_t count;			/**< Samples recorded */
+	uint32_t min;			/**< Shortest */
+	uint32_t max;			/**< Longest */
+	uint32_t bucket[LATENCY_BUCKETS]; /**< log2 histogram */
+};
+
+/**
+ * Get the name of a measurement.
+ *
+ * \param which The measurement.
+ * \returns The name.
+ */
+const char *latencytostr(enum latency_sel which);
+
+/**
+ * Record a sample.  Each measurement must only be recorded from one
+ * context (one ISR or one task), so this doesn't lock.
+ *
+ * \param which The measurement.
+ * \param clocks The sample, in CPU clocks.
+ */
+void latency_record(enum latency_sel which, uint32_t clocks);
+
+/**
+ * Clear all histograms.  The clearing is done by the next
+ * latency_record() of each measurement.
+ */
+void latency_reset(void);
+
+/**
+ * Copy a histogram.  This isn't locked either: a sample recorded during
+ * the copy may be partially included.
+ *
+ * \param which The measurement.
+ * \param hist Filled in with the histogram.
+ */
+void latency_get(enum latency_sel which, struct latency_hist_s *hist);
+
+/**
+ * Measure the tick period, called from the RTOS tick hook.
+ */
+void latency_tick(void);
+
+/**
+ * Don't measure this tick, called from the RTOS tick hook instead of
+ * latency_tick() for the ticks made up after a tickless sleep.
+ */
+void latency_tick_resync(void);
+
+/**
+ * Measure the io_task() period, called every scan.
+ *
+ * \param expected The intended period, in CPU clocks.
+ */
+void latency_io(uint32_t expected);
+
+/**
+ * Time stamp a receive interrupt, called by ETH0IntHandler().
+ */
+void latency_eth_isr(void);
+
+/**
+ * The receive task woke up, called by ethernetif_input().
+ */
+void latency_eth_wake(void);
+
+/**
+ * Set up the ISR entry latency probe timer, and start it if
+ * LATENCY_PROBE_BOOT.
+ */
+void latency_init(void);
+
+/**
+ * Start or stop the ISR entry latency probe.  It interrupts
+ * LATENCY_PROBE_HZ times a second, which also wakes the idle sleep, so
+ * it runs only for a while and then stops itself.
+ *
+ * \param secs How long to run, 0 stops it now.
+ */
+void latency_probe(unsigned secs);
+
+/**
+ * Get the seconds the ISR entry latency probe has left to run.
+ *
+ * \returns The seconds, 0 if stopped.
+ */
+unsigned latency_probe_left(void);
+
+/**
+ * Probe timer interrupt handler (in the vector table).
+ */
+void LatencyProbeIntHandler(void);
+
+#endif /* LATENCY_H_ */
+/** \} */
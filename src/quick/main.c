@@ -80,9 +80,16 @@ pushd quickstart; make; popd;
 #include "ETHIsr.h"
 
 #include "partnum.h"
+#include "kvcfg.h"
+#include "crc32.h"
+#include "boottime.h"
 #include "util.h"
 #include "logger.h"
 #include "io.h"
+#include "dioevent.h"
+#include "latency.h"
+#include "taskstats.h"
+#include "tickless.h"
 #include "debugSupport.h"
 #include "buildDate.h"
 
@@ -123,78 +130,46 @@ void ethernetThread(void *pParams);
 
 /****************************************************************************/
 
+#if !USE_PROGRAM_STARTUP
+#if (PART != LM3S2110)
+#if ERASE_PERMCFG
+#if !PROTECT_PERMCFG
+static int permcfg_blank;	/* permcfg_erase() result for the banner */
+#endif
+#endif
+#endif
+
+#if (PART == LM3S8962) && QUICK_ETHERNET
+/*
+ * The OLED is initialized by the banner task; the ethernet task waits for
+ * it before drawing on it.
+ */
+static xSemaphoreHandle oled_sem;
+#endif
+
 /**
- * Main function
+ * Banner task: everything that is only for people to read, done after
+ * the I/O and the watchdog are running.
  *
- * This is the traditional C main().
+ * \req \req_id The \program \shall identify:
+ * - The program version.
+ * - A copyright string.
+ * - The board identification.
+ * - The assembly identification.
+ * - Network configuration information.
+ *
+ * \todo Issue #1175 Add software build time, git hash, software
+ *    version to build.
  */
-int main(void)
+static void banner_task(void *params)
 {
-
-#if USE_PROGRAM_STARTUP
-	program_startup();
-#else
 	char s[64];		/* sprintf string */
 	unsigned long why;	/* Why did we get reset? Why? */
 
-	prvSetupHardware();
-	init_logger();
-
 #if PART == LM3S8962
 	RIT128x96x4Init(1000000);
 #endif
 
-	/*
-	 * \todo maybe this needs to be earlier or later in the code.
-	 * Enable fault handlers in addition to FaultIsr()
-	 */
-	NVIC_SYS_HND_CTRL_R |= NVIC_SYS_HND_CTRL_USAGE
-			              |NVIC_SYS_HND_CTRL_BUS
-			              |NVIC_SYS_HND_CTRL_MEM;
-
-#if (PART != LM3S2110)
-	/*
-	 * Allow the following to erase the permanent configuration flash page:
-	 *
-	 * make PROTECT_PERMCFG="-D PROTECT_PERMCFG=0" \
-	 * ERASE_PERMCFG="-D ERASE_PERMCFG=1"
-	 *
-	 * The program will continue to erase the permanent configuration structure
-	 * at every powerup, so the program must be recompiled without the
-	 * ERASE_PERMCFG=1 part and reloaded to allow a permanent configuration
-	 * record to persist through power cycles.
-	 */
-#if ERASE_PERMCFG
-#if !PROTECT_PERMCFG
-
-	if (permcfg_erase()) {
-#if (PART == LM3S8962)
-		RIT128x96x4StringDraw("permcfg Blank",
-							0, RITLINE(10), 15);
-#endif
-	}
-	else {
-#if (PART == LM3S8962)
-		RIT128x96x4StringDraw("permcfg Not Blank",
-							0, RITLINE(10), 15);
-#endif
-	}
-#endif
-#endif
-
-	config_init();
-#endif
-	/**
-	 * \req \req_id The \program \shall identify:
-	 * - The program version.
-	 * - A copyright string.
-	 * - The board identification.
-	 * - The assembly identification.
-	 * - Network configuration information.
-	 *
-	 * \todo Issue #1175 Add software build time, git hash, software
-	 *    version to build.
-	 */
 	lstr("\r\nCRI Quickstart\r\n");
 #if (PART == LM3S2110)
 	lstr("LM3S2110 Eval Board\r\n");
@@ -207,11 +182,11 @@ int main(void)
 
 	lprintf("   Software Build Date: %s\n", buildDate);
 #if (PART != LM3S2110)
-	lprintf("  Assembly Part Number: %s\n", usercfg.assy_pn);
-	lprintf("Assembly Serial Number: %s\n", usercfg.assy_sn);
+	lprintf("  Assembly Part Number: %s\n", kvcfg.assy_pn);
+	lprintf("Assembly Serial Number: %s\n", kvcfg.assy_sn);
 	lprintf("     Board Part Number: %s\n", permcfg.bd_pn);
 	lprintf("   Board Serial Number: %s\n", permcfg.bd_sn);
-	lprintf("Notes:\r\n %s\r\n", usercfg.notes);
+	lprintf("Notes:\r\n %s\r\n", kvcfg.notes);
 #endif
 #if (PART == LM3S8962)
 	/*
@@ -237,6 +212,15 @@ int main(void)
 	s[16]=0;
 	RIT128x96x4StringDraw(s, 0, RITLINE(2), 15);
 	RIT128x96x4StringDraw(&s[17], 0, RITLINE(3), 15);
+#if ERASE_PERMCFG
+#if !PROTECT_PERMCFG
+	RIT128x96x4StringDraw(permcfg_blank ?
+		"permcfg Blank" : "permcfg Not Blank", 0, RITLINE(10), 15);
+#endif
+#endif
+#if QUICK_ETHERNET
+	xSemaphoreGive(oled_sem);
+#endif
 #endif
 
 	/**
@@ -263,8 +247,90 @@ int main(void)
 		lprintf("\r\n");
 	}
 
+	image_check();
+	boot_mark("banner");
+
+	/*
+	 * Without a network the boot is done, otherwise the ethernet task
+	 * reports it when the address is bound.
+	 */
+#if QUICK_ETHERNET
+	if (!SysCtlPeripheralPresent(SYSCTL_PERIPH_ETH))
+#endif
+		boot_report();
+
+	vTaskDelete(NULL);
+}
+#endif
+
+/****************************************************************************/
+
+/**
+ * Main function
+ *
+ * This is the traditional C main().  Only what is needed for the I/O and
+ * the watchdog is done before the scheduler starts, the banner and the
+ * network come up in their own tasks (see \ref bootpage1).
+ */
+int main(void)
+{
+
+#if USE_PROGRAM_STARTUP
+	program_startup();
+	vSetupHighFrequencyTimer();
+	image_check();
+#else
+	prvSetupHardware();
+	vSetupHighFrequencyTimer();
+	boot_mark("timer");
+	init_logger();
+
+	/*
+	 * \todo maybe this needs to be earlier or later in the code.
+	 * Enable fault handlers in addition to FaultIsr()
+	 */
+	NVIC_SYS_HND_CTRL_R |= NVIC_SYS_HND_CTRL_USAGE
+			              |NVIC_SYS_HND_CTRL_BUS
+			              |NVIC_SYS_HND_CTRL_MEM;
+
+#if (PART != LM3S2110)
+	/*
+	 * Allow the following to erase the permanent configuration flash page:
+	 *
+	 * make PROTECT_PERMCFG="-D PROTECT_PERMCFG=0" \
+	 * ERASE_PERMCFG="-D ERASE_PERMCFG=1"
+	 *
+	 * The program will continue to erase the permanent configuration structure
+	 * at every powerup, so the program must be recompiled without the
+	 * ERASE_PERMCFG=1 part and reloaded to allow a permanent configuration
+	 * record to persist through power cycles.  The result is shown by the
+	 * banner task.
+	 */
+#if ERASE_PERMCFG
+#if !PROTECT_PERMCFG
+	permcfg_blank = permcfg_erase();
+#endif
+#endif
+
+	config_init();
+	kvcfg_init();
+	boot_mark("config");
+#endif
+
 	io_init();
+	dio_event_init();
+	boot_mark("io");
 
+#if (PART == LM3S8962) && QUICK_ETHERNET
+	vSemaphoreCreateBinary(oled_sem);
+	xSemaphoreTake(oled_sem, 0);
+#endif
+	xTaskCreate(banner_task,
+		    (signed char *)"banner",
+		    DEFAULT_STACK_SIZE,
+		    NULL,
+		    BANNER_TASK_PRIORITY,
+		    NULL);
 #endif
 
 	util_init();
@@ -293,7 +359,10 @@ int main(void)
 	 */
 	IntMasterEnable();
 
-	vSetupHighFrequencyTimer();
+#if (PART != LM3S2110)
+	latency_init();
+#endif
+	boot_mark("sched");
 	vTaskStartScheduler();
 	DPRINTF(0,"Idle Task Create Failed.");
 
@@ -444,31 +513,36 @@ void ethernetThread(void *pParams)
 #endif
 		ipconfig.GWAddr    = SET_GW_ADR;
 	} else {
-		ipconfig.IPMode = usercfg.IPMode;
+		ipconfig.IPMode = kvcfg.ip_mode;
 		ipconfig.IPAddr =
-			IP2LONG(usercfg.ip[0],
-					usercfg.ip[1],
-					usercfg.ip[2],
-					usercfg.ip[3]);
+			IP2LONG(kvcfg.ip[0],
+					kvcfg.ip[1],
+					kvcfg.ip[2],
+					kvcfg.ip[3]);
 		ipconfig.NetMask =
-			IP2LONG(usercfg.netmask[0],
-					usercfg.netmask[1],
-					usercfg.netmask[2],
-					usercfg.netmask[3]);
+			IP2LONG(kvcfg.netmask[0],
+					kvcfg.netmask[1],
+					kvcfg.netmask[2],
+					kvcfg.netmask[3]);
 		ipconfig.GWAddr=
-			IP2LONG(usercfg.gateway[0],
-					usercfg.gateway[1],
-					usercfg.gateway[2],
-					usercfg.gateway[3]);
+			IP2LONG(kvcfg.gateway[0],
+					kvcfg.gateway[1],
+					kvcfg.gateway[2],
+					kvcfg.gateway[3]);
 	}
 
-	LWIPServiceTaskInit(&ipconfig);
+	if (LWIPServiceTaskInit(&ipconfig) != 0) {
+		lstr("<no network>\r\n");
+		vTaskDelete(NULL);
+		return;
+	}
+	boot_mark("ip");
 
 	/*
 	 * Get actual MAC and IP address programmed
 	 */
 	EthernetMACAddrGet(ETH_BASE, &hwaddr[0]);
-	LWIPServiceTaskIPConfigGet(&lwip_netif, &ipconfig);
+	LWIPServiceTaskIPConfigGet(&lwip_netif[0], &ipconfig);
 
 	/*
 	 * Print Ethernet configuration to serial
@@ -487,8 +561,10 @@ void ethernetThread(void *pParams)
 
 #if (PART == LM3S8962)
 	/*
-	 * Print Ethernet configuration to OLED screen
+	 * Print Ethernet configuration to OLED screen, once the banner task
+	 * has initialized it.
 	 */
+	xSemaphoreTake(oled_sem, portMAX_DELAY);
 	sprintf(s, "MAC %02X:%02X:%02X:%02X:%02X:%02X", hwaddr[0],
 		hwaddr[1], hwaddr[2], hwaddr[3], hwaddr[4], hwaddr[5]);
 	RIT128x96x4StringDraw(s, 0, RITLINE(5), 15);
@@ -499,10 +575,12 @@ void ethernetThread(void *pParams)
 			ipconfig.IPAddr>>16 & 0xff,
 			ipconfig.IPAddr>>24 & 0xff	);
 	RIT128x96x4StringDraw(s, 0, RITLINE(6), 15);
+	xSemaphoreGive(oled_sem);
 #endif
 
 	syslogInit();
 	syslog(facility_local0 , level_err, "A message from QuickStart" );
+	boot_report();
 
 	/* Nothing else to do.  No point hanging around. */
 	vTaskDelete( NULL);
@@ -513,6 +591,23 @@ void ethernetThread(void *pParams)
 #endif
 /****************************************************************************/
 
+/**
+ * Idle hook.
+ *
+ * This is called by the idle task every time around its loop.  It must
+ * not block; it sleeps until the next interrupt.
+ */
+void vApplicationIdleHook( void )
+{
+#if IDLE_SLEEP && TICKLESS_IDLE
+	tickless_idle();
+#else
+	task_stats_idle();
+#endif
+}
+
+/****************************************************************************/
+
 /**
  * Tick hook.
  *
@@ -521,6 +616,13 @@ void ethernetThread(void *pParams)
  */
 void vApplicationTickHook( void )
 {
+	dio_event_tick();
+#if (PART != LM3S2110)
+	if (tickless_stepping())
+		latency_tick_resync();
+	else
+		latency_tick();
+#endif
 }
 
 /****************************************************************************/
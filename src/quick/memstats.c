@@ -0,0 +1,182 @@
+/**
+ * \file memstats.c
+ *
+ * lwIP heap and memory pool usage.
+
+\page memstatspage1 Memory Usage Overview
+
+To size MEM_SIZE and the MEMP_NUM_xxx / PBUF_POOL_SIZE pools in lwipopts.h
+from real traffic instead of guesses, lwIP keeps (MEM_STATS, MEMP_STATS)
+the size, current use, high water mark and failed allocations of its
+heap and of each pool.  memstats_reset() starts new high water marks, so
+a load test can be measured on its own.
+
+The high water mark of the heap doesn't tell if a large allocation would
+fit, so memstats_heap() also walks the heap for the largest free block.
+The heap is lwip_ram_heap here (LWIP_RAM_HEAP_POINTER in lwipopts.h)
+and the walk mirrors the block header of lwIP 1.4 mem.c.  It is done with
+the scheduler suspended, a few hundred blocks at most; lwIP doesn't touch
+the heap from an interrupt, so the interrupts can stay on.  (mem.c keeps
+its heap lock to itself.)  A block being split or merged by a task
+preempted in mem_malloc() or mem_free() ends the walk early, so the
+numbers can be short by that once, never wrong otherwise.
+
+The /mem_stats CGI reports the usage as JSON, mem.shtml as a table and
+memstats_log() on the serial log.
+
+ *
+ * \addtogroup util Utilities
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <lwip/opt.h>
+#include <lwip/mem.h>
+#include <lwip/memp.h>
+#include <lwip/stats.h>
+
+#include <memstats.h>
+#include <logger.h>
+
+/*
+ * The lwIP heap, with room for the end marker and the alignment as
+ * mem.c has it.
+ */
+#define HEAP_HDR	LWIP_MEM_ALIGN_SIZE(sizeof(struct heap_mem))
+#define HEAP_SIZE	LWIP_MEM_ALIGN_SIZE(MEM_SIZE)
+
+/*
+ * Block header, the same as struct mem in mem.c.  next and prev are
+ * offsets from the start of the heap.
+ */
+struct heap_mem {
+	mem_size_t next;
+	mem_size_t prev;
+	u8_t used;
+};
+
+u8_t lwip_ram_heap[HEAP_SIZE + (2 * HEAP_HDR) + MEM_ALIGNMENT];
+
+/*
+ * Private information.
+ */
+#if MEMP_STATS
+#define LWIP_MEMPOOL(name, num, size, desc) desc,
+static const char * const memp_names[MEMP_MAX] = {
+#include <lwip/memp_std.h>
+};
+#endif
+
+/****************************************************************************/
+
+/*
+ * Get the usage of the heap or a pool.
+ */
+int memstats_get(int j, struct memstats_s *ms)
+{
+	const struct stats_mem *sp;
+
+	if (j == 0) {
+		sp = &lwip_stats.mem;
+		ms->name = "HEAP";
+	}
+#if MEMP_STATS
+	else if ((j > 0) && (j <= MEMP_MAX)) {
+		sp = &lwip_stats.memp[j - 1];
+		ms->name = memp_names[j - 1];
+	}
+#endif
+	else
+		return -1;
+
+	taskENTER_CRITICAL();
+	ms->avail = sp->avail;
+	ms->used = sp->used;
+	ms->max = sp->max;
+	ms->err = sp->err;
+	taskEXIT_CRITICAL();
+	return 0;
+}
+
+/****************************************************************************/
+
+/*
+ * Walk the heap.  Anything that doesn't look like a chain going forward
+ * inside the heap ends the walk.
+ */
+void memstats_heap(struct memstats_heap_s *mh)
+{
+	u8_t *ram = (u8_t *)LWIP_MEM_ALIGN(lwip_ram_heap);
+	const struct heap_mem *mem;
+	unsigned off, next, size;
+
+	mh->free = mh->largest = mh->blocks = 0;
+
+	vTaskSuspendAll();
+	for (off = 0; off < HEAP_SIZE; off = next) {
+		mem = (const struct heap_mem *)(ram + off);
+		next = mem->next;
+		if ((next <= off) || (next > HEAP_SIZE))
+			break;
+		if (mem->used)
+			continue;
+		size = next - off - HEAP_HDR;
+		mh->free += size;
+		mh->blocks++;
+		if (size > mh->largest)
+			mh->largest = size;
+	}
+	xTaskResumeAll();
+}
+
+/****************************************************************************/
+
+/*
+ * New high water marks.
+ */
+void memstats_reset(void)
+{
+#if MEMP_STATS
+	int j;
+#endif
+
+	taskENTER_CRITICAL();
+	lwip_stats.mem.max = lwip_stats.mem.used;
+	lwip_stats.mem.err = 0;
+#if MEMP_STATS
+	for (j = 0; j < MEMP_MAX; j++) {
+		lwip_stats.memp[j].max = lwip_stats.memp[j].used;
+		lwip_stats.memp[j].err = 0;
+	}
+#endif
+	taskEXIT_CRITICAL();
+}
+
+/****************************************************************************/
+
+/*
+ * Print the usage.
+ */
+void memstats_log(void)
+{
+	struct memstats_s ms;
+	struct memstats_heap_s mh;
+	int j;
+
+	lprintf(MEMSTATS_HDR);
+	for (j = 0; memstats_get(j, &ms) == 0; j++) {
+		lprintf(MEMSTATS_ROW, ms.name, ms.avail, ms.used, ms.max,
+			ms.err);
+	}
+	memstats_heap(&mh);
+	lprintf("Heap free %u in %u blocks, largest %u\r\n",
+		mh.free, mh.blocks, mh.largest);
+}
+/** \} */
@@ -0,0 +1,73 @@
+/**
+ * \file memstats.h
+ *
+ * lwIP heap and memory pool usage definitions and declarations.
+ *
+ * \addtogroup util Utilities
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#ifndef MEMSTATS_H_
+#define MEMSTATS_H_
+
+/**
+ * Usage of the heap or of one pool.  Heap numbers are bytes, pool
+ * numbers are elements.
+ */
+struct memstats_s {
+	const char *name;	/**< "HEAP" or the lwIP pool name */
+	unsigned avail;		/**< Size */
+	unsigned used;		/**< In use now */
+	unsigned max;		/**< High water mark */
+	unsigned err;		/**< Failed allocations */
+};
+
+/**
+ * Fragmentation of the heap free space, bytes.
+ */
+struct memstats_heap_s {
+	unsigned free;		/**< Total free */
+	unsigned largest;	/**< Largest free block */
+	unsigned blocks;	/**< Number of free blocks */
+};
+
+/**
+ * Text table of memstats_get(), the header and one row.
+ */
+#define MEMSTATS_HDR	"Pool            size  used   max   err\r\n"
+#define MEMSTATS_ROW	"%14s %5u %5u %5u %5u\r\n"
+
+/**
+ * Get the usage of the heap (0) or a pool (1 ..).
+ *
+ * \param j Index.
+ * \param ms Filled in with the usage.
+ * \returns 0, -1 past the last pool.
+ */
+int memstats_get(int j, struct memstats_s *ms);
+
+/**
+ * Walk the heap for its fragmentation.
+ *
+ * \param mh Filled in with the free space.
+ */
+void memstats_heap(struct memstats_heap_s *mh);
+
+/**
+ * Start new high water marks (from the current use) and clear the
+ * failed allocation counts.
+ */
+void memstats_reset(void);
+
+/**
+ * Print the usage table and the heap fragmentation on the serial log.
+ */
+void memstats_log(void);
+
+#endif /* MEMSTATS_H_ */
+/** \} */
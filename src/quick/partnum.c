@@ -14,6 +14,8 @@
  */
 
 #include <stdint.h>
+#include <stddef.h>
+#include <string.h>
 
 #include <FreeRTOSConfig.h>
 #include <hw_types.h>
@@ -22,7 +24,7 @@
 #include "config.h"
 #include "quickstart-opts.h"
 #include "partnum.h"
-#include "partnum-initial.h"
+#include "crc32.h"
 #include "LWIPStack.h"
 /**
  * Default permanent configuration data.
@@ -54,7 +56,17 @@ static struct permcfg_s default_permcfg = {
  * and should be treated as "read-only."
  */
 struct permcfg_s permcfg;
-struct usercfg_s usercfg;
+
+/*
+ * Configuration log.
+ */
+#define PAGE_ADDR(p)	(CFGLOG_ADDR + ((p) * CFGLOG_PAGE_SIZE))
+#define REC_SIZE(len)	(sizeof(struct cfglog_rec_s) + (((len) + 3) & ~3))
+
+static const struct cfglog_rec_s *newest[cfgTagInvalid]; /* by tag */
+static int      log_page;	/* Page being written */
+static uint32_t log_free;	/* Offset of the free space in log_page */
+static uint32_t log_seq;	/* Newest sequence number */
 
 /**
  * Calculate a 32 bit simple sum checksum.
@@ -73,6 +85,268 @@ static int32_t cksum(int32_t *ptr, int size)
 	return sum;
 }
 
+/*
+ * The CRC of a log record: the header up to the CRC, then the data.
+ */
+static uint32_t rec_crc(const struct cfglog_rec_s *hdr, const void *data)
+{
+	uint32_t crc;
+
+	crc = crc32(0, hdr, offsetof(struct cfglog_rec_s, crc));
+	return crc32(crc, data, hdr->len);
+}
+
+/*
+ * Check if a record is in a log page.
+ */
+static int in_page(const struct cfglog_rec_s *rp, int page)
+{
+	return ((uint32_t)rp - PAGE_ADDR(page)) < CFGLOG_PAGE_SIZE;
+}
+
+/*
+ * Program flash.  FlashProgram() only does whole words, so a partial
+ * last word is padded with erased bytes.
+ */
+static int program(uint32_t addr, const void *data, int len)
+{
+	int bulk = len & ~3;
+	uint32_t tail;
+
+	if (bulk && FlashProgram((unsigned long *)data, addr, bulk))
+		return FALSE;
+	if (len & 3) {
+		tail = 0xFFFFFFFFUL;
+		memcpy(&tail, (const char *)data + bulk, len & 3);
+		if (FlashProgram((unsigned long *)&tail, addr + bulk,
+				sizeof(tail)))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+ * Scan a log page, remembering the newest valid record of each tag.
+ * Records with a bad CRC (power lost while saving) are skipped.  A torn
+ * header ends the scan: we don't know where the next record is, so
+ * the rest of the page is treated as used.
+ * Returns the offset of the free space in the page.
+ */
+static uint32_t scan_page(int page, uint32_t *maxseq)
+{
+	const struct cfglog_rec_s *rp;
+	const uint32_t *wp;
+	uint32_t off;
+	int j;
+
+	for (off = 0; off + sizeof(*rp) <= CFGLOG_PAGE_SIZE;
+	     off += REC_SIZE(rp->len)) {
+		rp = (const struct cfglog_rec_s *)(PAGE_ADDR(page) + off);
+
+		if (rp->magic != CFGLOG_MAGIC) {
+			wp = (const uint32_t *)rp;
+			for (j = 0; j < sizeof(*rp) / sizeof(*wp); j++)
+				if (wp[j] != 0xFFFFFFFFUL)
+					return CFGLOG_PAGE_SIZE;
+			return off;		/* erased, end of the log */
+		}
+		if ((rp->lencpl != (uint16_t)~rp->len) ||
+		    (off + REC_SIZE(rp->len) > CFGLOG_PAGE_SIZE))
+			return CFGLOG_PAGE_SIZE;
+
+		if ((rp->tag <= cfgTagNone) || (rp->tag >= cfgTagInvalid) ||
+		    (rec_crc(rp, rp + 1) != rp->crc))
+			continue;
+		if (!newest[rp->tag] || (rp->seq > newest[rp->tag]->seq))
+			newest[rp->tag] = rp;
+		if (rp->seq > *maxseq)
+			*maxseq = rp->seq;
+	}
+	return off;
+}
+
+/*
+ * Append a record to the current log page, which must have room.
+ * Returns the record, NULL if it didn't program correctly.
+ */
+static const struct cfglog_rec_s *append(enum cfglog_tag tag,
+	const void *data, int len)
+{
+	const struct cfglog_rec_s *rp;
+	struct cfglog_rec_s hdr;
+	uint32_t addr = PAGE_ADDR(log_page) + log_free;
+
+	hdr.magic  = CFGLOG_MAGIC;
+	hdr.tag    = tag;
+	hdr.len    = len;
+	hdr.lencpl = ~len;
+	hdr.seq    = ++log_seq;
+	hdr.crc    = rec_crc(&hdr, data);
+
+	/*
+	 * The space is used even if programming fails, so we never
+	 * program over a torn record.  The header goes first: if power is
+	 * lost before all the data is programmed, the CRC is wrong.
+	 */
+	log_free += REC_SIZE(len);
+	if (!program(addr, &hdr, sizeof(hdr)) ||
+	    !program(addr + sizeof(hdr), data, len))
+		return NULL;
+
+	rp = (const struct cfglog_rec_s *)addr;
+	if (rec_crc(rp, rp + 1) != rp->crc)
+		return NULL;
+	newest[tag] = rp;
+	return rp;
+}
+
+/*
+ * Copy the newest record of each tag (except skip) that isn't in the
+ * current page to it.  This keeps all the newest records in the
+ * current page, so the next page can always be erased.
+ */
+static int copy_newest(enum cfglog_tag skip)
+{
+	const struct cfglog_rec_s *rp;
+	int t;
+
+	for (t = cfgTagNone + 1; t < cfgTagInvalid; t++) {
+		rp = newest[t];
+		if ((t == skip) || !rp || in_page(rp, log_page))
+			continue;
+		if (log_free + REC_SIZE(rp->len) > CFGLOG_PAGE_SIZE)
+			return FALSE;
+		if (!append(t, rp + 1, rp->len))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+ * Move on to the next log page, making room for a len byte record of
+ * the tag.  The newest records of the other tags are copied over (with
+ * new sequence numbers) before the new one is written.  If power is
+ * lost in between, the previous page still has them.  The tag's own
+ * record is only kept if it isn't in the page being erased.
+ */
+static int rollover(enum cfglog_tag tag, int len)
+{
+	uint32_t need = REC_SIZE(len);
+	int page = (log_page + 1) % CFGLOG_PAGES;
+	uint32_t off;
+	int t;
+
+	for (t = cfgTagNone + 1; t < cfgTagInvalid; t++) {
+		if ((t == tag) || !newest[t])
+			continue;
+		if (in_page(newest[t], page))
+			return FALSE;		/* would lose it */
+		need += REC_SIZE(newest[t]->len);
+	}
+	if (need > CFGLOG_PAGE_SIZE)
+		return FALSE;
+
+	/*
+	 * The tag's own newest record may be in the page.  Forget it before
+	 * the erase, so that if the erase or the new record fails we don't
+	 * read it back from erased (or reprogrammed) flash.
+	 */
+	if (newest[tag] && in_page(newest[tag], page))
+		newest[tag] = NULL;
+
+	for (off = 0; off < CFGLOG_PAGE_SIZE; off += FLASH_ERASE_SIZE)
+		if (FlashErase(PAGE_ADDR(page) + off))
+			return FALSE;
+	log_page = page;
+	log_free = 0;
+
+	return copy_newest(tag);
+}
+
+/*
+ * Scan the configuration log once to find the newest record of each
+ * tag and where to write next: the page with the newest record.
+ */
+static void cfglog_init(void)
+{
+	uint32_t free[CFGLOG_PAGES];
+	uint32_t seq;
+	int j;
+
+	log_seq = 0;
+	log_page = 0;
+	for (j = 0; j < CFGLOG_PAGES; j++) {
+		seq = 0;
+		free[j] = scan_page(j, &seq);
+		if (seq > log_seq) {
+			log_seq = seq;
+			log_page = j;
+		}
+	}
+	log_free = free[log_page];
+
+	/*
+	 * Finish a rollover that was interrupted by a power loss.
+	 */
+	copy_newest(cfgTagNone);
+}
+
+/*
+ * Find the newest record of a tag.
+ */
+const void *cfglog_read(enum cfglog_tag tag, int *len)
+{
+	const struct cfglog_rec_s *rp;
+
+	if ((tag <= cfgTagNone) || (tag >= cfgTagInvalid) ||
+	    ((rp = newest[tag]) == NULL))
+		return NULL;
+	if (len)
+		*len = rp->len;
+	return rp + 1;
+}
+
+/*
+ * Append a record to the configuration log.
+ */
+int cfglog_write(enum cfglog_tag tag, const void *data, int len)
+{
+	const struct cfglog_rec_s *rp;
+
+	if ((tag <= cfgTagNone) || (tag >= cfgTagInvalid) || (len < 0) ||
+	    (REC_SIZE(len) > CFGLOG_PAGE_SIZE))
+		return FALSE;
+
+	/*
+	 * Don't wear the flash saving what is already there.
+	 */
+	rp = newest[tag];
+	if (rp && (rp->len == len) && (memcmp(rp + 1, data, len) == 0))
+		return TRUE;
+
+	FlashUsecSet(configCPU_CLOCK_HZ / 1000000);
+	if ((log_free + REC_SIZE(len) > CFGLOG_PAGE_SIZE) &&
+	    !rollover(tag, len))
+		return FALSE;
+	return append(tag, data, len) != NULL;
+}
+
+/*
+ * Check if the legacy user configuration record is valid.  The stored
+ * length may be less than the current structure (older firmware) but
+ * never more.
+ */
+static int usercfg_legacy_valid(void)
+{
+	struct usercfg_s *usercfg_p = (struct usercfg_s*)USERCFG_ADDR;
+	int32_t len = usercfg_p->length;
+
+	if ((len < (int32_t)offsetof(struct usercfg_s, notes)) ||
+	    (len > (int32_t)sizeof(struct usercfg_s)) || (len & 3))
+		return FALSE;
+	return cksum((int32_t *)USERCFG_ADDR, len) == -1;
+}
+
 /*
  * Initialize the configuration utilities.
  */
@@ -80,7 +354,6 @@ int config_init(void)
 {
 	unsigned long ulUser0,ulUser1;
 	struct permcfg_s *permcfg_p = (struct permcfg_s*)PERMCFG_ADDR;
-	struct usercfg_s *usercfg_p = (struct usercfg_s*)USERCFG_ADDR;
 
 	/*
 	 * For the LM3S8962 Evaluation Kit, the MAC address will be stored in
@@ -109,10 +382,11 @@ int config_init(void)
 		permcfg = default_permcfg;
 	}
 
-	if (usercfg_valid())
-		usercfg = *usercfg_p;
-	else
-		usercfg = default_usercfg;
+	/*
+	 * Find the newest configuration records (see kvcfg_init()).
+	 */
+	FlashUsecSet(configCPU_CLOCK_HZ / 1000000);
+	cfglog_init();
 
 	return permcfg_valid();
 }
@@ -145,11 +419,20 @@ int permcfg_valid(void)
 }
 
 /*
- * Check if the user configuration area is valid.
+ * Find a legacy user configuration record.  The checksum is always the
+ * last word of a record at USERCFG_ADDR, it isn't part of the data.
  */
-int usercfg_valid(void)
+const struct usercfg_s *usercfg_legacy(int *len)
 {
-	return cksum((int32_t *)USERCFG_ADDR, sizeof(struct usercfg_s)) == -1;
+	const struct usercfg_s *usercfg_p;
+
+	if ((usercfg_p = cfglog_read(cfgTagUsercfg, len)) != NULL)
+		return usercfg_p;
+	if (!usercfg_legacy_valid())
+		return NULL;
+	usercfg_p = (const struct usercfg_s *)USERCFG_ADDR;
+	*len = usercfg_p->length - sizeof(usercfg_p->checksum);
+	return usercfg_p;
 }
 
 /*
@@ -183,44 +466,6 @@ int permcfg_save(void)
 	return permcfg_valid();
 }
 
-/*
- * Save the user configuration structure to flash.
- */
-int usercfg_save(void)
-{
-	uint32_t *p = (uint32_t *)USERCFG_ADDR;
-	int j;
-
-	FlashUsecSet(configCPU_CLOCK_HZ / 1000000);
-
-	/*
-	 * Check if the save area is erased, erase if not.
-	 */
-	for (j= 0; j < sizeof(struct usercfg_s) / sizeof(int32_t); j++) {
-		if (*p++ != -1) {
-			FlashErase(USERCFG_ADDR);
-			break;
-		}
-	}
-
-	/*
-	 * Make sure the constants are correct.  The checksum sums to -1.
-	 */
-	usercfg.length = sizeof(struct usercfg_s);
-	usercfg.version = -1;
-	usercfg.checksum = 0;
-	usercfg.checksum =
-		-1 - cksum((int32_t *)&usercfg, sizeof(struct usercfg_s));
-
-	/*
-	 * FLASH!
-	 */
-	FlashProgram((long unsigned int *)&usercfg, USERCFG_ADDR,
-		sizeof(struct usercfg_s));
-
-	return usercfg_valid();
-}
-
 /*
  * Erase the permanent configuration flash page
  */
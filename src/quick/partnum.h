@@ -37,7 +37,53 @@
  * jeopardizes the configuration data also in that sector.
  */
 #define PERMCFG_ADDR	(FLASH_END - 0x00400)	/**< Permanent config */
-#define USERCFG_ADDR	(FLASH_END - 0x01000 - 0x00400)	/**< User config */
+#define USERCFG_ADDR	(FLASH_END - 0x01000 - 0x00400)	/**< Legacy user config */
+
+/*
+ * The user configuration is saved in a log of records below the two
+ * reserved sectors.  Each log page is a sector, erased FLASH_ERASE_SIZE
+ * at a time.  This reserves another CFGLOG_PAGES sectors at the end of
+ * flash.  The legacy record at USERCFG_ADDR is only read, if the log
+ * doesn't have a user configuration yet.  The $(PART).ld linker scripts
+ * keep the image out of these 16K (the CONFIG region): change them with
+ * CFGLOG_PAGES.
+ */
+#define FLASH_ERASE_SIZE	0x00400		/**< Smallest erase (Fury) */
+#define CFGLOG_PAGE_SIZE	0x01000		/**< Log page, one sector */
+#define CFGLOG_PAGES		2		/**< Log pages, at least 2 */
+#define CFGLOG_ADDR	(FLASH_END - 0x02000 - \
+			 (CFGLOG_PAGES * CFGLOG_PAGE_SIZE)) /**< Config log */
+
+/**
+ * Maximum key/value configuration keys (ids 1 .. KVCFG_KEYS_MAX - 1).
+ */
+#define KVCFG_KEYS_MAX		32
+
+/**
+ * Configuration log record tags: what a record holds.  Only the newest
+ * record of each tag is used.
+ */
+enum cfglog_tag {
+	cfgTagNone,		/**< Not used */
+	cfgTagUsercfg,		/**< struct usercfg_s (legacy) */
+	cfgTagKey = 16,		/**< Key/value setting, + key id (kvcfg.h) */
+	cfgTagInvalid = cfgTagKey + KVCFG_KEYS_MAX /**< MUST BE LAST */
+};
+
+/**
+ * Configuration log record header, followed by len bytes of data and
+ * erased (0xFF) padding to the next word.
+ */
+struct cfglog_rec_s {
+	uint16_t magic;		/**< CFGLOG_MAGIC */
+	uint16_t tag;		/**< enum cfglog_tag */
+	uint16_t len;		/**< Data length, bytes */
+	uint16_t lencpl;	/**< ~len, catches a torn header */
+	uint32_t seq;		/**< Sequence number, newest is largest */
+	uint32_t crc;		/**< CRC32 of the header up to here + data */
+};
+
+#define CFGLOG_MAGIC	0x4743	/**< "CG" */
 
 /**
  * struct permcfg_s - Permanent configuration data structure (write once).
@@ -52,7 +98,43 @@ struct permcfg_s {
 };
 
 /**
- * User modifiable configuration data structure.
+ * Number of A/D channels with a calibration (adcProc0..adcProcTemp).
+ */
+#define ADC_CAL_CHANNELS	5
+
+/**
+ * Maximum points in a piecewise-linear calibration table.
+ */
+#define ADC_CAL_PWL_POINTS	8
+
+/**
+ * A/D calibration types.
+ */
+enum adc_cal_type {
+	adcCalLinear,		/**< eng = c0 + c1 * counts */
+	adcCalPoly,		/**< eng = c0 + c1 * counts + c2 * counts^2 */
+	adcCalTable,		/**< piecewise-linear through (x[], y[]) */
+	adcCalInvalid		/**< Invalid flag, MUST BE LAST */
+};
+
+/**
+ * A/D channel calibration: A/D counts to engineering milliunits.
+ */
+struct adc_cal_s {
+	int32_t type;		/**< enum adc_cal_type */
+	int32_t coef[3];	/**< c0 milliunits, c1 Q16, c2 Q24 */
+	int32_t npoints;	/**< table: points used */
+	int16_t x[ADC_CAL_PWL_POINTS];	/**< table: counts, ascending */
+	int32_t y[ADC_CAL_PWL_POINTS];	/**< table: milliunits */
+};
+
+/**
+ * Legacy user modifiable configuration data structure.
+ *
+ * The user configuration is now kept as key/value settings (kvcfg.h).
+ * This is only the layout of the records saved by older firmware, which
+ * are migrated once.  Older records yet are shorter (see the length
+ * field).
  */
 struct usercfg_s {
 	int32_t length;			/**< sizeof(struct usercfg_s) */
@@ -64,14 +146,14 @@ struct usercfg_s {
 	uint8_t gateway[4];		/**< IP gateway */
 	unsigned long IPMode; 	/**< IP Address Mode: STATIC DHCP or AUTO */
 	char    notes[256];		/**< free form notes */
-	int32_t checksum;		/**< signed 32 bit sum of the data, totals -1 */
+	struct adc_cal_s adc_cal[ADC_CAL_CHANNELS]; /**< A/D calibration */
+	int32_t checksum;		/**< legacy record: sum of the data, totals -1 */
 };
 
 /*
- * Permanent and user modifiable configurations.
+ * Permanent configuration.
  */
 extern struct permcfg_s permcfg;	/**< Permanent configuration data */
-extern struct usercfg_s usercfg;	/**< User configuration data */
 
 /*
  * Utilities
@@ -107,21 +189,34 @@ int permcfg_valid(void);
 int permcfg_save(void);
 
 /**
- * Check if the user configuration area is valid.
- * \returns true => user config in flash is valid.
+ * Find a legacy user configuration record: the newest one in the
+ * configuration log, else the one at USERCFG_ADDR.
+ * \param len Filled in with the record length.
+ * \returns The record (in flash), NULL if there is no valid one.
  */
-int usercfg_valid(void);
+const struct usercfg_s *usercfg_legacy(int *len);
 
 /**
- * Save the user configuration structure to flash.
+ * Find the newest record of a tag in the configuration log.
+ * \param tag The record tag.
+ * \param len Filled in with the data length, if not NULL.
+ * \returns The data (in flash), NULL if there is none.
+ */
+const void *cfglog_read(enum cfglog_tag tag, int *len);
+
+/**
+ * Append a record to the configuration log.  Nothing is written if the
+ * newest record of the tag has the same data.  When the current page
+ * is full, the next page is erased and the newest record of every tag
+ * is copied to it first.
+ * \param tag The record tag.
+ * \param data The data, word aligned.
+ * \param len Data length, bytes.
  * \returns
- *  - TRUE => configuration saved.
- *  - FALSE => configuration not saved.
- *
- * If the user configuration contains data, this erases it first then
- * stores the new data.
+ *  - TRUE => record saved (or unchanged).
+ *  - FALSE => record not saved.
  */
-int usercfg_save(void);
+int cfglog_write(enum cfglog_tag tag, const void *data, int len);
 
 /**
  * Erase the permanent configuration structure in flash
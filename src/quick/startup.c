@@ -61,6 +61,10 @@ extern void xPortSysTickHandler(void);
 extern void vPortSVCHandler( void );
 extern void Timer0IntHandler( void );
 extern void ETH0IntHandler(void);
+extern void ADC0Seq1IntHandler(void);
+extern void GPIOEIntHandler(void);
+extern void GPIOFIntHandler(void);
+extern void LatencyProbeIntHandler(void);
 
 //*****************************************************************************
 //
@@ -103,7 +107,7 @@ void (* const g_pfnVectors[])(void) =
     IntDefaultHandler,                      // GPIO Port B
     IntDefaultHandler,                      // GPIO Port C
     IntDefaultHandler,                      // GPIO Port D
-    IntDefaultHandler,                      // GPIO Port E
+    GPIOEIntHandler,                        // GPIO Port E
     IntDefaultHandler,                      // UART0 Rx and Tx
     IntDefaultHandler,                      // UART1 Rx and Tx
     IntDefaultHandler,                      // SSI Rx and Tx
@@ -114,7 +118,11 @@ void (* const g_pfnVectors[])(void) =
     IntDefaultHandler,                      // PWM Generator 2
     IntDefaultHandler,                      // Quadrature Encoder
     IntDefaultHandler,                      // ADC Sequence 0
+#if (PART == LM3S2110)
     IntDefaultHandler,                      // ADC Sequence 1
+#else
+    ADC0Seq1IntHandler,                     // ADC Sequence 1
+#endif
     IntDefaultHandler,                      // ADC Sequence 2
     IntDefaultHandler,                      // ADC Sequence 3
     IntDefaultHandler,                      // Watchdog timer
@@ -129,12 +137,16 @@ void (* const g_pfnVectors[])(void) =
     IntDefaultHandler,                      // Analog Comparator 2
     IntDefaultHandler,                      // System Control (PLL, OSC, BO)
     IntDefaultHandler,                      // FLASH Control
-    IntDefaultHandler,                      // GPIO Port F
+    GPIOFIntHandler,                        // GPIO Port F
     IntDefaultHandler,                      // GPIO Port G
     IntDefaultHandler,                      // GPIO Port H
     IntDefaultHandler,                      // UART2 Rx and Tx
     IntDefaultHandler,                      // SSI1 Rx and Tx
+#if (PART == LM3S2110)
     IntDefaultHandler,                      // Timer 3 subtimer A
+#else
+    LatencyProbeIntHandler,                 // Timer 3 subtimer A
+#endif
     IntDefaultHandler,                      // Timer 3 subtimer B
     IntDefaultHandler,                      // I2C1 Master and Slave
     IntDefaultHandler,                      // Quadrature Encoder 1
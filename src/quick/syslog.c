@@ -3,10 +3,14 @@
  */
 
 #include <stdarg.h>
+#include <string.h>
 #include <ustdlib.h>
+#include <FreeRTOS.h>
 #include <syslog.h>
 #include <lwip/udp.h>
+#include <lwip/tcpip.h>
 #include <LWIPStack.h>
+#include <kvcfg.h>
 
 static const int rfc3164_max_packet_size = 1024;
 
@@ -18,20 +22,25 @@ static struct sysLogIniStruct {
 	u16_t remotPort;
 } sysLogIni = {0};
 
+static unsigned long queue_dropped;
+
 void syslogInit(void)
 {
-	// \todo define constants for IP address and port
-
 	IP_CONFIG currentIPConfig;
 
-	LWIPServiceTaskIPConfigGet(&lwip_netif, &currentIPConfig);
+	LWIPServiceTaskIPConfigGet(&lwip_netif[0], &currentIPConfig);
 
+	/*
+	 * The target comes from the syslog_ip and syslog_port settings.
+	 */
 	if (!sysLogIni.initialized) {
 		sysLogIni.initialized = 1;
 		sysLogIni.localIp.addr = currentIPConfig.IPAddr;
-		sysLogIni.remotIp.addr = htonl((192<<24|168<<16|8<<8|173));
+		sysLogIni.remotIp.addr = htonl(IP2LONG(kvcfg.syslog_ip[0],
+			kvcfg.syslog_ip[1], kvcfg.syslog_ip[2],
+			kvcfg.syslog_ip[3]));
 		sysLogIni.localPort = 6719;
-		sysLogIni.remotPort = 6719;
+		sysLogIni.remotPort = kvcfg.syslog_port;
 	}
 }
 
@@ -40,22 +49,103 @@ void syslog(enum facility_vals fac, enum level_vals lev, char * fmt, ...)
 	struct udp_pcb *pcb;
 	struct pbuf *p;
 	va_list argptr;
-	va_start(argptr, fmt);
 	char *eos;
+	int len;
 
-	pcb = udp_new();
+	/*
+	 * Tasks (e.g. the utility task) may log before the network is up.
+	 */
+	if (!sysLogIni.initialized)
+		return;
 
-	udp_bind(pcb, &sysLogIni.localIp, sysLogIni.localPort);
+	/*
+	 * The raw API is only safe with the core lock: we aren't
+	 * running in the tcpip thread.
+	 */
+	LOCK_TCPIP_CORE();
 
+	pcb = udp_new();
 	p = pbuf_alloc(PBUF_TRANSPORT,rfc3164_max_packet_size,PBUF_RAM);
+	if ((pcb == NULL) || (p == NULL))
+		goto out;
+
+	udp_bind(pcb, &sysLogIni.localIp, sysLogIni.localPort);
 
 	eos = p->payload;
 
 	eos += sprintf(eos,"<%d>", lev+fac*8 );
 
-	vsnprintf(eos, rfc3164_max_packet_size-(eos-(char *)p->payload), fmt, argptr);
+	va_start(argptr, fmt);
+	len = vsnprintf(eos, rfc3164_max_packet_size-(eos-(char *)p->payload), fmt, argptr);
+	va_end(argptr);
+
+	/* Only send the message, not the whole buffer. */
+	len += eos - (char *)p->payload;
+	if (len > rfc3164_max_packet_size - 1)
+		len = rfc3164_max_packet_size - 1;
+	pbuf_realloc(p, len);
+
 	udp_sendto(pcb, p, &sysLogIni.remotIp, sysLogIni.remotPort);
-	pbuf_free(p);
-	udp_remove(pcb);
+out:
+	if (p != NULL)
+		pbuf_free(p);
+	if (pcb != NULL)
+		udp_remove(pcb);
+
+	UNLOCK_TCPIP_CORE();
+}
+
+/*
+ * Send a queued message, in the tcpip thread: the raw API needs no lock.
+ */
+static void queue_send(void *ctx)
+{
+	char *msg = ctx;
+	struct udp_pcb *pcb;
+	struct pbuf *p;
+	int len = strlen(msg);
+
+	pcb = udp_new();
+	p = pbuf_alloc(PBUF_TRANSPORT, len, PBUF_RAM);
+	if ((pcb != NULL) && (p != NULL)) {
+		memcpy(p->payload, msg, len);
+		udp_bind(pcb, &sysLogIni.localIp, sysLogIni.localPort);
+		udp_sendto(pcb, p, &sysLogIni.remotIp, sysLogIni.remotPort);
+	}
+	if (p != NULL)
+		pbuf_free(p);
+	if (pcb != NULL)
+		udp_remove(pcb);
+	vPortFree(msg);
+}
+
+void syslog_queue(enum facility_vals fac, enum level_vals lev,
+		char * fmt, ...)
+{
+	va_list argptr;
+	char *msg;
+	int len;
 
+	if (!sysLogIni.initialized)
+		return;
+
+	if ((msg = pvPortMalloc(SYSLOG_QUEUE_LEN)) == NULL) {
+		queue_dropped++;
+		return;
+	}
+	len = snprintf(msg, SYSLOG_QUEUE_LEN, "<%d>", lev+fac*8);
+	va_start(argptr, fmt);
+	vsnprintf(msg + len, SYSLOG_QUEUE_LEN - len, fmt, argptr);
+	va_end(argptr);
+
+	/* Don't block: drop the message if the mail box is full. */
+	if (tcpip_callback_with_block(queue_send, msg, 0) != ERR_OK) {
+		vPortFree(msg);
+		queue_dropped++;
+	}
+}
+
+unsigned long syslog_dropped(void)
+{
+	return queue_dropped;
 }
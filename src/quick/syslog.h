@@ -52,6 +52,29 @@ enum level_vals {
 };
 
 void syslogInit(void);
+
+/*
+ * Send a message to the syslog server.  Does nothing until syslogInit()
+ * has been called.  Takes the lwIP core lock, so it must not be called
+ * from the tcpip thread (e.g. from a CGI handler).
+ */
 void syslog(enum facility_vals fac, enum level_vals lev, char * fmt, ...);
 
+/*
+ * Queue a message for the tcpip thread to send, without waiting for the
+ * lwIP core lock: for tasks that mustn't wait on the network (the
+ * utility task, which feeds the watchdog).  The message is cut to
+ * SYSLOG_QUEUE_LEN bytes, and dropped (counted by syslog_dropped()) when
+ * there is no memory or the tcpip thread's mail box is full.
+ */
+void syslog_queue(enum facility_vals fac, enum level_vals lev,
+		char * fmt, ...);
+
+#define SYSLOG_QUEUE_LEN	128
+
+/*
+ * Messages syslog_queue() dropped.
+ */
+unsigned long syslog_dropped(void);
+
 #endif
@@ -0,0 +1,394 @@
+/**
+ * \file taskstats.c
+ *
+ * Task statistics.
+
+\page taskstatspage1 Task Statistics Overview
+
+vTaskList() and vTaskGetRunTimeStats() format a whole text table with
+sprintf while the scheduler is suspended, and the caller can't bound the
+output.  This FreeRTOS version has no uxTaskGetSystemState(), so the
+kernel's trace hooks (see FreeRTOSConfig.h) hand us the addresses of
+the interesting TCB fields when a task is created:
+- the run time counter the kernel already keeps per task,
+- the priority,
+- the containers of the task's list items, which give the task state,
+- the value of the state list item, the wake time of a delayed task.
+
+The CPU usage window is closed incrementally by the utility task every
+TASK_STATS_WINDOW_MS: each task's counter is a single word, so nothing
+is locked.  A snapshot (task_stats_read()) suspends the scheduler for
+one task at a time, so the idle task can't free a deleted task's stack
+while its high water mark is measured, and masks interrupts only for
+the few loads of its counters.  The result is a fixed size binary
+record per task, which the /task_stats CGI sends as is or as JSON.
+
+When IDLE_SLEEP is set the idle task sleeps (WFI) until the next
+interrupt instead of spinning, and the time asleep is accounted for
+separately so the idle headroom can be measured: IDLE's CPU usage is
+all the idle time, the sleep figures are the part of it spent asleep.
+With TICKLESS_IDLE, tickless_idle() sleeps instead and stops the tick
+too until the first delayed task or debounce lockout is due (see
+tickless.c).  task_stats_idle_ticks() gives it the wake times from the
+slots, so the tick isn't stopped once a task couldn't get a slot.
+
+ *
+ * \addtogroup util Utilities
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <list.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <hw_types.h>
+#include <interrupt.h>
+#include <sysctl.h>
+
+#include <config.h>
+#include <taskstats.h>
+#include <timerconfig.h>
+
+/*
+ * Private information.
+ */
+
+/**
+ * What we know about a task.  The pointers are into the kernel's TCB.
+ */
+static struct task_slot_s {
+	void *tcb;			/**< TCB (task handle), NULL if free */
+	const signed char *name;	/**< Task name */
+	unsigned long *priority;	/**< Current priority */
+	unsigned long *runtime;		/**< Run time counter */
+	void **generic;			/**< State list container */
+	void **event;			/**< Event list container */
+	unsigned long *wake;		/**< State list item value */
+	unsigned long prev;		/**< runtime at the last window */
+	unsigned long window;		/**< runtime in the last window */
+} slots[TASK_STATS_MAX];
+
+/* The kernel's lists (static in tasks.c). */
+static xList *ready_lists;
+static xList *suspended_list;
+static xList *pending_list;
+static int untracked;			/* a task didn't get a slot */
+
+static unsigned long total_prev;	/**< Counter at the last window */
+static unsigned long total_window;	/**< Counts in the last window */
+
+static unsigned long long sleep_cycles;	/**< Timer 1 clocks asleep */
+static unsigned long sleep_prev;	/**< Sleep counts at the last window */
+static unsigned long sleep_window;	/**< Sleep counts in the last window */
+
+/****************************************************************************/
+
+/*
+ * Register a task.  Called from inside the kernel, in a critical
+ * section: no RTOS calls.
+ */
+void task_stats_create(void *tcb, const signed char *name,
+	unsigned long *priority, unsigned long *runtime,
+	void **generic, void **event, unsigned long *wake,
+	void *ready, void *suspended, void *pending)
+{
+	struct task_slot_s *sp;
+	int j;
+
+	ready_lists    = ready;
+	suspended_list = suspended;
+	pending_list   = pending;
+
+	for (j = 0; j < TASK_STATS_MAX; j++) {
+		sp = &slots[j];
+		if (sp->tcb != NULL)
+			continue;
+		sp->name     = name;
+		sp->priority = priority;
+		sp->runtime  = runtime;
+		sp->generic  = generic;
+		sp->event    = event;
+		sp->wake     = wake;
+		sp->prev     = *runtime;
+		sp->window   = 0;
+		sp->tcb      = tcb;
+		return;
+	}
+	/* Table full: the task just isn't reported. */
+	untracked = 1;
+}
+
+/****************************************************************************/
+
+/*
+ * Forget a task.  Called from inside the kernel.
+ */
+void task_stats_delete(void *tcb)
+{
+	int j;
+
+	for (j = 0; j < TASK_STATS_MAX; j++) {
+		if (slots[j].tcb == tcb)
+			slots[j].tcb = NULL;
+	}
+}
+
+/****************************************************************************/
+
+/*
+ * Time asleep in run time counter units.
+ */
+static unsigned long sleep_counts(void)
+{
+	unsigned long long cycles;
+
+	taskENTER_CRITICAL();
+	cycles = sleep_cycles;
+	taskEXIT_CRITICAL();
+	return (unsigned long)(cycles >> timerRUN_TIME_SHIFT);
+}
+
+/****************************************************************************/
+
+/*
+ * Close the CPU usage window.
+ */
+void task_stats_update(void)
+{
+	unsigned long now;
+	int j;
+
+	for (j = 0; j < TASK_STATS_MAX; j++) {
+		if (slots[j].tcb == NULL)
+			continue;
+		now = *slots[j].runtime;
+		slots[j].window = now - slots[j].prev;
+		slots[j].prev = now;
+	}
+	now = portGET_RUN_TIME_COUNTER_VALUE();
+	total_window = now - total_prev;
+	total_prev = now;
+
+	now = sleep_counts();
+	sleep_window = now - sleep_prev;
+	sleep_prev = now;
+}
+
+/****************************************************************************/
+
+/*
+ * Work out a task's state from the lists its items are in.
+ */
+static enum task_stats_state task_state(void *tcb, void *generic,
+	void *event)
+{
+	if (tcb == xTaskGetCurrentTaskHandle())
+		return taskRunning;
+	if ((generic >= (void *)ready_lists) &&
+	    (generic < (void *)(ready_lists + configMAX_PRIORITIES)))
+		return taskReady;
+	if (event == (void *)pending_list)
+		return taskReady;
+	if (generic == (void *)suspended_list)
+		return (event == NULL) ? taskSuspended : taskBlocked;
+	if (generic == NULL)
+		return taskDeleted;
+	return taskBlocked;	/* a delayed list */
+}
+
+/****************************************************************************/
+
+#if IDLE_SLEEP && TICKLESS_IDLE
+/*
+ * Ticks until a task is due to run: 0 if one is ready, portMAX_DELAY if
+ * all of them wait without a timeout.  Called with interrupts masked,
+ * so no list changes under us.
+ */
+portTickType task_stats_idle_ticks(void)
+{
+	struct task_slot_s *sp;
+	portTickType now = xTaskGetTickCount();
+	portTickType ticks = portMAX_DELAY;
+	long left;
+	void *generic;
+	int j;
+
+	if (untracked)
+		return 0;
+
+	for (j = 0; j < TASK_STATS_MAX; j++) {
+		sp = &slots[j];
+		if (sp->tcb == NULL)
+			continue;
+		generic = *sp->generic;
+		switch (task_state(sp->tcb, generic, *sp->event)) {
+		case taskReady:
+			return 0;
+		case taskBlocked:
+			/* Without a timeout it waits on the suspended list. */
+			if (generic == (void *)suspended_list)
+				break;
+			left = (long)(*sp->wake - now);
+			if (left <= 0)
+				return 0;
+			if ((portTickType)left < ticks)
+				ticks = left;
+			break;
+		default:		/* us, suspended or deleted */
+			break;
+		}
+	}
+	return ticks;
+}
+#endif
+
+/****************************************************************************/
+
+/*
+ * Account for time asleep.
+ */
+void task_stats_slept(unsigned long cycles)
+{
+	sleep_cycles += cycles;
+}
+
+/****************************************************************************/
+
+/*
+ * Sleep until the next interrupt.  Interrupts are masked so the one that
+ * wakes us isn't serviced until the time asleep has been read; a pending
+ * interrupt still ends the WFI.
+ */
+void task_stats_idle(void)
+{
+#if IDLE_SLEEP
+	unsigned long before;
+	unsigned long after;
+
+	IntMasterDisable();
+	before = timerTIMER_1_COUNT_VALUE;
+	SysCtlSleep();
+	after = timerTIMER_1_COUNT_VALUE;
+	sleep_cycles += before - after;		/* counts down */
+	IntMasterEnable();
+#endif
+}
+
+/****************************************************************************/
+
+/*
+ * Scale a part of a run time count to hundredths of a percent.
+ */
+static uint16_t cpu_pct(unsigned long part, unsigned long whole)
+{
+	if (whole == 0)
+		return 0;
+	if (part > whole)
+		part = whole;
+	return ((uint64_t)part * 10000) / whole;
+}
+
+/****************************************************************************/
+
+/*
+ * Fill in the record of a task slot.
+ */
+static int fill_rec(struct task_slot_s *sp, struct task_stats_rec_s *rec,
+	unsigned long total, unsigned long total_win)
+{
+	unsigned long window = 0;
+	void *generic = NULL;
+	void *event = NULL;
+	void *tcb;
+
+	memset(rec, 0, sizeof(*rec));
+	/*
+	 * With the scheduler suspended the idle task can't free a deleted
+	 * task's TCB and stack while the name and stack are read, the
+	 * critical section gives a consistent view of the counters.
+	 */
+	vTaskSuspendAll();
+	taskENTER_CRITICAL();
+	tcb = sp->tcb;
+	if (tcb != NULL) {
+		generic       = *sp->generic;
+		event         = *sp->event;
+		rec->priority = *sp->priority;
+		rec->runtime  = *sp->runtime;
+		window        = sp->window;
+	}
+	taskEXIT_CRITICAL();
+	if (tcb != NULL) {
+		strncpy(rec->name, (const char *)sp->name, sizeof(rec->name));
+		rec->state      = task_state(tcb, generic, event);
+		rec->stack_free = uxTaskGetStackHighWaterMark(tcb);
+	}
+	xTaskResumeAll();
+	if (tcb == NULL)
+		return -1;
+
+	rec->cpu_window = cpu_pct(window, total_win);
+	rec->cpu_total  = cpu_pct(rec->runtime, total);
+	return 0;
+}
+
+/****************************************************************************/
+
+/*
+ * Get the statistics of one task.
+ */
+int task_stats_get(int slot, struct task_stats_rec_s *rec)
+{
+	if ((slot < 0) || (slot >= TASK_STATS_MAX))
+		return -1;
+	return fill_rec(&slots[slot], rec, portGET_RUN_TIME_COUNTER_VALUE(),
+		total_window);
+}
+
+/****************************************************************************/
+
+/*
+ * Get the statistics of all tasks as a binary blob.
+ */
+int task_stats_read(char *buf, int size)
+{
+	struct task_stats_hdr_s hdr;
+	struct task_stats_rec_s rec;
+	char *bp;
+	int j;
+
+	if (size < (int)sizeof(hdr))
+		return -1;
+
+	hdr.magic   = TASK_STATS_MAGIC;
+	hdr.version = TASK_STATS_VERSION;
+	hdr.ntasks  = 0;
+	hdr.reclen  = sizeof(rec);
+	hdr.ticks   = xTaskGetTickCount();
+	hdr.window  = total_window;
+	hdr.total   = portGET_RUN_TIME_COUNTER_VALUE();
+	hdr.sleep_window = sleep_window;
+	hdr.sleep_total  = sleep_counts();
+
+	bp = buf + sizeof(hdr);
+	for (j = 0; j < TASK_STATS_MAX; j++) {
+		if ((bp + sizeof(rec)) > (buf + size))
+			break;
+		if (fill_rec(&slots[j], &rec, hdr.total, hdr.window) != 0)
+			continue;
+		memcpy(bp, &rec, sizeof(rec));
+		bp += sizeof(rec);
+		hdr.ntasks++;
+	}
+
+	memcpy(buf, &hdr, sizeof(hdr));
+	return bp - buf;
+}
+/** \} */
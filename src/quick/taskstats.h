@@ -0,0 +1,139 @@
+/**
+ * \file taskstats.h
+ *
+ * Task statistics definitions and declarations.
+ *
+ * \addtogroup util Utilities
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#ifndef TASKSTATS_H_
+#define TASKSTATS_H_
+
+#include <stdint.h>
+
+/**
+ * Magic number at the start of the binary task statistics blob ("TSKS").
+ */
+#define TASK_STATS_MAGIC	0x534b5354UL
+
+/**
+ * Binary task statistics blob format version.
+ */
+#define TASK_STATS_VERSION	2
+
+/**
+ * Length of a task name in the blob (configMAX_TASK_NAME_LEN).
+ */
+#define TASK_STATS_NAME_LEN	12
+
+/**
+ * Task states, as the snapshot saw them.
+ */
+enum task_stats_state {
+	taskRunning,		/**< The task taking the snapshot */
+	taskReady,		/**< Ready or preempted */
+	taskBlocked,		/**< Delayed or waiting on a queue/semaphore */
+	taskSuspended,		/**< vTaskSuspend()ed */
+	taskDeleted		/**< Deleted, or not in any list */
+};
+
+/**
+ * Header of the binary task statistics blob, followed by ntasks
+ * struct task_stats_rec_s.  Little endian, no padding.
+ */
+struct task_stats_hdr_s {
+	uint32_t magic;		/**< TASK_STATS_MAGIC */
+	uint16_t version;	/**< TASK_STATS_VERSION */
+	uint8_t  ntasks;	/**< Records that follow */
+	uint8_t  reclen;	/**< sizeof(struct task_stats_rec_s) */
+	uint32_t ticks;		/**< RTOS tick count */
+	uint32_t window;	/**< Run time counts in the last window */
+	uint32_t total;		/**< Run time counter */
+	uint32_t sleep_window;	/**< Counts asleep in the last window */
+	uint32_t sleep_total;	/**< Counts asleep since the counter started */
+};
+
+/**
+ * Statistics of one task.  CPU usage is in hundredths of a percent.
+ */
+struct task_stats_rec_s {
+	char     name[TASK_STATS_NAME_LEN]; /**< Task name, NUL padded */
+	uint8_t  priority;	/**< Current priority */
+	uint8_t  state;		/**< enum task_stats_state */
+	uint16_t stack_free;	/**< Stack high water mark, in words */
+	uint32_t runtime;	/**< Run time counter of the task */
+	uint16_t cpu_window;	/**< CPU usage in the last window */
+	uint16_t cpu_total;	/**< CPU usage since the counter started */
+};
+
+/**
+ * Register a task.  Called by traceTASK_CREATE() (FreeRTOSConfig.h)
+ * inside the kernel with the addresses of the fields of the new TCB
+ * and of the kernel lists that we need for the task state.
+ */
+void task_stats_create(void *tcb, const signed char *name,
+	unsigned long *priority, unsigned long *runtime,
+	void **generic, void **event, unsigned long *wake,
+	void *ready_lists, void *suspended_list, void *pending_list);
+
+/**
+ * Forget a task.  Called by traceTASK_DELETE().
+ */
+void task_stats_delete(void *tcb);
+
+/**
+ * Close the CPU usage window.  Called by the utility task every
+ * TASK_STATS_WINDOW_MS.
+ */
+void task_stats_update(void);
+
+/**
+ * Sleep until the next interrupt and account for the time asleep.  Called
+ * by the idle task (vApplicationIdleHook()) when IDLE_SLEEP is set without
+ * TICKLESS_IDLE; tickless_idle() takes its place with it.
+ */
+void task_stats_idle(void);
+
+/**
+ * Get the ticks until a task is due to run, for tickless_idle().  Called
+ * with interrupts masked.
+ *
+ * \returns 0 if a task is ready (or one couldn't get a slot, so its wake
+ * time isn't known), portMAX_DELAY if all of them wait without a timeout.
+ */
+portTickType task_stats_idle_ticks(void);
+
+/**
+ * Account for time the idle task spent asleep.
+ *
+ * \param cycles Timer 1 clocks asleep.
+ */
+void task_stats_slept(unsigned long cycles);
+
+/**
+ * Get the statistics of one task.
+ *
+ * \param slot Task slot, 0 .. TASK_STATS_MAX - 1.
+ * \param rec Filled in with the statistics.
+ * \returns 0 on success, -1 if there is no task in the slot.
+ */
+int task_stats_get(int slot, struct task_stats_rec_s *rec);
+
+/**
+ * Get the statistics of all tasks as a binary blob: a struct
+ * task_stats_hdr_s followed by as many struct task_stats_rec_s as fit.
+ *
+ * \param buf Where to put the blob (needn't be aligned).
+ * \param size Size of buf in bytes.
+ * \returns The length of the blob, -1 if buf is too small.
+ */
+int task_stats_read(char *buf, int size);
+
+#endif /* TASKSTATS_H_ */
+/** \} */
@@ -0,0 +1,214 @@
+/**
+ * \file tickless.c
+ *
+ * Tickless idle: stop the RTOS tick while the idle task sleeps.
+
+\page ticklesspage1 Tickless Idle Overview
+
+With the idle task sleeping (IDLE_SLEEP), the 1 kHz SysTick interrupt
+still wakes the CPU every millisecond just to count.  When the idle task
+knows that no task is due for a while (task_stats_idle_ticks() works
+that out from the wake times of the delayed tasks, tickless_idle() also
+stops at the first debounce lockout), tickless_sleep() stops the
+SysTick, reloads it for the whole idle time and sleeps:
+
+- The reload is what was left of the current tick period plus expected
+  - 1 whole periods, so the sleep ends exactly on a tick boundary.  The
+  SysTick is 24 bits, which limits a sleep to MAX_SUPPRESS ticks.
+- If the reload ran out, the tick interrupt is pending and counts the
+  last tick itself; the SysTick is restarted for what's left of that
+  period (the counter kept counting from the reload since).  It can run
+  out between the read of COUNTFLAG and the stop, so the flag is read
+  again once the counter is stopped.
+- If another interrupt woke us first, the whole periods that went by
+  are worked out from the counter and the SysTick is restarted for the
+  rest of the current one.
+
+This FreeRTOS version has no vTaskStepTick(), so tickless_step() makes
+up the tick count by calling vTaskIncrementTick() once per whole period
+with the scheduler suspended.  The kernel counts those as missed ticks
+and processes them in xTaskResumeAll(), which wakes the delayed tasks
+that came due exactly as the ticks would have.  The tick hook runs for
+each of them too, so the debounce lockouts (dioevent.c) keep counting;
+tickless_stepping() lets it skip the tick jitter measurement.
+
+A few CPU clocks go by between stopping and restarting the SysTick, so
+the tick count slowly falls behind the Timer 1 clock while sleeping:
+about 20 clocks per sleep.
+
+ *
+ * \addtogroup util Utilities
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <hw_types.h>
+#include <hw_nvic.h>
+#include <interrupt.h>
+#include <sysctl.h>
+
+#include <config.h>
+#include <io.h>
+#include <dioevent.h>
+#include <taskstats.h>
+#include <tickless.h>
+#include <timerconfig.h>
+
+#define TICK_CLOCKS	(configCPU_CLOCK_HZ / configTICK_RATE_HZ)
+#define MAX_SUPPRESS	(NVIC_ST_RELOAD_M / TICK_CLOCKS)
+
+#define ST_STOPPED	(NVIC_ST_CTRL_CLK_SRC | NVIC_ST_CTRL_INTEN)
+#define ST_RUNNING	(ST_STOPPED | NVIC_ST_CTRL_ENABLE)
+
+/*
+ * Private information.
+ */
+static volatile int stepping;	/* from a suppressed sleep to its step */
+
+/****************************************************************************/
+
+#if IDLE_SLEEP && TICKLESS_IDLE
+/*
+ * Restart the SysTick for one period of clocks, then regular ticks.
+ */
+static void restart(unsigned long clocks)
+{
+	HWREG(NVIC_ST_RELOAD) = clocks - 1;
+	HWREG(NVIC_ST_CURRENT) = 0;
+	HWREG(NVIC_ST_CTRL) = ST_RUNNING;
+	/* The new reload is only safe once the counter has loaded. */
+	while (HWREG(NVIC_ST_CURRENT) == 0)
+		;
+	HWREG(NVIC_ST_RELOAD) = TICK_CLOCKS - 1;
+}
+
+/****************************************************************************/
+
+/*
+ * Sleep with the tick suppressed for up to expected ticks.  Called with
+ * interrupts masked.  Returns the whole tick periods that went by without
+ * a tick interrupt, for tickless_step() once interrupts are back on.
+ */
+static unsigned long tickless_sleep(portTickType expected)
+{
+	unsigned long reload;
+	unsigned long current;
+	unsigned long ctrl;
+	unsigned long done;
+	unsigned long ticks;
+
+	/*
+	 * Not worth it, or a tick or a context switch is already due.
+	 */
+	if ((expected < 2) || (HWREG(NVIC_INT_CTRL) &
+			(NVIC_INT_CTRL_PEND_SV | NVIC_INT_CTRL_PENDSTSET))) {
+		SysCtlSleep();
+		return 0;
+	}
+	if (expected > MAX_SUPPRESS)
+		expected = MAX_SUPPRESS;
+
+	HWREG(NVIC_ST_CTRL) = ST_STOPPED;
+	reload = HWREG(NVIC_ST_CURRENT) + TICK_CLOCKS * (expected - 1);
+	HWREG(NVIC_ST_RELOAD) = reload;
+	HWREG(NVIC_ST_CURRENT) = 0;
+	HWREG(NVIC_ST_CTRL) = ST_RUNNING;
+	stepping = 1;
+
+	SysCtlSleep();
+
+	ctrl = HWREG(NVIC_ST_CTRL);		/* reading clears COUNT */
+	HWREG(NVIC_ST_CTRL) = ST_STOPPED;
+	current = HWREG(NVIC_ST_CURRENT);
+	/* It may have run out after the read, before the stop. */
+	ctrl |= HWREG(NVIC_ST_CTRL);
+
+	if (ctrl & NVIC_ST_CTRL_COUNT) {
+		/*
+		 * The tick ended the sleep, its (pending) interrupt counts
+		 * the last period.  The counter reloaded and kept going.
+		 */
+		done = reload - current;
+		restart((done < TICK_CLOCKS - 1) ? (TICK_CLOCKS - done) :
+			TICK_CLOCKS);
+		ticks = expected - 1;
+	} else {
+		/*
+		 * Something else woke us: count the whole periods, the
+		 * next tick ends the current one.
+		 */
+		done = TICK_CLOCKS * expected - current;
+		ticks = done / TICK_CLOCKS;
+		restart((ticks + 1) * TICK_CLOCKS - done);
+	}
+	return ticks;
+}
+
+/****************************************************************************/
+
+/*
+ * Make up the suppressed ticks and wake the tasks that came due.  Called
+ * with interrupts enabled.
+ */
+static void tickless_step(unsigned long ticks)
+{
+	vTaskSuspendAll();
+	while (ticks--) {
+		/* The tick interrupt mustn't count a missed tick with us. */
+		taskENTER_CRITICAL();
+		vTaskIncrementTick();
+		taskEXIT_CRITICAL();
+	}
+	xTaskResumeAll();
+	stepping = 0;
+}
+
+/****************************************************************************/
+
+/*
+ * Sleep until the next interrupt with the tick suppressed.  Interrupts are
+ * masked so the one that wakes us isn't serviced until the tick has been
+ * restarted and the time asleep read; a pending interrupt still ends the
+ * WFI.
+ */
+void tickless_idle(void)
+{
+	portTickType expected;
+	portTickType lockout;
+	unsigned long before;
+	unsigned long after;
+	unsigned long ticks;
+
+	IntMasterDisable();
+	expected = task_stats_idle_ticks();
+	lockout = dio_event_ticks_left();
+	if (lockout < expected)
+		expected = lockout;
+	before = timerTIMER_1_COUNT_VALUE;
+	ticks = tickless_sleep(expected);
+	after = timerTIMER_1_COUNT_VALUE;
+	task_stats_slept(before - after);	/* counts down */
+	IntMasterEnable();
+
+	if (ticks)
+		tickless_step(ticks);
+}
+#endif
+
+/****************************************************************************/
+
+/*
+ * The ticks aren't real tick periods.
+ */
+int tickless_stepping(void)
+{
+	return stepping;
+}
+/** \} */
@@ -0,0 +1,38 @@
+/**
+ * \file tickless.h
+ *
+ * Tickless idle definitions and declarations.
+ *
+ * \addtogroup util Utilities
+ * \{
+ *//*
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ *
+ *       1         2         3         4         5         6         7
+ *3456789012345678901234567890123456789012345678901234567890123456789012345678
+ */
+
+#ifndef TICKLESS_H_
+#define TICKLESS_H_
+
+#include <FreeRTOS.h>
+
+/**
+ * Sleep until the next interrupt with the tick suppressed until the first
+ * delayed task or debounce lockout is due, account for the time asleep
+ * (task_stats_slept()) and make up the ticks that were suppressed.
+ * Called by the idle task (vApplicationIdleHook()) when TICKLESS_IDLE is
+ * set.
+ */
+void tickless_idle(void);
+
+/**
+ * Tell the tick hook that the ticks are being replayed (or the first
+ * one after a sleep is due), so they're not real tick periods.
+ *
+ * \returns Non-zero while that is so.
+ */
+int tickless_stepping(void);
+
+#endif /* TICKLESS_H_ */
+/** \} */
@@ -18,6 +18,10 @@ the jitter. */
 zero. */
 #define timerEXPECTED_DIFFERENCE_VALUE	( configCPU_CLOCK_HZ / timerINTERRUPT_FREQUENCY )
 
+/* The run time stats counter is timer 1 clocks shifted down by this much:
+5.12us resolution (50MHz), wrapping the 32 bit counter every 6.1 hours. */
+#define timerRUN_TIME_SHIFT				( 8 )
+
 /* The highest available interrupt priority. */
 #define timerHIGHEST_PRIORITY			( 0 )
 
@@ -27,4 +31,7 @@ zero. */
 
 #define GET_TIME_USEC() (timerTIMER_1_COUNT_VALUE / (configCPU_CLOCK_HZ/1000000) )
 
+/* Timer 1 clocks since vSetupHighFrequencyTimer(), extended to 64 bits. */
+extern unsigned long long ullGetRunTimeCycles( void );
+
 #endif /* TIMERCONFIG_H_ */
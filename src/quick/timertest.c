@@ -51,7 +51,17 @@
     licensing and training services.
 */
 
-/* High speed timer test as described in main.c. */
+/* Run time statistics time base, and the optional high speed timer (jitter)
+test as described in main.c.
+
+Timer 1 free-runs down from 0xffffffff at the CPU clock.  The run time stats
+counter is its elapsed count, extended to 64 bits in software and scaled down
+by timerRUN_TIME_SHIFT, so no interrupt is needed to keep it.  The extension
+only has to be read more often than the timer wraps (2^32 clocks, 86 seconds
+at 50MHz), which the scheduler does on every context switch.
+
+The 20KHz Timer 0 interrupt used to count run time ticks is now only the
+jitter test, built with make TIMER_JITTER_TEST="-D TIMER_JITTER_TEST=1". */
 
 /* Scheduler includes. */
 #include "FreeRTOS.h"
@@ -65,6 +75,7 @@
 #include "timer.h"
 
 #include "timerconfig.h"
+#include "quickstart-opts.h"
 
 /*-----------------------------------------------------------*/
 
@@ -74,29 +85,37 @@ void Timer0IntHandler( void );
 /* Stores the value of the maximum recorded jitter between interrupts. */
 volatile unsigned portLONG ulMaxJitter = 0UL;
 
-/* Counts the total number of times that the high frequency timer has 'ticked'.
-This value is used by the run time stats function to work out what percentage
-of CPU time each task is taking. */
-volatile unsigned portLONG ulHighFrequencyTimerTicks = 0UL;
+/* Timer 1 clocks elapsed since vSetupHighFrequencyTimer(), and the timer 1
+count when they were last brought up to date. */
+static unsigned long long ullRunTimeCycles = 0ULL;
+static unsigned portLONG ulLastTimer1Count = 0UL;
 /*-----------------------------------------------------------*/
 
 void vSetupHighFrequencyTimer( void )
+{
+	/* Timer 1 is the run time stats time base and is used to measure the
+	jitter. */
+    SysCtlPeripheralEnable( SYSCTL_PERIPH_TIMER1 );
+    TimerConfigure( TIMER1_BASE, TIMER_CFG_32_BIT_PER );
+
+	/* Just used to measure time.  It's started first thing in main() so
+	the boot phases can be timed, see boottime.c. */
+    TimerLoadSet(TIMER1_BASE, TIMER_A, timerMAX_32BIT_VALUE );
+	ulLastTimer1Count = timerMAX_32BIT_VALUE;
+	ullRunTimeCycles = 0ULL;
+    TimerEnable( TIMER1_BASE, TIMER_A );
+
+#if TIMER_JITTER_TEST
 {
 unsigned long ulFrequency;
 
-	/* Timer zero is used to generate the interrupts, and timer 1 is used
-	to measure the jitter. */
+	/* Timer zero is used to generate the interrupts. */
 	SysCtlPeripheralEnable( SYSCTL_PERIPH_TIMER0 );
-    SysCtlPeripheralEnable( SYSCTL_PERIPH_TIMER1 );
     TimerConfigure( TIMER0_BASE, TIMER_CFG_32_BIT_PER );
-    TimerConfigure( TIMER1_BASE, TIMER_CFG_32_BIT_PER );
 
 	/* Set the timer interrupt to be above the kernel - highest. */
 	IntPrioritySet( INT_TIMER0A, timerHIGHEST_PRIORITY );
 
-	/* Just used to measure time. */
-    TimerLoadSet(TIMER1_BASE, TIMER_A, timerMAX_32BIT_VALUE );
-
 	/* Ensure interrupts do not start until the scheduler is running. */
 	portDISABLE_INTERRUPTS();
 
@@ -105,10 +124,49 @@ unsigned long ulFrequency;
     TimerLoadSet( TIMER0_BASE, TIMER_A, ulFrequency );
     IntEnable( INT_TIMER0A );
     TimerIntEnable( TIMER0_BASE, TIMER_TIMA_TIMEOUT );
-
-	/* Enable both timers. */
     TimerEnable( TIMER0_BASE, TIMER_A );
-    TimerEnable( TIMER1_BASE, TIMER_A );
+}
+#endif
+}
+/*-----------------------------------------------------------*/
+
+void vConfigureRunTimeCounter( void )
+{
+	/* Timer 1 has been running since vSetupHighFrequencyTimer(), keep
+	counting from there so the run time and the boot marks share a time
+	base.  Just bring the count up to date. */
+	( void ) ullGetRunTimeCycles();
+}
+/*-----------------------------------------------------------*/
+
+unsigned long long ullGetRunTimeCycles( void )
+{
+unsigned portLONG ulCurrentCount;
+unsigned long long ullCycles;
+tBoolean xWasDisabled;
+
+	/* Called from tasks and from inside the context switch, so save and
+	restore the interrupt mask rather than use a critical section. */
+	xWasDisabled = IntMasterDisable();
+
+	/* Timer 1 counts down; unsigned arithmetic takes care of the wrap. */
+	ulCurrentCount = timerTIMER_1_COUNT_VALUE;
+	ullRunTimeCycles += ( unsigned portLONG ) ( ulLastTimer1Count - ulCurrentCount );
+	ulLastTimer1Count = ulCurrentCount;
+	ullCycles = ullRunTimeCycles;
+
+	if( !xWasDisabled )
+	{
+		IntMasterEnable();
+	}
+
+	return ullCycles;
+}
+/*-----------------------------------------------------------*/
+
+unsigned long ulGetRunTimeCounterValue( void )
+{
+	return ( unsigned long ) ( ullGetRunTimeCycles() >> timerRUN_TIME_SHIFT );
 }
 /*-----------------------------------------------------------*/
 
@@ -138,9 +196,4 @@ static unsigned portLONG ulMaxDifference = 0, ulLastCount = 0;
 	}
 
 	ulLastCount = ulCurrentCount;
-
-	/* Keep a count of the total number of 20KHz ticks.  This is used by the
-	run time stats functionality to calculate how much CPU time is used by
-	each task. */
-	ulHighFrequencyTimerTicks++;
 }
@@ -114,6 +114,21 @@ void wdt_isr(void)
   1c:   dc03            bgt.n   26 <wdt_isr+0x26>
 \endcode
 
+\section supervisor Task Budgets
+
+The watchdog only catches a task that has already stopped.  To get
+early warning of overload, the utility task also checks every task
+against a CPU and stack budget (task_budget[] in utilwdtcfg.c) each
+time it closes the task statistics window (TASK_STATS_WINDOW_MS):
+- CPU: the task's share of the last window exceeds cpu_max.
+- Stack: the task's stack high water mark drops below stack_min.
+- Watchdog: a monitored task's wdt_checkin count passed half its limit.
+
+A violation is reported (serial log and syslog) when it starts and when
+it clears, and counted; /supervisor reports the current state.  The
+syslog messages are queued to the tcpip thread (syslog_queue()), so a
+busy network never holds up the task that feeds the watchdog.
+
  * \addtogroup util Utility functions
  * \{
  *//*
@@ -125,6 +140,8 @@ void wdt_isr(void)
 
 #include <string.h>
 #include <stdint.h>
+#include <stdarg.h>
+#include <ustdlib.h>
 
 #include <FreeRTOS.h>
 #include <task.h>
@@ -141,6 +158,9 @@ void wdt_isr(void)
 #include <logger.h>
 
 #include <utilwdtcfg.h>
+#include <taskstats.h>
+#include <boottime.h>
+#include <syslog.h>
 #include "debugSupport.h"
 
 #define WDT_RESET_MS	100	/* Watchdog resets us after this */
@@ -169,6 +189,22 @@ int wdt_checkin[wdt_last] = {0};
 
 #define MSEC2POLL(msec)	((msec) / POLL_DELAY)
 
+/**
+ * Budget supervisor state, one per task statistics slot.
+ */
+static struct task_super_s super[TASK_STATS_MAX];
+
+/** Monitored tasks that are more than half way to a WDT reset. */
+static unsigned char wdt_late[wdt_last];
+
+/** The task stack, unless it comes from the heap. */
+#if STATIC_TASK_STACKS
+static portSTACK_TYPE util_stack[UTIL_STACK_SIZE];
+#define UTIL_STACK	util_stack
+#else
+#define UTIL_STACK	NULL
+#endif
+
 /****************************************************************************/
 
 /**
@@ -213,6 +249,123 @@ void wdt_isr(void)
 
 /****************************************************************************/
 
+/*
+ * Report a budget violation on the serial log and the syslog.  The
+ * syslog message is queued: waiting for the lwIP core lock while the
+ * tcpip thread is busy would starve the watchdog.
+ */
+static void report(enum level_vals lev, const char *fmt, ...)
+{
+	char buf[80];
+	va_list ap;
+
+	va_start(ap, fmt);
+	vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+
+	lprintf("%s\r\n", buf);
+#if (PART != LM3S2110)
+	syslog_queue(facility_local0, lev, "%s", buf);
+#endif
+}
+
+/****************************************************************************/
+
+/*
+ * Find the budget of a task.
+ */
+static const struct task_budget_s *find_budget(const char *name)
+{
+	const struct task_budget_s *bp;
+
+	for (bp = task_budget; bp->name != NULL; bp++) {
+		if (strncmp(bp->name, name, TASK_STATS_NAME_LEN) == 0)
+			break;
+	}
+	return bp;
+}
+
+/****************************************************************************/
+
+/*
+ * Check every task against its budget, report changes.
+ */
+static void supervise(void)
+{
+	struct task_stats_rec_s rec;
+	const struct task_budget_s *bp;
+	struct task_super_s *sp;
+	unsigned char over;
+	int j;
+
+	for (j = 0; j < TASK_STATS_MAX; j++) {
+		sp = &super[j];
+		if (task_stats_get(j, &rec) != 0) {
+			sp->valid = 0;
+			continue;
+		}
+		if (!sp->valid || strncmp(sp->name, rec.name,
+		    TASK_STATS_NAME_LEN)) {
+			memset(sp, 0, sizeof(*sp));
+			memcpy(sp->name, rec.name, TASK_STATS_NAME_LEN);
+			sp->valid = 1;
+		}
+		bp = find_budget(sp->name);
+		sp->cpu       = rec.cpu_window;
+		sp->cpu_max   = bp->cpu_max;
+		sp->stack     = rec.stack_free;
+		sp->stack_min = bp->stack_min;
+
+		over = 0;
+		if (sp->cpu > sp->cpu_max)
+			over |= SUPER_OVER_CPU;
+		if (sp->stack < sp->stack_min)
+			over |= SUPER_OVER_STACK;
+
+		if ((over & SUPER_OVER_CPU) && !(sp->over & SUPER_OVER_CPU)) {
+			sp->cpu_viol++;
+			report(level_warning, "task %s CPU %d.%02d%% > %d.%02d%%",
+				sp->name, sp->cpu / 100, sp->cpu % 100,
+				sp->cpu_max / 100, sp->cpu_max % 100);
+		}
+		if ((over & SUPER_OVER_STACK) &&
+		    !(sp->over & SUPER_OVER_STACK)) {
+			sp->stack_viol++;
+			report(level_warning, "task %s stack %d < %d words",
+				sp->name, sp->stack, sp->stack_min);
+		}
+		if (!over && sp->over)
+			report(level_notice, "task %s within budget", sp->name);
+		sp->over = over;
+	}
+
+	for (j = 0; j < wdt_last; j++) {
+		if (wdt_checkin[j] > (wdt_limit[j] / 2)) {
+			if (!wdt_late[j])
+				report(level_crit, "task %s late for the watchdog",
+					wdt_name[j]);
+			wdt_late[j] = 1;
+		} else {
+			wdt_late[j] = 0;
+		}
+	}
+}
+
+/****************************************************************************/
+
+/*
+ * Get the budget supervisor state of a task.
+ */
+int util_super_get(int slot, struct task_super_s *sp)
+{
+	if ((slot < 0) || (slot >= TASK_STATS_MAX) || !super[slot].valid)
+		return -1;
+	*sp = super[slot];
+	return 0;
+}
+
+/****************************************************************************/
+
 /**
  * Utility task.
  *
@@ -226,6 +379,7 @@ void wdt_isr(void)
 static void util_task(void *params)
 {
 	portTickType last_wake_time;
+	int window = 0;
 
 	/*
 	 * Registers and enables the watchdog interrupt.
@@ -243,12 +397,18 @@ static void util_task(void *params)
 	 */
 	WatchdogResetEnable(WATCHDOG0_BASE);
 	WatchdogEnable(WATCHDOG0_BASE);
+	boot_mark("wdt");
 
 	/* Start our periodic time starting in 3. 2. 1. NOW! */
 	last_wake_time = xTaskGetTickCount();
 
 	while(1) {	/* forever loop */
 		wdt_checkin[wdt_util] = 0;
+		if (++window >= MSEC2POLL(TASK_STATS_WINDOW_MS)) {
+			task_stats_update();
+			supervise();
+			window = 0;
+		}
 		vTaskDelayUntil(&last_wake_time, POLL_DELAY);
 	}
 }
@@ -262,12 +422,14 @@ int util_init(void)
 {
 	portBASE_TYPE ret;
 
-	ret = xTaskCreate(util_task,
+	ret = xTaskGenericCreate(util_task,
 		(signed portCHAR *)"util",
-		DEFAULT_STACK_SIZE,
+		UTIL_STACK_SIZE,
 		NULL,
 		UTIL_TASK_PRIORITY,
-		&util_task_handle);
+		&util_task_handle,
+		UTIL_STACK,
+		NULL);
 	if (ret != pdPASS)
 		DPRINTF(0,"Creation of utilities task failed: %d\r\n", ret);
 
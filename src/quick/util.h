@@ -17,6 +17,8 @@
 #ifndef UTIL_H_
 #define UTIL_H_
 
+#include <taskstats.h>
+
 /*
  * Public information.
  */
@@ -32,5 +34,35 @@ extern int wdt_checkin[];
 
 extern int util_init(void);
 
+/**
+ * supervisor.over flags.
+ */
+#define SUPER_OVER_CPU		0x01	/**< Over the CPU budget */
+#define SUPER_OVER_STACK	0x02	/**< Under the stack minimum */
+
+/**
+ * Budget supervisor state of a task (see util.c).
+ */
+struct task_super_s {
+	char name[TASK_STATS_NAME_LEN + 1]; /**< Task name */
+	unsigned char valid;		/**< Slot holds a task */
+	unsigned char over;		/**< SUPER_OVER_* now */
+	unsigned short cpu;		/**< CPU in the last window, 0.01% */
+	unsigned short cpu_max;		/**< Budget, 0.01% */
+	unsigned short stack;		/**< Free stack, words */
+	unsigned short stack_min;	/**< Budget, words */
+	unsigned short cpu_viol;	/**< CPU budget violations */
+	unsigned short stack_viol;	/**< Stack budget violations */
+};
+
+/**
+ * Get the budget supervisor state of a task.
+ *
+ * \param slot Task slot, 0 .. TASK_STATS_MAX - 1.
+ * \param sp Filled in with the state.
+ * \returns 0 on success, -1 if there is no task in the slot.
+ */
+int util_super_get(int slot, struct task_super_s *sp);
+
 #endif /* UTIL_H_ */
 /** \} */
@@ -0,0 +1,26 @@
+/*
+ * check.h - Checks for the host tests.
+ */
+#ifndef CHECK_H_
+#define CHECK_H_
+
+#include <stdio.h>
+
+extern int check_failed;
+
+/* Report a failed check, the test carries on and fails at the end. */
+#define CHECK(cond)							\
+	do {								\
+		if (!(cond)) {						\
+			fprintf(stderr, "%s:%d: check failed: %s\n",	\
+				__FILE__, __LINE__, #cond);		\
+			check_failed++;					\
+		}							\
+	} while (0)
+
+/* The exit status of the test. */
+#define CHECK_DONE(name)						\
+	(printf("%s: %s\n", (name), check_failed ? "FAIL" : "ok"),	\
+	 check_failed ? 1 : 0)
+
+#endif /* CHECK_H_ */
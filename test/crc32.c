@@ -0,0 +1,140 @@
+/*
+ * crc32.c - Host test of crc32.c: the slice by 4 tables against a bitwise
+ * CRC, and how long the table walk takes.
+ *
+ *	crc32 [mbytes]
+ *
+ * - "123456789" has the check value of the IEEE CRC, 0xcbf43926;
+ * - every start alignment and every length up to MAX_LEN, in one call
+ *   and split in two, agrees with the bitwise CRC;
+ * - then mbytes (default 16) of data is timed through both.
+ *
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ */
+
+#include <stdlib.h>
+#include <stdarg.h>
+#include <time.h>
+
+#include "../src/quick/crc32.c"
+
+#include "check.h"
+
+int check_failed;
+
+#define MAX_LEN		300		/* longest length checked */
+#define BLOCK		4096		/* bytes per call when timing */
+
+/* What image_check() needs from the target. */
+char _stext;
+char _eimage;
+
+unsigned long long ullGetRunTimeCycles(void)
+{
+	return 0;
+}
+
+void lprintf(const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	vprintf(fmt, ap);
+	va_end(ap);
+}
+
+/****************************************************************************/
+
+/*
+ * The CRC a bit at a time, the reflected polynomial.
+ */
+static uint32_t crc32_bitwise(uint32_t crc, const void *buf, int len)
+{
+	const uint8_t *p = buf;
+	int k;
+
+	crc = ~crc;
+	while (len-- > 0) {
+		crc ^= *p++;
+		for (k = 0; k < 8; k++)
+			crc = (crc >> 1) ^ ((crc & 1) ? 0xedb88320UL : 0);
+	}
+	return ~crc;
+}
+
+static double seconds(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Time a CRC over the buffer, returns MB/s.
+ */
+static double timed(uint32_t (*fn)(uint32_t, const void *, int),
+	const uint8_t *buf, unsigned long mbytes, uint32_t *crc)
+{
+	unsigned long n;
+	double t;
+
+	*crc = 0;
+	t = seconds();
+	for (n = 0; n < mbytes * (1024 * 1024 / BLOCK); n++)
+		*crc = fn(*crc, buf, BLOCK);
+	t = seconds() - t;
+	return (t > 0) ? mbytes / t : 0;
+}
+
+/****************************************************************************/
+
+int main(int argc, char *argv[])
+{
+	unsigned long mbytes = (argc > 1) ? strtoul(argv[1], NULL, 0) : 16;
+	static uint32_t words[(MAX_LEN + 8) / 4];
+	static uint8_t block[BLOCK];
+	uint8_t *data = (uint8_t *)words;
+	uint32_t crc, ref;
+	double fast, slow;
+	int align, len, split;
+
+	CHECK(crc32(0, "123456789", 9) == 0xcbf43926UL);
+	CHECK(crc32_bitwise(0, "123456789", 9) == 0xcbf43926UL);
+	CHECK(crc32(0, "", 0) == 0);
+
+	for (len = 0; len < sizeof(words); len++)
+		data[len] = (uint8_t)(len * 7 + 1);
+
+	for (align = 0; align < 4; align++) {
+		for (len = 0; len <= MAX_LEN; len++) {
+			ref = crc32_bitwise(0, data + align, len);
+			CHECK(crc32(0, data + align, len) == ref);
+
+			/* Carried over a split at every odd place. */
+			for (split = 1; split < len; split += 2) {
+				crc = crc32(0, data + align, split);
+				crc = crc32(crc, data + align + split,
+					len - split);
+				CHECK(crc == ref);
+				if (check_failed)
+					break;
+			}
+			if (check_failed) {
+				fprintf(stderr, "crc32: align %d len %d\n",
+					align, len);
+				return CHECK_DONE("crc32");
+			}
+		}
+	}
+
+	for (len = 0; len < BLOCK; len++)
+		block[len] = (uint8_t)rand();
+	fast = timed(crc32, block, mbytes, &crc);
+	slow = timed(crc32_bitwise, block, mbytes, &ref);
+	CHECK(crc == ref);
+	printf("crc32: %lu MB, tables %.0f MB/s, bitwise %.0f MB/s\n",
+	       mbytes, fast, slow);
+
+	return CHECK_DONE("crc32");
+}
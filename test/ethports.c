@@ -0,0 +1,131 @@
+/*
+ * ethports.c - Host test of the per port paths of ETHIsr.c, built with
+ * MAX_ETH_PORTS 2 against a simulated second controller (stubs/).
+ *
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ */
+
+#include "../src/quick/ETHIsr.c"
+
+#include "check.h"
+
+int check_failed;
+
+struct permcfg_s permcfg;
+
+static int eth_isr_calls;
+
+void latency_eth_isr(void)
+{
+	eth_isr_calls++;
+}
+
+/****************************************************************************/
+
+/*
+ * The ports get consecutive MAC addresses, carrying into the device part.
+ */
+static void test_mac(const unsigned char *base, const unsigned char *port1)
+{
+	unsigned char mac[ETH_HWADDR_LEN];
+
+	memcpy(permcfg.mac, base, ETH_HWADDR_LEN);
+	CHECK(ETHServiceTaskInit(0) == 0);
+	CHECK(ETHServiceTaskInit(1) == 0);
+
+	CHECK(ETHServiceTaskMACAddress(0, mac) == 0);
+	CHECK(memcmp(mac, base, ETH_HWADDR_LEN) == 0);
+	CHECK(ETHServiceTaskMACAddress(1, mac) == 0);
+	CHECK(memcmp(mac, port1, ETH_HWADDR_LEN) == 0);
+}
+
+/*
+ * An interrupt posts its events on its own port and wakes that port's
+ * waiters only.
+ */
+static void test_events(void)
+{
+	unsigned long port;
+	unsigned long other;
+	int waiter;
+
+	for (port = 0; port < MAX_ETH_PORTS; port++) {
+		other = !port;
+		ETHEvents[0] = ETHEvents[1] = 0;
+		for (waiter = 0; waiter < ethWaitInvalid; waiter++) {
+			while (xSemaphoreTake(ETHWaitSemaphore[0][waiter], 0))
+				;
+			while (xSemaphoreTake(ETHWaitSemaphore[1][waiter], 0))
+				;
+		}
+		EthernetIntEnable(ETHServiceTaskBase(port),
+				  ETH_INT_RX | ETH_INT_PHY);
+		EthernetIntEnable(ETHServiceTaskBase(other),
+				  ETH_INT_RX | ETH_INT_PHY);
+
+		test_eth(ETHServiceTaskBase(port))->status =
+			ETH_INT_RX | ETH_INT_PHY;
+		eth_isr_calls = 0;
+		if (port == 0)
+			ETH0IntHandler();
+		else
+			ETH1IntHandler();
+
+		CHECK(eth_isr_calls == 1);
+		CHECK(test_eth(ETHServiceTaskBase(port))->status == 0);
+		CHECK((test_eth(ETHServiceTaskBase(port))->mask &
+		       (ETH_INT_RX | ETH_INT_PHY)) == 0);
+		CHECK((test_eth(ETHServiceTaskBase(other))->mask &
+		       (ETH_INT_RX | ETH_INT_PHY)) ==
+		      (ETH_INT_RX | ETH_INT_PHY));
+
+		CHECK(test_sem_count(ETHWaitSemaphore[port][ethWaitRx]) == 1);
+		CHECK(test_sem_count(ETHWaitSemaphore[port][ethWaitPhy]) == 1);
+		CHECK(test_sem_count(ETHWaitSemaphore[port][ethWaitTx]) == 0);
+		for (waiter = 0; waiter < ethWaitInvalid; waiter++)
+			CHECK(test_sem_count(ETHWaitSemaphore[other][waiter])
+			      == 0);
+
+		CHECK(ETHServiceTaskWaitEvent(other, ethWaitRx, 0) == 0);
+		CHECK(ETHServiceTaskWaitEvent(other, ethWaitPhy, 0) == 0);
+		CHECK(ETHServiceTaskWaitEvent(port, ethWaitTx, 0) == 0);
+		CHECK(ETHServiceTaskWaitEvent(port, ethWaitRx, 0) ==
+		      ETH_EV_RX);
+		CHECK(ETHServiceTaskWaitEvent(port, ethWaitPhy, 0) ==
+		      ETH_EV_PHY);
+		CHECK(ETHEvents[port] == 0);
+		CHECK(test_critical == 0);
+	}
+}
+
+int main(void)
+{
+	static const struct {
+		unsigned char base[ETH_HWADDR_LEN];
+		unsigned char port1[ETH_HWADDR_LEN];
+	} macs[] = {
+		{ { 0x00, 0x1a, 0xb6, 0x00, 0x12, 0x34 },
+		  { 0x00, 0x1a, 0xb6, 0x00, 0x12, 0x35 } },
+		{ { 0x00, 0x1a, 0xb6, 0x00, 0x12, 0xff },
+		  { 0x00, 0x1a, 0xb6, 0x00, 0x13, 0x00 } },
+		{ { 0x00, 0x1a, 0xb6, 0x00, 0xff, 0xff },
+		  { 0x00, 0x1a, 0xb6, 0x01, 0x00, 0x00 } },
+		/* The OUI stays, the device part wraps. */
+		{ { 0x00, 0x1a, 0xb6, 0xff, 0xff, 0xff },
+		  { 0x00, 0x1a, 0xb6, 0x00, 0x00, 0x00 } },
+	};
+	unsigned j;
+
+	CHECK(MAX_ETH_PORTS == 2);
+	CHECK(ETHServiceTaskInit(MAX_ETH_PORTS) == -1);
+	CHECK(ETHServiceTaskBase(0) == ETH_BASE);
+	CHECK(ETHServiceTaskBase(1) == ETH1_BASE);
+	CHECK(ETHServiceTaskBase(MAX_ETH_PORTS) == 0);
+
+	for (j = 0; j < sizeof(macs) / sizeof(macs[0]); j++)
+		test_mac(macs[j].base, macs[j].port1);
+
+	test_events();
+
+	return CHECK_DONE("ethports");
+}
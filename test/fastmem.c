@@ -0,0 +1,50 @@
+/*
+ * fastmem.c - Host test of fastmem.c: fastmem_selftest() over every
+ * source and destination misalignment and every length up to
+ * FASTMEM_BENCH_MAX (or the length given).  The host build has no
+ * bursts, the target runs those through /mem_selftest.
+ *
+ *	fastmem [max_len]
+ *
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ */
+
+#include <stdlib.h>
+
+#include "FreeRTOS.h"
+#include "fastmem.h"
+#include "timerconfig.h"
+
+#include "check.h"
+
+int check_failed;
+
+void *pvPortMalloc(size_t xWantedSize)
+{
+	return malloc(xWantedSize);
+}
+
+void vPortFree(void *pv)
+{
+	free(pv);
+}
+
+unsigned long long ullGetRunTimeCycles(void)
+{
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	size_t max_len = (argc > 1) ? strtoul(argv[1], NULL, 0) :
+		FASTMEM_BENCH_MAX;
+	int errors;
+
+	errors = fastmem_selftest(max_len);
+	printf("fastmem: lengths 0 .. %lu, %d wrong\n",
+	       (unsigned long)max_len, errors);
+	CHECK(errors == 0);
+	CHECK(fastmem_selftest(FASTMEM_BENCH_MAX + 1) == -1);
+
+	return CHECK_DONE("fastmem");
+}
@@ -0,0 +1,275 @@
+/*
+ * heapsoak.c - Host soak test of heap_quick.c: random allocations and
+ * frees, the heap's invariants checked after every call.
+ *
+ *	heapsoak [calls [seed]]
+ *
+ * After each call:
+ * - the free list is in address order, inside the heap, its blocks
+ *   aligned, at least MIN_BLOCK and never adjacent (they'd be merged);
+ * - each quick list block has its list's size;
+ * - the blocks in use, on the free list and on the quick lists tile the
+ *   heap exactly, none overlap or go missing;
+ * - the counters add up, and heap_stats_get() agrees with the lists.
+ * At the end everything is freed, and the heap has to merge back into
+ * one block.
+ *
+ * Copyright (C) 2011 Consolidated Resource Imaging LLC
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/quick/heap_quick.c"
+
+#include "check.h"
+
+int check_failed;
+
+#define LIVE		256		/* allocations held at once */
+#define GRANULE		portBYTE_ALIGNMENT
+#define GRANULES	(sizeof(heap.bytes) / GRANULE)
+
+/* Block starts, by granule of the heap. */
+enum { kNone, kUsed, kFree, kQuick };
+static unsigned char kind[GRANULES];
+
+static struct {
+	unsigned char *p;
+	size_t want;
+} live[LIVE];
+
+static unsigned long rand_state;
+
+/****************************************************************************/
+
+static unsigned long next_rand(void)
+{
+	/* xorshift, the same on every host */
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 17;
+	rand_state ^= rand_state << 5;
+	return rand_state & 0xffffffffUL;
+}
+
+/*
+ * Mostly the small sizes of the kernel objects, some lwIP sized ones,
+ * now and then more than the heap has.
+ */
+static size_t rand_size(void)
+{
+	unsigned long r = next_rand();
+
+	switch (r % 16) {
+	case 0:
+		return 0;
+	case 1:
+		return configTOTAL_HEAP_SIZE + (r >> 8) % 64;
+	case 2: case 3: case 4: case 5:
+		return 129 + (r >> 8) % 2000;
+	default:
+		return 1 + (r >> 8) % HEAP_QUICK_MAX;
+	}
+}
+
+static unsigned char *heap_start(void)
+{
+	return (unsigned char *)ALIGN_UP((size_t)heap.bytes);
+}
+
+static size_t granule(const void *blk)
+{
+	return ((const unsigned char *)blk - heap.bytes) / GRANULE;
+}
+
+static int in_heap(const void *blk)
+{
+	return ((const unsigned char *)blk >= heap_start()) &&
+		((const unsigned char *)blk < heap.bytes + sizeof(heap.bytes));
+}
+
+/* Mark a block start, it must not be marked already. */
+static int mark(const struct block_s *blk, int k)
+{
+	if (!in_heap(blk) || ((size_t)blk & portBYTE_ALIGNMENT_MASK) ||
+	    (kind[granule(blk)] != kNone))
+		return 0;
+	kind[granule(blk)] = k;
+	return 1;
+}
+
+/****************************************************************************/
+
+/*
+ * Check the heap against the allocations held.
+ */
+static void check_heap(size_t used)
+{
+	struct heap_stats_s hs;
+	struct block_s *blk;
+	unsigned char *p;
+	size_t free_sum = 0;
+	size_t quick_sum = 0;
+	size_t largest = 0;
+	unsigned blocks = 0;
+	unsigned marked = 0;
+	unsigned j;
+
+	/* Before the first allocation, this sets the heap up. */
+	heap_stats_get(&hs);
+	CHECK(test_suspended == 0);
+
+	/* The free list. */
+	for (blk = start.next; blk != NULL; blk = blk->next) {
+		CHECK(mark(blk, kFree));
+		CHECK((blk->size >= MIN_BLOCK) &&
+		      !(blk->size & portBYTE_ALIGNMENT_MASK));
+		if (blk->next != NULL) {
+			CHECK(blk < blk->next);
+			CHECK((unsigned char *)blk + blk->size <
+			      (unsigned char *)blk->next);
+		}
+		free_sum += blk->size;
+		if (blk->size > largest)
+			largest = blk->size;
+		blocks++;
+		marked++;
+		if (check_failed)
+			return;
+	}
+
+	/* The quick lists. */
+	for (j = 0; j < QUICK_SLOTS; j++) {
+		for (blk = quick[j]; blk != NULL; blk = blk->next) {
+			CHECK(mark(blk, kQuick));
+			CHECK((blk->size <= HEAP_QUICK_MAX) &&
+			      (QUICK_SLOT(blk->size) == j));
+			quick_sum += blk->size;
+			marked++;
+			if (check_failed)
+				return;
+		}
+	}
+
+	/* The blocks in use. */
+	for (j = 0; j < LIVE; j++) {
+		if (live[j].p == NULL)
+			continue;
+		blk = (struct block_s *)(live[j].p - HDR_SIZE);
+		CHECK(mark(blk, kUsed));
+		CHECK(blk->next == NULL);
+		CHECK(blk->size >= live[j].want + HDR_SIZE);
+		marked++;
+	}
+
+	/* Together they tile the heap. */
+	for (p = heap_start(); p < heap_start() + stats.size;
+			p += ((struct block_s *)p)->size) {
+		if (kind[granule(p)] == kNone) {
+			CHECK(!"a block belongs to nothing");
+			break;
+		}
+		kind[granule(p)] = kNone;
+		marked--;
+	}
+	CHECK(p == heap_start() + stats.size);
+	CHECK(marked == 0);
+	memset(kind, kNone, sizeof(kind));
+
+	/* The counters. */
+	CHECK(stats.quick == quick_sum);
+	CHECK(stats.free == free_sum + quick_sum);
+	CHECK(stats.free + used == stats.size);
+	CHECK(stats.min_free <= stats.free);
+
+	CHECK(hs.size == stats.size);
+	CHECK(hs.free == stats.free);
+	CHECK(hs.min_free == stats.min_free);
+	CHECK(hs.quick == quick_sum);
+	CHECK(hs.blocks == blocks);
+	CHECK(hs.largest == largest);
+}
+
+/*
+ * The user's bytes stay as they were written.
+ */
+static void fill(unsigned j)
+{
+	memset(live[j].p, (unsigned char)j, live[j].want);
+}
+
+static int intact(unsigned j)
+{
+	size_t n;
+
+	for (n = 0; n < live[j].want; n++) {
+		if (live[j].p[n] != (unsigned char)j)
+			return 0;
+	}
+	return 1;
+}
+
+/****************************************************************************/
+
+int main(int argc, char *argv[])
+{
+	unsigned long calls = (argc > 1) ? strtoul(argv[1], NULL, 0) : 5000000;
+	unsigned long n;
+	unsigned long held = 0;
+	size_t used = 0;
+	unsigned j;
+
+	rand_state = (argc > 2) ? strtoul(argv[2], NULL, 0) : 1;
+	if (rand_state == 0)
+		rand_state = 1;
+
+	check_heap(0);
+	for (n = 0; (n < calls) && !check_failed; n++) {
+		j = next_rand() % LIVE;
+		if (live[j].p != NULL) {
+			CHECK(intact(j));
+			used -= ((struct block_s *)(live[j].p - HDR_SIZE))->size;
+			vPortFree(live[j].p);
+			live[j].p = NULL;
+			held--;
+		} else {
+			live[j].want = rand_size();
+			live[j].p = pvPortMalloc(live[j].want);
+			if (live[j].p != NULL) {
+				CHECK(live[j].want != 0);
+				CHECK(((size_t)live[j].p &
+				       portBYTE_ALIGNMENT_MASK) == 0);
+				used += ((struct block_s *)
+					 (live[j].p - HDR_SIZE))->size;
+				fill(j);
+				held++;
+			}
+		}
+		check_heap(used);
+		CHECK(stats.allocs - stats.frees == held);
+	}
+
+	/* The paths a soak has to go through. */
+	CHECK(stats.quick_hits != 0);
+	CHECK(stats.flushes != 0);
+	CHECK(stats.fails != 0);
+
+	/* Free everything, a flush merges the quick lists back. */
+	for (j = 0; j < LIVE; j++) {
+		if (live[j].p != NULL) {
+			CHECK(intact(j));
+			vPortFree(live[j].p);
+			live[j].p = NULL;
+		}
+	}
+	flush_quick();
+	check_heap(0);
+	CHECK((start.next != NULL) && (start.next->next == NULL) &&
+	      (start.next->size == stats.size));
+
+	printf("heapsoak: %lu calls, %lu allocs, %lu quick hits, "
+	       "%lu flushes, %lu fails, min free %lu of %lu\n",
+	       n, stats.allocs, stats.quick_hits, stats.flushes, stats.fails,
+	       (unsigned long)stats.min_free, (unsigned long)stats.size);
+	return CHECK_DONE("heapsoak");
+}
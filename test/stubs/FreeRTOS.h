@@ -0,0 +1,38 @@
+/*
+ * FreeRTOS.h - The kernel types and configuration, as much of them as the
+ * host tests need (see rtos.c).
+ */
+#ifndef FREERTOS_H_
+#define FREERTOS_H_
+
+#include <stddef.h>
+
+typedef unsigned long portTickType;
+#define portBASE_TYPE		long
+typedef unsigned long portSTACK_TYPE;
+typedef void *xTaskHandle;
+
+#define pdFALSE				0
+#define pdTRUE				1
+#define pdPASS				1
+#define portMAX_DELAY			((portTickType)0xffffffff)
+#define portTICK_RATE_MS		((portTickType)1000 / configTICK_RATE_HZ)
+#define portBYTE_ALIGNMENT		8
+#define portBYTE_ALIGNMENT_MASK		0x0007
+#define portEND_SWITCHING_ISR(x)	((void)(x))
+
+#define configCPU_CLOCK_HZ		((unsigned long)50000000)
+#define configTICK_RATE_HZ		((portTickType)1000)
+#define configMAX_PRIORITIES		5
+#define configMAX_TASK_NAME_LEN		12
+#define configUSE_MALLOC_FAILED_HOOK	0
+#ifndef configTOTAL_HEAP_SIZE
+#define configTOTAL_HEAP_SIZE		((size_t)32000)
+#endif
+
+#define SET_SYSCALL_INTERRUPT_PRIORITY(X) (((X) << 5) & 0xE0)
+
+void *pvPortMalloc(size_t xWantedSize);
+void vPortFree(void *pv);
+
+#endif /* FREERTOS_H_ */
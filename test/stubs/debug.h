@@ -0,0 +1,9 @@
+/*
+ * debug.h - Nothing the host tests need.
+ */
+#ifndef DEBUG_H_
+#define DEBUG_H_
+
+#define ASSERT(expr)
+
+#endif /* DEBUG_H_ */
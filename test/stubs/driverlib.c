@@ -0,0 +1,155 @@
+/*
+ * driverlib.c - The StellarisWare calls of the host tests.  Two Ethernet
+ * controllers: the one the parts have and a simulated second one.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "hw_types.h"
+#include "hw_memmap.h"
+#include "ethernet.h"
+#include "gpio.h"
+#include "interrupt.h"
+#include "sysctl.h"
+
+volatile unsigned long test_hwreg_bit;
+
+static struct test_eth_s eth[] = {
+	{ .base = ETH_BASE },
+	{ .base = ETH1_BASE },
+};
+
+/****************************************************************************/
+
+struct test_eth_s *test_eth(unsigned long ulBase)
+{
+	unsigned j;
+
+	for (j = 0; j < sizeof(eth) / sizeof(eth[0]); j++) {
+		if (eth[j].base == ulBase)
+			return &eth[j];
+	}
+	return NULL;
+}
+
+/* A controller the driver uses must exist. */
+static struct test_eth_s *get(unsigned long ulBase)
+{
+	struct test_eth_s *te = test_eth(ulBase);
+
+	if (te == NULL)
+		abort();
+	return te;
+}
+
+/****************************************************************************/
+
+unsigned long EthernetIntStatus(unsigned long ulBase, tBoolean bMasked)
+{
+	struct test_eth_s *te = get(ulBase);
+
+	return bMasked ? (te->status & te->mask) : te->status;
+}
+
+void EthernetIntClear(unsigned long ulBase, unsigned long ulIntFlags)
+{
+	get(ulBase)->status &= ~ulIntFlags;
+}
+
+void EthernetIntEnable(unsigned long ulBase, unsigned long ulIntFlags)
+{
+	get(ulBase)->mask |= ulIntFlags;
+}
+
+void EthernetIntDisable(unsigned long ulBase, unsigned long ulIntFlags)
+{
+	get(ulBase)->mask &= ~ulIntFlags;
+}
+
+void EthernetInitExpClk(unsigned long ulBase, unsigned long ulEthClk)
+{
+	(void)ulEthClk;
+	get(ulBase);
+}
+
+void EthernetConfigSet(unsigned long ulBase, unsigned long ulConfig)
+{
+	(void)ulConfig;
+	get(ulBase);
+}
+
+void EthernetPHYWrite(unsigned long ulBase, unsigned char ucRegAddr,
+		unsigned long ulData)
+{
+	(void)ucRegAddr;
+	(void)ulData;
+	get(ulBase);
+}
+
+void EthernetEnable(unsigned long ulBase)
+{
+	get(ulBase)->enabled = 1;
+}
+
+void EthernetDisable(unsigned long ulBase)
+{
+	get(ulBase)->enabled = 0;
+}
+
+void EthernetMACAddrSet(unsigned long ulBase, unsigned char *pucMACAddr)
+{
+	memcpy(get(ulBase)->mac, pucMACAddr, sizeof(eth[0].mac));
+}
+
+void EthernetMACAddrGet(unsigned long ulBase, unsigned char *pucMACAddr)
+{
+	memcpy(pucMACAddr, get(ulBase)->mac, sizeof(eth[0].mac));
+}
+
+/****************************************************************************/
+
+void GPIOPinTypeEthernetLED(unsigned long ulPort, unsigned char ucPins)
+{
+	(void)ulPort;
+	(void)ucPins;
+}
+
+void IntEnable(unsigned long ulInterrupt)
+{
+	(void)ulInterrupt;
+}
+
+void IntDisable(unsigned long ulInterrupt)
+{
+	(void)ulInterrupt;
+}
+
+void IntPrioritySet(unsigned long ulInterrupt, unsigned char ucPriority)
+{
+	(void)ulInterrupt;
+	(void)ucPriority;
+}
+
+/****************************************************************************/
+
+tBoolean SysCtlPeripheralPresent(unsigned long ulPeripheral)
+{
+	return (ulPeripheral == SYSCTL_PERIPH_ETH) ||
+		(ulPeripheral == SYSCTL_PERIPH_ETH1);
+}
+
+void SysCtlPeripheralEnable(unsigned long ulPeripheral)
+{
+	(void)ulPeripheral;
+}
+
+void SysCtlPeripheralReset(unsigned long ulPeripheral)
+{
+	(void)ulPeripheral;
+}
+
+unsigned long SysCtlClockGet(void)
+{
+	return 50000000;
+}
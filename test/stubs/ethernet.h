@@ -0,0 +1,49 @@
+/*
+ * ethernet.h - Ethernet controllers for the host tests (driverlib.c).
+ */
+#ifndef ETHERNET_H_
+#define ETHERNET_H_
+
+#include "hw_types.h"
+
+#define ETH_INT_PHY		0x040
+#define ETH_INT_MDIO		0x020
+#define ETH_INT_RXER		0x010
+#define ETH_INT_RXOF		0x008
+#define ETH_INT_TX		0x004
+#define ETH_INT_TXER		0x002
+#define ETH_INT_RX		0x001
+
+#define ETH_CFG_TX_DPLXEN	0x000010
+#define ETH_CFG_TX_CRCEN	0x000004
+#define ETH_CFG_TX_PADEN	0x000002
+#define ETH_CFG_RX_AMULEN	0x000400
+
+unsigned long EthernetIntStatus(unsigned long ulBase, tBoolean bMasked);
+void EthernetIntClear(unsigned long ulBase, unsigned long ulIntFlags);
+void EthernetIntEnable(unsigned long ulBase, unsigned long ulIntFlags);
+void EthernetIntDisable(unsigned long ulBase, unsigned long ulIntFlags);
+void EthernetInitExpClk(unsigned long ulBase, unsigned long ulEthClk);
+void EthernetConfigSet(unsigned long ulBase, unsigned long ulConfig);
+void EthernetPHYWrite(unsigned long ulBase, unsigned char ucRegAddr,
+		unsigned long ulData);
+void EthernetEnable(unsigned long ulBase);
+void EthernetDisable(unsigned long ulBase);
+void EthernetMACAddrSet(unsigned long ulBase, unsigned char *pucMACAddr);
+void EthernetMACAddrGet(unsigned long ulBase, unsigned char *pucMACAddr);
+
+/*
+ * The simulated controllers.
+ */
+struct test_eth_s {
+	unsigned long base;
+	unsigned long status;		/* raised interrupts */
+	unsigned long mask;		/* enabled interrupts */
+	int enabled;
+	unsigned char mac[6];
+};
+
+/* The controller at a base address, NULL if there is none. */
+struct test_eth_s *test_eth(unsigned long ulBase);
+
+#endif /* ETHERNET_H_ */
@@ -0,0 +1,7 @@
+/*
+ * flash.h - Nothing the host tests need.
+ */
+#ifndef FLASH_H_
+#define FLASH_H_
+
+#endif /* FLASH_H_ */
@@ -0,0 +1,16 @@
+/*
+ * gpio.h - GPIO for the host tests (driverlib.c).
+ */
+#ifndef GPIO_H_
+#define GPIO_H_
+
+#define GPIO_PIN_0		0x00000001
+#define GPIO_PIN_1		0x00000002
+#define GPIO_PIN_2		0x00000004
+#define GPIO_PIN_3		0x00000008
+
+#define ETH1_GPIO_PINS		(GPIO_PIN_0 | GPIO_PIN_1)	/* simulated */
+
+void GPIOPinTypeEthernetLED(unsigned long ulPort, unsigned char ucPins);
+
+#endif /* GPIO_H_ */
@@ -0,0 +1,23 @@
+/*
+ * hw_ethernet.h - Ethernet registers for the host tests (LM3S8962 PHY).
+ */
+#ifndef HW_ETHERNET_H_
+#define HW_ETHERNET_H_
+
+#define MAC_O_IACK		0x00000000
+#define MAC_O_RCTL		0x00000008
+#define MAC_O_NP		0x00000034
+#define MAC_O_TR		0x00000038
+#define MAC_NP_NPR_M		0x0000003F
+#define MAC_TR_NEWTX		0x00000001
+
+#define PHY_MR1			0x00000001
+#define PHY_MR1_LINK		0x00000004
+#define PHY_MR17		0x00000011
+#define PHY_MR17_ANEGCOMP_IE	0x00004000
+#define PHY_MR17_LSCHG_IE	0x00000400
+#define PHY_MR18		0x00000012
+#define PHY_MR18_DPLX		0x00000800
+#define PHY_MR18_RATE		0x00000400
+
+#endif /* HW_ETHERNET_H_ */
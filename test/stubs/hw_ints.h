@@ -0,0 +1,10 @@
+/*
+ * hw_ints.h - Interrupts for the host tests.
+ */
+#ifndef HW_INTS_H_
+#define HW_INTS_H_
+
+#define INT_ETH			58
+#define INT_ETH1		70	/* simulated */
+
+#endif /* HW_INTS_H_ */
@@ -0,0 +1,16 @@
+/*
+ * hw_memmap.h - Base addresses for the host tests.  The second Ethernet
+ * controller (ETH1_*) is simulated, driverlib.c.
+ */
+#ifndef HW_MEMMAP_H_
+#define HW_MEMMAP_H_
+
+#define GPIO_PORTF_BASE		0x40025000
+#define GPIO_PORTG_BASE		0x40026000
+#define TIMER1_BASE		0x40031000
+#define ETH_BASE		0x40048000
+
+#define ETH1_BASE		0x40049000
+#define ETH1_GPIO_BASE		GPIO_PORTG_BASE
+
+#endif /* HW_MEMMAP_H_ */
@@ -0,0 +1,25 @@
+/*
+ * hw_types.h - Register access for the host tests.
+ */
+#ifndef HW_TYPES_H_
+#define HW_TYPES_H_
+
+typedef unsigned char tBoolean;
+
+#ifndef true
+#define true	1
+#endif
+#ifndef false
+#define false	0
+#endif
+
+#define HWREG(x)	(*((volatile unsigned long *)(x)))
+
+/*
+ * The bit-band alias has no host equivalent: every bit goes to one word.
+ * The paths the tests run don't go through it.
+ */
+extern volatile unsigned long test_hwreg_bit;
+#define HWREGBITW(x, b)	test_hwreg_bit
+
+#endif /* HW_TYPES_H_ */
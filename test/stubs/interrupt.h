@@ -0,0 +1,11 @@
+/*
+ * interrupt.h - Interrupt controller for the host tests (driverlib.c).
+ */
+#ifndef INTERRUPT_H_
+#define INTERRUPT_H_
+
+void IntEnable(unsigned long ulInterrupt);
+void IntDisable(unsigned long ulInterrupt);
+void IntPrioritySet(unsigned long ulInterrupt, unsigned char ucPriority);
+
+#endif /* INTERRUPT_H_ */
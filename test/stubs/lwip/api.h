@@ -0,0 +1,4 @@
+/*
+ * lwip/api.h - See lwip/init.h.
+ */
+#include "lwip/init.h"
@@ -0,0 +1,16 @@
+/*
+ * lwip/init.h - As much of lwIP as LWIPStack.h needs in the host tests.
+ */
+#ifndef LWIP_INIT_H_
+#define LWIP_INIT_H_
+
+typedef signed char err_t;
+
+struct pbuf;
+
+struct netif {
+	void *state;
+	unsigned char hwaddr[6];
+};
+
+#endif /* LWIP_INIT_H_ */
@@ -0,0 +1,4 @@
+/*
+ * lwip/netifapi.h - See lwip/init.h.
+ */
+#include "lwip/init.h"
@@ -0,0 +1,9 @@
+/*
+ * queue.h - Nothing the host tests need.
+ */
+#ifndef QUEUE_H_
+#define QUEUE_H_
+
+#include "FreeRTOS.h"
+
+#endif /* QUEUE_H_ */
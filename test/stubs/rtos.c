@@ -0,0 +1,83 @@
+/*
+ * rtos.c - The kernel calls of the host tests: one thread, nothing is
+ * ever switched or blocked.
+ */
+
+#include <stdlib.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+struct test_sem_s {
+	unsigned max;
+	unsigned count;
+};
+
+int test_suspended;
+int test_critical;
+
+/****************************************************************************/
+
+void vTaskSuspendAll(void)
+{
+	test_suspended++;
+}
+
+signed portBASE_TYPE xTaskResumeAll(void)
+{
+	test_suspended--;
+	return pdFALSE;
+}
+
+void vTaskDelay(portTickType xTicksToDelay)
+{
+	(void)xTicksToDelay;
+}
+
+/****************************************************************************/
+
+xSemaphoreHandle xSemaphoreCreateCounting(unsigned max, unsigned count)
+{
+	xSemaphoreHandle sem = malloc(sizeof(*sem));
+
+	if (sem != NULL) {
+		sem->max = max;
+		sem->count = count;
+	}
+	return sem;
+}
+
+xSemaphoreHandle xSemaphoreCreateMutex(void)
+{
+	return xSemaphoreCreateCounting(1, 1);
+}
+
+portBASE_TYPE xSemaphoreTake(xSemaphoreHandle sem, portTickType xTicks)
+{
+	(void)xTicks;
+	if (sem->count == 0)
+		return pdFALSE;
+	sem->count--;
+	return pdTRUE;
+}
+
+portBASE_TYPE xSemaphoreGive(xSemaphoreHandle sem)
+{
+	if (sem->count == sem->max)
+		return pdFALSE;
+	sem->count++;
+	return pdTRUE;
+}
+
+portBASE_TYPE xSemaphoreGiveFromISR(xSemaphoreHandle sem,
+		portBASE_TYPE *pxHigherPriorityTaskWoken)
+{
+	*pxHigherPriorityTaskWoken = pdTRUE;
+	return xSemaphoreGive(sem);
+}
+
+unsigned test_sem_count(xSemaphoreHandle sem)
+{
+	return sem->count;
+}
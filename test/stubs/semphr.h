@@ -0,0 +1,22 @@
+/*
+ * semphr.h - Semaphores of the host tests (rtos.c).  Nothing blocks: a
+ * take that would wait returns pdFALSE, as on a timeout.
+ */
+#ifndef SEMPHR_H_
+#define SEMPHR_H_
+
+#include "FreeRTOS.h"
+
+typedef struct test_sem_s *xSemaphoreHandle;
+
+xSemaphoreHandle xSemaphoreCreateCounting(unsigned max, unsigned count);
+xSemaphoreHandle xSemaphoreCreateMutex(void);
+portBASE_TYPE xSemaphoreTake(xSemaphoreHandle sem, portTickType xTicks);
+portBASE_TYPE xSemaphoreGive(xSemaphoreHandle sem);
+portBASE_TYPE xSemaphoreGiveFromISR(xSemaphoreHandle sem,
+		portBASE_TYPE *pxHigherPriorityTaskWoken);
+
+/* The count, for the tests. */
+unsigned test_sem_count(xSemaphoreHandle sem);
+
+#endif /* SEMPHR_H_ */
@@ -0,0 +1,21 @@
+/*
+ * sysctl.h - System control for the host tests (driverlib.c).
+ */
+#ifndef SYSCTL_H_
+#define SYSCTL_H_
+
+#include "hw_types.h"
+
+#define SYSCTL_PERIPH_ETH	0x10005000
+#define SYSCTL_PERIPH_GPIOF	0x20000020
+#define SYSCTL_PERIPH_GPIOG	0x20000040
+
+#define SYSCTL_PERIPH_ETH1	0x10005001	/* simulated */
+#define ETH1_GPIO_PERIPH	SYSCTL_PERIPH_GPIOG
+
+tBoolean SysCtlPeripheralPresent(unsigned long ulPeripheral);
+void SysCtlPeripheralEnable(unsigned long ulPeripheral);
+void SysCtlPeripheralReset(unsigned long ulPeripheral);
+unsigned long SysCtlClockGet(void);
+
+#endif /* SYSCTL_H_ */
@@ -0,0 +1,20 @@
+/*
+ * task.h - The task calls of the host tests (rtos.c).
+ */
+#ifndef TASK_H_
+#define TASK_H_
+
+#include "FreeRTOS.h"
+
+/* Nesting, for the tests to check that the calls pair up. */
+extern int test_suspended;
+extern int test_critical;
+
+#define taskENTER_CRITICAL()		(test_critical++)
+#define taskEXIT_CRITICAL()		(test_critical--)
+
+void vTaskSuspendAll(void);
+signed portBASE_TYPE xTaskResumeAll(void);
+void vTaskDelay(portTickType xTicksToDelay);
+
+#endif /* TASK_H_ */